@@ -0,0 +1,242 @@
+/*****************************************************************************\
+ *  sim_clock.c - Run Slurm daemons and commands on an accelerated clock
+ *****************************************************************************
+ *  Copyright (C) 2019 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+/*
+ * Preload this library (LD_PRELOAD) into slurmctld, slurmd and the commands
+ * of a test cluster so that they all observe the same simulated wall clock:
+ *
+ *   sim_time = SIM_CLOCK_START + (real_time - SIM_CLOCK_ANCHOR) *
+ *		SIM_CLOCK_SPEEDUP
+ *
+ * SIM_CLOCK_ANCHOR is a real epoch time in seconds and must be identical for
+ * every process, SIM_CLOCK_START defaults to the anchor. Sleeps and timed
+ * condition waits are shortened by the same factor, so a job running
+ * "sleep 3600" with SIM_CLOCK_SPEEDUP=60 completes after one real minute.
+ * Work that takes real CPU time (e.g. a backfill cycle) appears SPEEDUP
+ * times longer in simulated time. Network and poll() timeouts are not
+ * scaled. Without SIM_CLOCK_SPEEDUP the library has no effect.
+ */
+
+#define _GNU_SOURCE
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NSEC_IN_USEC 1000LL
+#define USEC_IN_SEC 1000000LL
+
+static int (*real_clock_gettime)(clockid_t, struct timespec *) = NULL;
+static int (*real_clock_nanosleep)(clockid_t, int, const struct timespec *,
+				   struct timespec *) = NULL;
+static int (*real_cond_timedwait)(pthread_cond_t *, pthread_mutex_t *,
+				  const struct timespec *) = NULL;
+static int (*real_nanosleep)(const struct timespec *, struct timespec *) = NULL;
+
+static double speedup = 0.0;		/* 0 if clock is not simulated */
+static int64_t anchor_usec = 0;		/* real time of simulation anchor */
+static int64_t start_usec = 0;		/* simulated time at anchor */
+
+static void *_real_sym(const char *name)
+{
+	void *sym = NULL;
+
+#if defined(__GLIBC__) && defined(__x86_64__)
+	/* dlsym() would return the pre-NPTL compatibility version */
+	if (!strcmp(name, "pthread_cond_timedwait"))
+		sym = dlvsym(RTLD_NEXT, name, "GLIBC_2.3.2");
+#endif
+	if (!sym)
+		sym = dlsym(RTLD_NEXT, name);
+	return sym;
+}
+
+static int64_t _ts2usec(const struct timespec *ts)
+{
+	return (ts->tv_sec * USEC_IN_SEC) + (ts->tv_nsec / NSEC_IN_USEC);
+}
+
+static void _usec2ts(int64_t usec, struct timespec *ts)
+{
+	if (usec < 0)
+		usec = 0;
+	ts->tv_sec = usec / USEC_IN_SEC;
+	ts->tv_nsec = (usec % USEC_IN_SEC) * NSEC_IN_USEC;
+}
+
+static int64_t _real_usec(void)
+{
+	struct timespec ts;
+
+	(void) real_clock_gettime(CLOCK_REALTIME, &ts);
+	return _ts2usec(&ts);
+}
+
+static int64_t _sim_usec(void)
+{
+	return start_usec + (int64_t) ((_real_usec() - anchor_usec) * speedup);
+}
+
+/* Convert an absolute simulated time to the real time it will occur */
+static int64_t _sim2real_usec(int64_t sim_usec)
+{
+	return anchor_usec + (int64_t) ((sim_usec - start_usec) / speedup);
+}
+
+__attribute__((constructor))
+static void _sim_clock_init(void)
+{
+	char *env;
+
+	real_clock_gettime = _real_sym("clock_gettime");
+	real_clock_nanosleep = _real_sym("clock_nanosleep");
+	real_cond_timedwait = _real_sym("pthread_cond_timedwait");
+	real_nanosleep = _real_sym("nanosleep");
+
+	if (!(env = getenv("SIM_CLOCK_SPEEDUP")) ||
+	    ((speedup = strtod(env, NULL)) <= 0.0)) {
+		speedup = 0.0;
+		return;
+	}
+	if ((env = getenv("SIM_CLOCK_ANCHOR")))
+		anchor_usec = strtoll(env, NULL, 10) * USEC_IN_SEC;
+	else
+		anchor_usec = _real_usec();
+	if ((env = getenv("SIM_CLOCK_START")))
+		start_usec = strtoll(env, NULL, 10) * USEC_IN_SEC;
+	else
+		start_usec = anchor_usec;
+}
+
+extern int clock_gettime(clockid_t clk_id, struct timespec *tp)
+{
+	if ((speedup == 0.0) ||
+	    ((clk_id != CLOCK_REALTIME) && (clk_id != CLOCK_REALTIME_COARSE)))
+		return real_clock_gettime(clk_id, tp);
+	_usec2ts(_sim_usec(), tp);
+	return 0;
+}
+
+extern int gettimeofday(struct timeval *tv, void *tz)
+{
+	struct timespec ts;
+
+	(void) clock_gettime(CLOCK_REALTIME, &ts);
+	tv->tv_sec = ts.tv_sec;
+	tv->tv_usec = ts.tv_nsec / NSEC_IN_USEC;
+	if (tz)
+		memset(tz, 0, sizeof(struct timezone));
+	return 0;
+}
+
+extern time_t time(time_t *tloc)
+{
+	struct timespec ts;
+
+	(void) clock_gettime(CLOCK_REALTIME, &ts);
+	if (tloc)
+		*tloc = ts.tv_sec;
+	return ts.tv_sec;
+}
+
+extern int nanosleep(const struct timespec *req, struct timespec *rem)
+{
+	struct timespec real_req;
+
+	if ((speedup == 0.0) || !req)
+		return real_nanosleep(req, rem);
+	_usec2ts((int64_t) (_ts2usec(req) / speedup), &real_req);
+	if (rem)
+		memset(rem, 0, sizeof(struct timespec));
+	return real_nanosleep(&real_req, NULL);
+}
+
+extern int clock_nanosleep(clockid_t clk_id, int flags,
+			   const struct timespec *req, struct timespec *rem)
+{
+	struct timespec real_req;
+
+	if ((speedup == 0.0) || !req)
+		return real_clock_nanosleep(clk_id, flags, req, rem);
+	if (!(flags & TIMER_ABSTIME)) {
+		_usec2ts((int64_t) (_ts2usec(req) / speedup), &real_req);
+		if (rem)
+			memset(rem, 0, sizeof(struct timespec));
+		return real_clock_nanosleep(clk_id, flags, &real_req, NULL);
+	}
+	if (clk_id != CLOCK_REALTIME)
+		return real_clock_nanosleep(clk_id, flags, req, rem);
+	_usec2ts(_sim2real_usec(_ts2usec(req)), &real_req);
+	return real_clock_nanosleep(clk_id, flags, &real_req, rem);
+}
+
+extern unsigned int sleep(unsigned int seconds)
+{
+	struct timespec req;
+
+	req.tv_sec = seconds;
+	req.tv_nsec = 0;
+	(void) nanosleep(&req, NULL);
+	return 0;
+}
+
+extern int usleep(useconds_t usec)
+{
+	struct timespec req;
+
+	_usec2ts(usec, &req);
+	return nanosleep(&req, NULL);
+}
+
+/*
+ * Slurm computes condition variable timeouts from time() or gettimeofday(),
+ * translate them back to the real time at which they expire.
+ */
+extern int pthread_cond_timedwait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+				  const struct timespec *abstime)
+{
+	struct timespec real_abstime;
+
+	if (speedup == 0.0)
+		return real_cond_timedwait(cond, mutex, abstime);
+	_usec2ts(_sim2real_usec(_ts2usec(abstime)), &real_abstime);
+	return real_cond_timedwait(cond, mutex, &real_abstime);
+}
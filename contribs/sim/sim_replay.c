@@ -0,0 +1,545 @@
+/*****************************************************************************\
+ *  sim_replay.c - Replay a job trace against a (simulated) Slurm cluster
+ *****************************************************************************
+ *  Copyright (C) 2019 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+/*
+ * Read a job trace produced by
+ *   sacct -a -X -P --format=JobID,Submit,Timelimit,Elapsed,NCPUS,NNodes,Partition
+ * and submit an equivalent "sleep <Elapsed>" batch job for each record at the
+ * same offset from the start of the replay as it had from the first record.
+ * Once every job has finished, report job wait times, utilization and the
+ * slurmctld scheduling statistics (as shown by sdiag).
+ *
+ * When run under sim_clock.so (see README) together with the daemons, all
+ * times are simulated and durations measured by slurmctld are divided by
+ * SIM_CLOCK_SPEEDUP to report the real time they took.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+#include "slurm/slurm_errno.h"
+#include "src/common/slurm_xlator.h"
+#include "src/common/parse_time.h"
+
+#define JOB_NAME	"sim_replay"
+#define LOCK_SITE_CNT	10
+#define POLL_INTERVAL	60	/* seconds between checks for job completion */
+
+extern char **environ;
+
+typedef struct trace_job {
+	time_t submit;		/* submit time in trace */
+	uint32_t cpus;		/* NCPUS, 0 if not in trace */
+	uint32_t elapsed;	/* run time in seconds */
+	uint32_t job_id;	/* job ID once submitted, 0 on failure */
+	uint32_t nodes;		/* NNodes, 0 if not in trace */
+	char *partition;	/* Partition, NULL if not in trace */
+	uint32_t run_cpus;	/* CPUs allocated in replay */
+	time_t run_end;		/* end time in replay */
+	time_t run_start;	/* start time in replay */
+	time_t run_submit;	/* submit time in replay */
+	uint32_t time_limit;	/* Timelimit in minutes, NO_VAL if unknown */
+	char *trace_id;		/* JobID in trace */
+} trace_job_t;
+
+static double speedup = 1.0;
+
+static void _usage(void)
+{
+	printf("Usage: sim_replay -f <trace> [-n <count>] [-p <partition>] "
+	       "[-i <poll_secs>] [-v]\n");
+}
+
+static int _sort_submit(const void *x, const void *y)
+{
+	const trace_job_t *job1 = x, *job2 = y;
+
+	if (job1->submit < job2->submit)
+		return -1;
+	if (job1->submit > job2->submit)
+		return 1;
+	return 0;
+}
+
+/* Return the index of a column in a sacct -P header line, -1 if absent */
+static int _column(char **names, int cnt, const char *name)
+{
+	int i;
+
+	for (i = 0; i < cnt; i++) {
+		if (!xstrcasecmp(names[i], name))
+			return i;
+	}
+	return -1;
+}
+
+/* Split a sacct -P line in place, return the count of fields */
+static int _split(char *line, char **fields, int max_fields)
+{
+	char *sep;
+	int cnt = 0;
+
+	if ((sep = strpbrk(line, "\r\n")))
+		*sep = '\0';
+	while (cnt < max_fields) {
+		fields[cnt++] = line;
+		if (!(sep = strchr(line, '|')))
+			break;
+		*sep = '\0';
+		line = sep + 1;
+	}
+	return cnt;
+}
+
+static trace_job_t *_read_trace(char *file, int max_jobs, int *job_cnt)
+{
+	FILE *fp;
+	char line[4096], *names[64], *fields[64];
+	int name_cnt, field_cnt, cnt = 0, alloc_cnt = 0;
+	int c_id, c_submit, c_limit, c_elapsed, c_cpus, c_nodes, c_part;
+	trace_job_t *jobs = NULL, *job;
+	int secs;
+
+	if (!(fp = fopen(file, "r"))) {
+		perror(file);
+		exit(1);
+	}
+	if (!fgets(line, sizeof(line), fp)) {
+		fprintf(stderr, "%s: empty trace\n", file);
+		exit(1);
+	}
+	name_cnt = _split(xstrdup(line), names, 64);
+	c_id = _column(names, name_cnt, "JobID");
+	c_submit = _column(names, name_cnt, "Submit");
+	c_limit = _column(names, name_cnt, "Timelimit");
+	c_elapsed = _column(names, name_cnt, "Elapsed");
+	c_cpus = _column(names, name_cnt, "NCPUS");
+	c_nodes = _column(names, name_cnt, "NNodes");
+	c_part = _column(names, name_cnt, "Partition");
+	if ((c_submit < 0) || (c_elapsed < 0)) {
+		fprintf(stderr, "%s: trace needs Submit and Elapsed columns "
+			"(sacct -P output with header)\n", file);
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), fp) &&
+	    ((max_jobs == 0) || (cnt < max_jobs))) {
+		field_cnt = _split(line, fields, 64);
+		if (field_cnt != name_cnt)
+			continue;
+		if ((c_id >= 0) && strchr(fields[c_id], '.'))
+			continue;	/* job step */
+		if (cnt >= alloc_cnt) {
+			alloc_cnt = alloc_cnt ? (alloc_cnt * 2) : 1024;
+			xrealloc(jobs, sizeof(trace_job_t) * alloc_cnt);
+		}
+		job = &jobs[cnt];
+		memset(job, 0, sizeof(trace_job_t));
+		if (!(job->submit = parse_time(fields[c_submit], 0)))
+			continue;
+		if ((secs = time_str2secs(fields[c_elapsed])) < 0)
+			continue;
+		job->elapsed = secs;
+		job->time_limit = NO_VAL;
+		if ((c_limit >= 0) &&
+		    ((secs = time_str2mins(fields[c_limit])) >= 0))
+			job->time_limit = secs;
+		if (c_cpus >= 0)
+			job->cpus = strtoul(fields[c_cpus], NULL, 10);
+		if (c_nodes >= 0)
+			job->nodes = strtoul(fields[c_nodes], NULL, 10);
+		if ((c_part >= 0) && fields[c_part][0])
+			job->partition = xstrdup(fields[c_part]);
+		if (c_id >= 0)
+			job->trace_id = xstrdup(fields[c_id]);
+		cnt++;
+	}
+	fclose(fp);
+	xfree(names[0]);
+
+	qsort(jobs, cnt, sizeof(trace_job_t), _sort_submit);
+	*job_cnt = cnt;
+	return jobs;
+}
+
+static void _submit(trace_job_t *job, char *partition, int env_size)
+{
+	job_desc_msg_t desc;
+	submit_response_msg_t *resp = NULL;
+
+	slurm_init_job_desc_msg(&desc);
+	desc.name = JOB_NAME;
+	desc.comment = job->trace_id;
+	desc.script = xstrdup_printf("#!/bin/sh\nsleep %u\n", job->elapsed);
+	desc.time_limit = job->time_limit;
+	if (job->cpus)
+		desc.min_cpus = job->cpus;
+	if (job->nodes)
+		desc.min_nodes = job->nodes;
+	desc.partition = partition ? partition : job->partition;
+	desc.user_id = getuid();
+	desc.group_id = getgid();
+	desc.work_dir = "/tmp";
+	desc.std_out = "/dev/null";
+	/* Pass sim_clock.so and its settings on to the job */
+	desc.environment = environ;
+	desc.env_size = env_size;
+
+	if (slurm_submit_batch_job(&desc, &resp) != SLURM_SUCCESS) {
+		fprintf(stderr, "submit of trace job %s failed: %s\n",
+			job->trace_id ? job->trace_id : "?",
+			slurm_strerror(slurm_get_errno()));
+	} else {
+		job->job_id = resp->job_id;
+		slurm_free_submit_response_response_msg(resp);
+	}
+	xfree(desc.script);
+}
+
+static int _find_job_id(const void *x, const void *y)
+{
+	uint32_t job_id = *(uint32_t *) x;
+	trace_job_t *job = *(trace_job_t **) y;
+
+	if (job_id < job->job_id)
+		return -1;
+	if (job_id > job->job_id)
+		return 1;
+	return 0;
+}
+
+/*
+ * Load this user's replayed jobs and record their progress in the trace.
+ * Records are saved on every call since finished jobs are purged after
+ * MinJobAge.
+ * by_id IN - submitted trace jobs, in order of increasing job ID
+ * RET count of jobs not yet finished or -1 on error
+ */
+static int _poll_jobs(trace_job_t **by_id, int id_cnt)
+{
+	job_info_msg_t *job_info_msg = NULL;
+	job_info_filter_t filter;
+	slurm_job_info_t *job;
+	trace_job_t **trace;
+	uint32_t *uid;
+	int i, active = 0;
+
+	memset(&filter, 0, sizeof(filter));
+	filter.skip_fields = JOB_FIELD_COMMAND | JOB_FIELD_STD_IO |
+			     JOB_FIELD_NODE_INX | JOB_FIELD_TRES_FMT;
+	filter.name_list = list_create(NULL);
+	list_append(filter.name_list, JOB_NAME);
+	filter.user_list = list_create(NULL);
+	uid = xmalloc(sizeof(uint32_t));
+	*uid = getuid();
+	list_append(filter.user_list, uid);
+
+	if (slurm_load_jobs_filter((time_t) 0, &job_info_msg, SHOW_ALL,
+				   &filter) != SLURM_SUCCESS) {
+		slurm_perror("slurm_load_jobs_filter");
+		active = -1;
+	} else {
+		for (i = 0; i < job_info_msg->record_count; i++) {
+			job = &job_info_msg->job_array[i];
+			if (!IS_JOB_FINISHED(job))
+				active++;
+			trace = bsearch(&job->job_id, by_id, id_cnt,
+					sizeof(trace_job_t *), _find_job_id);
+			if (!trace)
+				continue;
+			(*trace)->run_submit = job->submit_time;
+			(*trace)->run_start = job->start_time;
+			(*trace)->run_end = IS_JOB_FINISHED(job) ?
+					    job->end_time : 0;
+			(*trace)->run_cpus = job->num_cpus;
+		}
+		slurm_free_job_info_msg(job_info_msg);
+	}
+	FREE_NULL_LIST(filter.name_list);
+	FREE_NULL_LIST(filter.user_list);
+	xfree(uid);
+
+	return active;
+}
+
+static int _sort_uint32(const void *x, const void *y)
+{
+	uint32_t a = *(uint32_t *) x, b = *(uint32_t *) y;
+
+	if (a < b)
+		return -1;
+	if (a > b)
+		return 1;
+	return 0;
+}
+
+static void _report_jobs(trace_job_t **by_id, int submitted)
+{
+	trace_job_t *job;
+	node_info_msg_t *node_info_msg = NULL;
+	uint32_t *waits, started = 0, i;
+	uint64_t total_cpus = 0;
+	double wait_sum = 0.0, cpu_secs = 0.0, span;
+	time_t first_submit = 0, last_end = 0;
+
+	waits = xcalloc(submitted + 1, sizeof(uint32_t));
+	for (i = 0; i < submitted; i++) {
+		job = by_id[i];
+		if (!job->run_submit)
+			continue;
+		if (!first_submit || (job->run_submit < first_submit))
+			first_submit = job->run_submit;
+		if (!job->run_start || (job->run_start < job->run_submit))
+			continue;
+		waits[started++] = job->run_start - job->run_submit;
+		wait_sum += job->run_start - job->run_submit;
+		if (job->run_end > job->run_start) {
+			cpu_secs += (double) job->run_cpus *
+				    (job->run_end - job->run_start);
+			last_end = MAX(last_end, job->run_end);
+		}
+	}
+	qsort(waits, started, sizeof(uint32_t), _sort_uint32);
+
+	if (slurm_load_node((time_t) 0, &node_info_msg, SHOW_ALL) ==
+	    SLURM_SUCCESS) {
+		for (i = 0; i < node_info_msg->record_count; i++)
+			total_cpus += node_info_msg->node_array[i].cpus;
+		slurm_free_node_info_msg(node_info_msg);
+	}
+
+	printf("Jobs submitted:   %d\n", submitted);
+	printf("Jobs started:     %u\n", started);
+	if (started) {
+		printf("Wait time (sec):  mean %.0f, median %u, 90%% %u, "
+		       "max %u\n", wait_sum / started, waits[started / 2],
+		       waits[(started * 9) / 10], waits[started - 1]);
+	}
+	span = difftime(last_end, first_submit);
+	if (total_cpus && (span > 0)) {
+		printf("Makespan (sec):   %.0f\n", span);
+		printf("Utilization:      %.1f%% of %"PRIu64" CPUs\n",
+		       (cpu_secs * 100.0) / (total_cpus * span), total_cpus);
+	}
+	xfree(waits);
+}
+
+/* Convert a slurmctld measured duration to real usec */
+static double _real(double usec)
+{
+	return usec / speedup;
+}
+
+static void _report_sched(void)
+{
+	stats_info_request_msg_t req;
+	stats_info_response_msg_t *stats = NULL;
+	uint32_t *order, i, j, tmp;
+
+	req.command_id = STAT_COMMAND_GET;
+	if (slurm_get_statistics(&stats, &req) != SLURM_SUCCESS) {
+		slurm_perror("slurm_get_statistics");
+		return;
+	}
+
+	printf("\nScheduling statistics (real usec)\n");
+	if (stats->schedule_cycle_counter) {
+		printf("Main cycles:      %u, mean %.0f, max %.0f, "
+		       "mean depth %u\n", stats->schedule_cycle_counter,
+		       _real((double) stats->schedule_cycle_sum /
+			     stats->schedule_cycle_counter),
+		       _real(stats->schedule_cycle_max),
+		       stats->schedule_cycle_depth /
+		       stats->schedule_cycle_counter);
+	}
+	if (stats->bf_cycle_counter) {
+		printf("Backfill cycles:  %u, mean %.0f, max %.0f, "
+		       "mean depth %u, jobs backfilled %u\n",
+		       stats->bf_cycle_counter,
+		       _real((double) stats->bf_cycle_sum /
+			     stats->bf_cycle_counter),
+		       _real(stats->bf_cycle_max),
+		       stats->bf_depth_sum / stats->bf_cycle_counter,
+		       stats->bf_backfilled_jobs);
+	}
+
+	/* Lock call sites by hold time, the per-phase cost of slurmctld */
+	if (stats->lock_stat_size) {
+		order = xcalloc(stats->lock_stat_size, sizeof(uint32_t));
+		for (i = 0; i < stats->lock_stat_size; i++)
+			order[i] = i;
+		for (i = 0; i < stats->lock_stat_size; i++) {
+			for (j = i + 1; j < stats->lock_stat_size; j++) {
+				if (stats->lock_stat_hold_time[order[j]] >
+				    stats->lock_stat_hold_time[order[i]]) {
+					tmp = order[i];
+					order[i] = order[j];
+					order[j] = tmp;
+				}
+			}
+		}
+		printf("\nTop lock holders (real usec)\n");
+		for (i = 0; (i < stats->lock_stat_size) &&
+			    (i < LOCK_SITE_CNT); i++) {
+			j = order[i];
+			printf("%-40s %-24s count %u hold %.0f wait %.0f\n",
+			       stats->lock_stat_site[j],
+			       stats->lock_stat_type[j],
+			       stats->lock_stat_cnt[j],
+			       _real(stats->lock_stat_hold_time[j]),
+			       _real(stats->lock_stat_wait_time[j]));
+		}
+		xfree(order);
+	}
+	slurm_free_stats_response_msg(stats);
+}
+
+int main(int argc, char **argv)
+{
+	static struct option long_options[] = {
+		{"count",     required_argument, 0, 'n'},
+		{"file",      required_argument, 0, 'f'},
+		{"help",      no_argument,       0, 'h'},
+		{"interval",  required_argument, 0, 'i'},
+		{"partition", required_argument, 0, 'p'},
+		{"verbose",   no_argument,       0, 'v'},
+		{NULL,        0,                 0, 0}
+	};
+	char *file = NULL, *partition = NULL, *env;
+	int c, i, max_jobs = 0, job_cnt = 0, submitted = 0, env_size = 0;
+	int interval = POLL_INTERVAL, verbose = 0, active;
+	stats_info_request_msg_t req;
+	trace_job_t *jobs, **by_id;
+	time_t start, target, now;
+
+	while ((c = getopt_long(argc, argv, "f:hi:n:p:v", long_options,
+				NULL)) != -1) {
+		switch (c) {
+		case 'f':
+			file = optarg;
+			break;
+		case 'i':
+			interval = MAX(atoi(optarg), 1);
+			break;
+		case 'n':
+			max_jobs = atoi(optarg);
+			break;
+		case 'p':
+			partition = optarg;
+			break;
+		case 'v':
+			verbose++;
+			break;
+		case 'h':
+		default:
+			_usage();
+			exit(c == 'h' ? 0 : 1);
+		}
+	}
+	if (!file) {
+		_usage();
+		exit(1);
+	}
+	if ((env = getenv("SIM_CLOCK_SPEEDUP")) && (atof(env) > 0.0))
+		speedup = atof(env);
+	while (environ[env_size])
+		env_size++;
+
+	jobs = _read_trace(file, max_jobs, &job_cnt);
+	if (job_cnt == 0) {
+		fprintf(stderr, "%s: no jobs found\n", file);
+		exit(1);
+	}
+
+	req.command_id = STAT_COMMAND_RESET;
+	if (slurm_reset_statistics(&req) != SLURM_SUCCESS)
+		fprintf(stderr, "Unable to reset slurmctld statistics: %s\n",
+			slurm_strerror(slurm_get_errno()));
+
+	by_id = xcalloc(job_cnt, sizeof(trace_job_t *));
+	start = time(NULL);
+	i = 0;
+	while (1) {
+		for ( ; i < job_cnt; i++) {
+			target = start + (jobs[i].submit - jobs[0].submit);
+			if (time(NULL) < target)
+				break;
+			_submit(&jobs[i], partition, env_size);
+			if (jobs[i].job_id)
+				by_id[submitted++] = &jobs[i];
+			if (verbose) {
+				printf("trace job %s submitted as job %u\n",
+				       jobs[i].trace_id ? jobs[i].trace_id : "?",
+				       jobs[i].job_id);
+			}
+		}
+
+		/* Job IDs are assigned in submit order */
+		if ((active = _poll_jobs(by_id, submitted)) < 0)
+			break;
+		if (verbose)
+			printf("%d jobs pending or running\n", active);
+		if ((i >= job_cnt) && (active == 0))
+			break;
+
+		now = time(NULL);
+		if (i < job_cnt) {
+			target = start + (jobs[i].submit - jobs[0].submit);
+			if (target > now)
+				sleep(MIN(target - now, interval));
+		} else
+			sleep(interval);
+	}
+	if (active == 0) {
+		printf("Replayed %d jobs in %.0f simulated seconds\n",
+		       job_cnt, difftime(time(NULL), start));
+		_report_jobs(by_id, submitted);
+	}
+	_report_sched();
+
+	xfree(by_id);
+	for (i = 0; i < job_cnt; i++) {
+		xfree(jobs[i].partition);
+		xfree(jobs[i].trace_id);
+	}
+	xfree(jobs);
+	exit(0);
+}
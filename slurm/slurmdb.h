@@ -570,6 +570,12 @@ struct slurmdb_assoc_usage {
 					 * (DON'T PACK) */
 	uint16_t *grp_node_job_cnt;	/* Count of jobs allocated on each node
 					 * (DON'T PACK) */
+	uint64_t *grp_tres_headroom;	/* Room left under group TRES limits
+					 * of this assoc and its parents,
+					 * set in slurmctld (DON'T PACK) */
+	uint32_t grp_tres_headroom_gen;	/* assoc_mgr_assoc_gen when
+					 * grp_tres_headroom was set
+					 * (DON'T PACK) */
 	uint64_t *grp_used_tres; /* array of active tres counts
 				  * (DON'T PACK for state file) */
 	uint64_t *grp_used_tres_run_secs; /* array of running tres secs
@@ -1285,6 +1285,25 @@ extern int slurm_job_batch_script(FILE *out, uint32_t jobid)
 extern int
 slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 		 uint16_t show_flags)
+{
+	return slurm_load_jobs_filter(update_time, job_info_msg_pptr,
+				      show_flags, NULL);
+}
+
+/*
+ * slurm_load_jobs_filter - issue RPC to get slurm information about the
+ *	jobs matching a filter if changed since update_time
+ * IN update_time - time of current configuration data
+ * IN/OUT job_info_msg_pptr - place to store a job configuration pointer
+ * IN show_flags - job filtering option: 0, SHOW_ALL, SHOW_DETAIL or SHOW_LOCAL
+ * IN filter - jobs and fields to report, NULL for all
+ * RET 0 or -1 on error
+ * NOTE: free the response using slurm_free_job_info_msg
+ */
+extern int slurm_load_jobs_filter(time_t update_time,
+				  job_info_msg_t **job_info_msg_pptr,
+				  uint16_t show_flags,
+				  job_info_filter_t *filter)
 {
 	slurm_msg_t req_msg;
 	job_info_request_msg_t req;
@@ -1313,6 +1332,7 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 	memset(&req, 0, sizeof(req));
 	req.last_update  = update_time;
 	req.show_flags   = show_flags;
+	req.filter       = filter;
 	req_msg.msg_type = REQUEST_JOB_INFO;
 	req_msg.data     = &req;
 
@@ -59,6 +59,7 @@ uint32_t g_assoc_max_priority = 0;
 uint32_t g_qos_count = 0;
 uint32_t g_user_assoc_count = 0;
 uint32_t g_tres_count = 0;
+uint32_t assoc_mgr_assoc_gen = 0;
 
 List assoc_mgr_tres_list = NULL;
 slurmdb_tres_rec_t **assoc_mgr_tres_array = NULL;
@@ -2173,8 +2174,10 @@ extern void assoc_mgr_lock(assoc_mgr_lock_t *locks)
 
 	if (locks->assoc == READ_LOCK)
 		slurm_rwlock_rdlock(&assoc_mgr_locks[ASSOC_LOCK]);
-	else if (locks->assoc == WRITE_LOCK)
+	else if (locks->assoc == WRITE_LOCK) {
 		slurm_rwlock_wrlock(&assoc_mgr_locks[ASSOC_LOCK]);
+		assoc_mgr_assoc_gen++;
+	}
 
 	if (locks->file == READ_LOCK)
 		slurm_rwlock_rdlock(&assoc_mgr_locks[FILE_LOCK]);
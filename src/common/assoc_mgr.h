@@ -117,6 +117,8 @@ extern uint32_t g_user_assoc_count; /* Number of associations which are users */
 extern uint32_t g_tres_count; /* Number of TRES from the database
 			       * which also is the number of elements
 			       * in the assoc_mgr_tres_array */
+extern uint32_t assoc_mgr_assoc_gen; /* Incremented each time the association
+				      * write lock is taken */
 
 extern int assoc_mgr_init(void *db_conn, assoc_init_args_t *args,
 			  int db_conn_errno);
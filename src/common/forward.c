@@ -52,9 +52,15 @@
 #include "src/common/slurm_route.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_protocol_interface.h"
+#include "src/common/timers.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
+#define FWD_RTT_WEIGHT	4	/* a new RTT sample weighs 1/4 of the average */
+#define FWD_SLOW_RTT	1000	/* msec, slower nodes make poor tree heads */
+#define FWD_STAT_AGE	300	/* sec, forget what was seen of a node after */
+
 typedef struct {
 	pthread_cond_t *notify;
 	int            *p_thr_count;
@@ -65,6 +71,25 @@ typedef struct {
 	pthread_mutex_t *tree_mutex;
 } fwd_tree_t;
 
+/* What this process has seen of a node it forwarded messages to */
+typedef struct {
+	char *name;
+	bool failed;		/* the last message to it failed */
+	uint32_t rtt;		/* msec, moving average of responses */
+	time_t update_time;	/* when the last response or failure was seen */
+} fwd_node_stat_t;
+
+/* Used to sort a hostlist into tree head order */
+typedef struct {
+	char *name;
+	int inx;		/* position in the original hostlist */
+	bool failed;
+	bool slow;
+} fwd_head_order_t;
+
+static pthread_mutex_t fwd_stat_mutex = PTHREAD_MUTEX_INITIALIZER;
+static xhash_t *fwd_stat_hash = NULL;	/* fwd_node_stat_t by node name */
+
 static void _start_msg_tree_internal(hostlist_t hl, hostlist_t* sp_hl,
 				     fwd_tree_t *fwd_tree_in,
 				     int hl_count);
@@ -73,6 +98,172 @@ static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
 				  header_t *header, int timeout,
 				  int hl_count);
 
+static void _fwd_stat_identify(void *item, const char **key,
+			       uint32_t *key_len)
+{
+	fwd_node_stat_t *stat = item;
+
+	*key = stat->name;
+	*key_len = strlen(stat->name);
+}
+
+static void _fwd_stat_free(void *item)
+{
+	fwd_node_stat_t *stat = item;
+
+	xfree(stat->name);
+	xfree(stat);
+}
+
+/*
+ * Record the outcome of a message to a node.
+ * IN name - node name
+ * IN failed - true if the node did not respond
+ * IN rtt - msec the node took to respond to a message sent directly to it
+ *	    (not forwarded on), -1 if unknown
+ * A successful response of unknown RTT (e.g. one forwarded through another
+ * node) decays the average, so a node which was slow once is not kept out
+ * of the tree heads for good. Nodes found healthy again are forgotten.
+ */
+static void _fwd_stat_record(char *name, bool failed, int rtt)
+{
+	fwd_node_stat_t *stat;
+
+	if (!name)
+		return;
+
+	slurm_mutex_lock(&fwd_stat_mutex);
+	if (!fwd_stat_hash)
+		fwd_stat_hash = xhash_init(_fwd_stat_identify, _fwd_stat_free);
+	if (!(stat = xhash_get_str(fwd_stat_hash, name))) {
+		if (!failed && (rtt < FWD_SLOW_RTT)) {
+			/* Nothing worth remembering */
+			slurm_mutex_unlock(&fwd_stat_mutex);
+			return;
+		}
+		stat = xmalloc(sizeof(fwd_node_stat_t));
+		stat->name = xstrdup(name);
+		if (rtt >= 0)
+			stat->rtt = rtt;
+		xhash_add(fwd_stat_hash, stat);
+	}
+	stat->failed = failed;
+	stat->update_time = time(NULL);
+	if (!failed) {
+		if (rtt < 0)	/* responded, decay the old samples */
+			rtt = 0;
+		stat->rtt = ((stat->rtt * (FWD_RTT_WEIGHT - 1)) + rtt) /
+			    FWD_RTT_WEIGHT;
+		if (stat->rtt < FWD_SLOW_RTT)
+			xhash_delete_str(fwd_stat_hash, name);
+	}
+	slurm_mutex_unlock(&fwd_stat_mutex);
+}
+
+/*
+ * Record the outcome for every node in a ret_list of responses.
+ * IN head - name of the node the message was sent to
+ * IN head_rtt - msec head took to respond if nothing was forwarded, else -1
+ */
+static void _fwd_stat_record_list(List ret_list, char *head, int head_rtt)
+{
+	ListIterator itr;
+	ret_data_info_t *ret_data_info;
+	int rtt;
+
+	itr = list_iterator_create(ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		if (ret_data_info->type == RESPONSE_FORWARD_FAILED) {
+			_fwd_stat_record(ret_data_info->node_name, true, -1);
+			continue;
+		}
+		rtt = -1;
+		if (!ret_data_info->node_name ||
+		    !xstrcmp(ret_data_info->node_name, head))
+			rtt = head_rtt;
+		_fwd_stat_record(ret_data_info->node_name ?
+				 ret_data_info->node_name : head, false, rtt);
+	}
+	list_iterator_destroy(itr);
+}
+
+static int _fwd_head_order_cmp(const void *x, const void *y)
+{
+	const fwd_head_order_t *a = x, *b = y;
+
+	if (a->failed != b->failed)
+		return a->failed ? 1 : -1;
+	if (a->slow != b->slow)
+		return a->slow ? 1 : -1;
+	return a->inx - b->inx;
+}
+
+/*
+ * Reorder each split hostlist so that the nodes whose last message failed,
+ * then those which respond slowly, come last. The first node of
+ * each hostlist is the one the message is sent to for forwarding to the
+ * others, and the next ones are tried in order if it fails, so a dead or
+ * slow node then only heads a branch once every other choice is exhausted.
+ * Hostlists are left alone unless such a node is in them. What was seen of
+ * a node more than FWD_STAT_AGE seconds ago is forgotten.
+ */
+static void _fwd_order_hostlists(hostlist_t *sp_hl, int hl_count)
+{
+	fwd_head_order_t *order;
+	fwd_node_stat_t *stat;
+	hostlist_iterator_t itr;
+	char *name;
+	int i, j, host_cnt;
+	bool reorder;
+	time_t now = time(NULL);
+
+	slurm_mutex_lock(&fwd_stat_mutex);
+	if (!fwd_stat_hash || !xhash_count(fwd_stat_hash)) {
+		slurm_mutex_unlock(&fwd_stat_mutex);
+		return;
+	}
+
+	for (i = 0; i < hl_count; i++) {
+		if ((host_cnt = hostlist_count(sp_hl[i])) < 2)
+			continue;
+		order = xcalloc(host_cnt, sizeof(fwd_head_order_t));
+		reorder = false;
+		itr = hostlist_iterator_create(sp_hl[i]);
+		for (j = 0; (j < host_cnt) && (name = hostlist_next(itr));
+		     j++) {
+			order[j].name = name;
+			order[j].inx = j;
+			if (!(stat = xhash_get_str(fwd_stat_hash, name)))
+				continue;
+			if (difftime(now, stat->update_time) > FWD_STAT_AGE) {
+				xhash_delete_str(fwd_stat_hash, name);
+				continue;
+			}
+			order[j].failed = stat->failed;
+			order[j].slow = (stat->rtt >= FWD_SLOW_RTT);
+			if (order[j].failed || order[j].slow)
+				reorder = true;
+		}
+		hostlist_iterator_destroy(itr);
+		host_cnt = j;
+
+		if (reorder) {
+			qsort(order, host_cnt, sizeof(fwd_head_order_t),
+			      _fwd_head_order_cmp);
+			hostlist_destroy(sp_hl[i]);
+			sp_hl[i] = hostlist_create(NULL);
+			for (j = 0; j < host_cnt; j++)
+				hostlist_push_host(sp_hl[i], order[j].name);
+			debug3("%s: tree head order %s", __func__,
+			       order[0].name);
+		}
+		for (j = 0; j < host_cnt; j++)
+			free(order[j].name);
+		xfree(order);
+	}
+	slurm_mutex_unlock(&fwd_stat_mutex);
+}
+
 void _destroy_tree_fwd(fwd_tree_t *fwd_tree)
 {
 	if (fwd_tree) {
@@ -319,6 +510,7 @@ void *_forward_thread(void *arg)
 	}
 	slurm_mutex_lock(&fwd_struct->forward_mutex);
 	if (ret_list) {
+		_fwd_stat_record_list(ret_list, name, -1);
 		while ((ret_data_info = list_pop(ret_list)) != NULL) {
 			if (!ret_data_info->node_name) {
 				ret_data_info->node_name = xstrdup(name);
@@ -350,6 +542,8 @@ void *_fwd_tree_thread(void *arg)
 	char *name = NULL;
 	char *buf = NULL;
 	slurm_msg_t send_msg;
+	struct timeval tv;
+	int rtt;
 
 	slurm_msg_t_init(&send_msg);
 	send_msg.msg_type = fwd_tree->orig_msg->msg_type;
@@ -386,13 +580,19 @@ void *_fwd_tree_thread(void *arg)
 		} else
 			debug3("Tree sending to %s", name);
 
+		tv.tv_sec = 0;
+		slurm_delta_tv(&tv);
 		ret_list = slurm_send_addr_recv_msgs(&send_msg, name,
 						     fwd_tree->timeout);
+		rtt = slurm_delta_tv(&tv) / 1000;
 
 		xfree(send_msg.forward.nodelist);
 
 		if (ret_list) {
 			int ret_cnt = list_count(ret_list);
+
+			_fwd_stat_record_list(ret_list, name,
+					      send_msg.forward.cnt ? -1 : rtt);
 			/* This is most common if a slurmd is running
 			   an older version of Slurm than the
 			   originator of the message.
@@ -616,6 +816,7 @@ extern int forward_msg(forward_struct_t *forward_struct, header_t *header)
 		return SLURM_ERROR;
 	}
 
+	_fwd_order_hostlists(sp_hl, hl_count);
 	_forward_msg_internal(NULL, sp_hl, forward_struct, header,
 			      forward_struct->timeout, hl_count);
 
@@ -672,6 +873,7 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 	fwd_tree.p_thr_count = &thr_count;
 	fwd_tree.tree_mutex = &tree_mutex;
 
+	_fwd_order_hostlists(sp_hl, hl_count);
 	_start_msg_tree_internal(NULL, sp_hl, &fwd_tree, hl_count);
 
 	xfree(sp_hl);
@@ -708,6 +910,7 @@ extern void mark_as_failed_forward(List *ret_list, char *node_name, int err)
 	ret_data_info_t *ret_data_info = NULL;
 
 	debug3("problems with %s", node_name);
+	_fwd_stat_record(node_name, true, -1);
 	if (!*ret_list)
 		*ret_list = list_create(destroy_data_info);
 
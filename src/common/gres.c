@@ -6971,6 +6971,68 @@ static sock_gres_t *_build_sock_gres_basic(gres_job_state_t *job_gres_ptr,
 	return sock_gres;
 }
 
+/*
+ * Return an upper bound on the count of GRES which _build_sock_gres_by_topo(),
+ * _build_sock_gres_by_type() or _build_sock_gres_basic() could make available
+ * to this job on a given node. Uses only the node's allocation counters, so a
+ * node which can not satisfy the job's per-node GRES requirement is rejected
+ * without building its per-socket GRES information.
+ */
+static uint64_t _node_gres_avail_max(gres_job_state_t *job_gres_ptr,
+				     gres_node_state_t *node_gres_ptr,
+				     bool use_total_gres)
+{
+	uint64_t avail_gres = 0, gres_tmp;
+	int i;
+
+	if (node_gres_ptr->gres_cnt_avail == 0)
+		return 0;
+
+	if (node_gres_ptr->topo_cnt) {
+		for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
+			if (job_gres_ptr->type_name &&
+			    (job_gres_ptr->type_id !=
+			     node_gres_ptr->topo_type_id[i]))
+				continue;	/* Wrong type_model */
+			if (use_total_gres || node_gres_ptr->no_consume) {
+				avail_gres +=
+					node_gres_ptr->topo_gres_cnt_avail[i];
+			} else if (node_gres_ptr->topo_gres_cnt_avail[i] >
+				   node_gres_ptr->topo_gres_cnt_alloc[i]) {
+				avail_gres +=
+					node_gres_ptr->topo_gres_cnt_avail[i] -
+					node_gres_ptr->topo_gres_cnt_alloc[i];
+			}
+		}
+		return avail_gres;
+	}
+
+	gres_tmp = node_gres_ptr->gres_cnt_avail;
+	if (!use_total_gres) {
+		if (node_gres_ptr->gres_cnt_alloc >= gres_tmp)
+			return 0;	/* No GRES remaining */
+		gres_tmp -= node_gres_ptr->gres_cnt_alloc;
+	}
+	for (i = 0; i < node_gres_ptr->type_cnt; i++) {
+		uint64_t type_avail = node_gres_ptr->type_cnt_avail[i];
+		if (job_gres_ptr->type_name &&
+		    (job_gres_ptr->type_id != node_gres_ptr->type_id[i]))
+			continue;	/* Wrong type_model */
+		if (!use_total_gres) {
+			if (node_gres_ptr->type_cnt_alloc[i] >= type_avail)
+				continue;	/* No GRES remaining */
+			type_avail -= node_gres_ptr->type_cnt_alloc[i];
+		}
+		avail_gres += MIN(type_avail, gres_tmp);
+	}
+	if (node_gres_ptr->type_cnt)
+		return avail_gres;
+
+	if (job_gres_ptr->type_name)
+		return 0;
+	return gres_tmp;
+}
+
 static void _sock_gres_log(List sock_gres_list, char *node_name)
 {
 	sock_gres_t *sock_gres;
@@ -7046,6 +7108,7 @@ extern List gres_plugin_job_test2(List job_gres_list, List node_gres_list,
 	gres_job_state_t  *job_data_ptr;
 	gres_node_state_t *node_data_ptr;
 	uint32_t local_s_p_n;
+	uint64_t min_gres;
 
 	if (!job_gres_list || (list_count(job_gres_list) == 0))
 		return sock_gres_list;
@@ -7078,8 +7141,14 @@ extern List gres_plugin_job_test2(List job_gres_list, List node_gres_list,
 			local_s_p_n = s_p_n;	/* Maximize GRES per node */
 		else
 			local_s_p_n = NO_VAL;	/* No need to optimize socket */
+		min_gres = MAX(job_data_ptr->gres_per_node,
+			       job_data_ptr->gres_per_task);
+		min_gres = MAX(min_gres, 1);
 		if (core_bitmap && (bit_set_count(core_bitmap) == 0)) {
 			sock_gres = NULL;	/* No cores available */
+		} else if (_node_gres_avail_max(job_data_ptr, node_data_ptr,
+						use_total_gres) < min_gres) {
+			sock_gres = NULL;	/* Insufficient GRES */
 		} else if (node_data_ptr->topo_cnt) {
 			uint32_t alt_plugin_id = 0;
 			gres_node_state_t *alt_node_data_ptr = NULL;
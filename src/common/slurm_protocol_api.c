@@ -4032,13 +4032,112 @@ _pack_msg(slurm_msg_t *msg, header_t *hdr, Buf buffer)
 	set_buf_offset(buffer, tmplen);
 }
 
+/* Create the auth credential sent in the header of msg */
+static void *_create_msg_auth(slurm_msg_t *msg)
+{
+	void *auth_cred;
+
+	if (msg->flags & SLURM_GLOBAL_AUTH_KEY) {
+		auth_cred = g_slurm_auth_create(msg->auth_index,
+						_global_auth_key());
+	} else {
+		char *auth_info = slurm_get_auth_info();
+		auth_cred = g_slurm_auth_create(msg->auth_index, auth_info);
+		xfree(auth_info);
+	}
+
+	return auth_cred;
+}
+
+/*
+ * Pack the header, auth credential and body of msg into buffer.
+ * auth_cred is destroyed.
+ * RET SLURM_SUCCESS or SLURM_ERROR with errno set
+ */
+static int _pack_node_msg(slurm_msg_t *msg, void *auth_cred, Buf buffer)
+{
+	header_t header;
+	int rc;
+
+	init_header(&header, msg, msg->flags);
+
+	/*
+	 * Pack header into buffer for transmission
+	 */
+	pack_header(&header, buffer);
+
+	/*
+	 * Pack auth credential
+	 */
+	rc = g_slurm_auth_pack(auth_cred, buffer, header.version);
+	(void) g_slurm_auth_destroy(auth_cred);
+	if (rc) {
+		error("authentication: %m");
+		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
+	}
+
+	/*
+	 * Pack message into buffer
+	 */
+	_pack_msg(msg, &header, buffer);
+
+#if	_DEBUG
+	_print_data (get_buf_data(buffer),get_buf_offset(buffer));
+#endif
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Pack a message to a node as slurm_send_node_msg() would send it,
+ * including the length prefix, so the caller can write it out itself
+ * (e.g. on a non-blocking connection). Forwarding is not supported.
+ * IN msg - message to pack
+ * RET buffer to free_buf() or NULL on error
+ */
+extern Buf slurm_pack_node_msg(slurm_msg_t *msg)
+{
+	Buf buffer, wire_buf;
+	void *auth_cred;
+	uint32_t msg_size;
+
+	if (msg->forward.init != FORWARD_INIT) {
+		forward_init(&msg->forward, NULL);
+		msg->ret_list = NULL;
+	}
+
+	if (!msg->forward.tree_width)
+		msg->forward.tree_width = slurm_get_tree_width();
+
+	if (!(auth_cred = _create_msg_auth(msg))) {
+		error("authentication: %m");
+		slurm_seterrno(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
+		return NULL;
+	}
+
+	buffer = init_buf(BUF_SIZE);
+	if (_pack_node_msg(msg, auth_cred, buffer)) {
+		free_buf(buffer);
+		return NULL;
+	}
+
+	/* The header is packed at offset 0, so prefix the length in a copy */
+	msg_size = get_buf_offset(buffer);
+	wire_buf = init_buf(msg_size + sizeof(uint32_t));
+	pack32(msg_size, wire_buf);
+	memcpy(get_buf_data(wire_buf) + get_buf_offset(wire_buf),
+	       get_buf_data(buffer), msg_size);
+	set_buf_offset(wire_buf, get_buf_offset(wire_buf) + msg_size);
+	free_buf(buffer);
+
+	return wire_buf;
+}
+
 /*
  *  Send a slurm message over an open file descriptor `fd'
  *    Returns the size of the message sent in bytes, or -1 on failure.
  */
 int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 {
-	header_t header;
 	Buf      buffer;
 	int      rc;
 	void *   auth_cred;
@@ -4085,14 +4184,7 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	 * but we may need to generate the credential again later if we
 	 * wait too long for the incoming message.
 	 */
-	if (msg->flags & SLURM_GLOBAL_AUTH_KEY) {
-		auth_cred = g_slurm_auth_create(msg->auth_index,
-						_global_auth_key());
-	} else {
-		char *auth_info = slurm_get_auth_info();
-		auth_cred = g_slurm_auth_create(msg->auth_index, auth_info);
-		xfree(auth_info);
-	}
+	auth_cred = _create_msg_auth(msg);
 
 	if (msg->forward.init != FORWARD_INIT) {
 		forward_init(&msg->forward, NULL);
@@ -4106,48 +4198,19 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 
 	if (difftime(time(NULL), start_time) >= 60) {
 		(void) g_slurm_auth_destroy(auth_cred);
-		if (msg->flags & SLURM_GLOBAL_AUTH_KEY) {
-			auth_cred = g_slurm_auth_create(msg->auth_index,
-							_global_auth_key());
-		} else {
-			char *auth_info = slurm_get_auth_info();
-			auth_cred = g_slurm_auth_create(msg->auth_index,
-							auth_info);
-			xfree(auth_info);
-		}
+		auth_cred = _create_msg_auth(msg);
 	}
 	if (auth_cred == NULL) {
 		error("authentication: %m");
 		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
 	}
 
-	init_header(&header, msg, msg->flags);
-
-	/*
-	 * Pack header into buffer for transmission
-	 */
 	buffer = init_buf(BUF_SIZE);
-	pack_header(&header, buffer);
-
-	/*
-	 * Pack auth credential
-	 */
-	rc = g_slurm_auth_pack(auth_cred, buffer, header.version);
-	(void) g_slurm_auth_destroy(auth_cred);
-	if (rc) {
-		error("authentication: %m");
+	if (_pack_node_msg(msg, auth_cred, buffer)) {
 		free_buf(buffer);
-		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
+		return SLURM_ERROR;
 	}
 
-	/*
-	 * Pack message into buffer
-	 */
-	_pack_msg(msg, &header, buffer);
-
-#if	_DEBUG
-	_print_data (get_buf_data(buffer),get_buf_offset(buffer));
-#endif
 	/*
 	 * Send message
 	 */
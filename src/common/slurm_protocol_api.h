@@ -1122,6 +1122,15 @@ int slurm_receive_msg_and_forward(int fd, slurm_addr_t *orig_addr,
  */
 int slurm_send_node_msg(int open_fd, slurm_msg_t *msg);
 
+/*
+ * Pack a message to a node as slurm_send_node_msg() would send it,
+ * including the length prefix, so the caller can write it out itself
+ * (e.g. on a non-blocking connection). Forwarding is not supported.
+ * IN msg - message to pack
+ * RET buffer to free_buf() or NULL on error
+ */
+extern Buf slurm_pack_node_msg(slurm_msg_t *msg);
+
 /**********************************************************************\
  * msg connection establishment functions used by msg clients
 \**********************************************************************/
@@ -779,10 +779,23 @@ extern void slurm_free_job_step_kill_msg(job_step_kill_msg_t * msg)
 	}
 }
 
+extern void slurm_free_job_info_filter(job_info_filter_t *filter)
+{
+	if (filter) {
+		FREE_NULL_LIST(filter->account_list);
+		FREE_NULL_LIST(filter->name_list);
+		FREE_NULL_LIST(filter->part_list);
+		FREE_NULL_LIST(filter->state_list);
+		FREE_NULL_LIST(filter->user_list);
+		xfree(filter);
+	}
+}
+
 extern void slurm_free_job_info_request_msg(job_info_request_msg_t *msg)
 {
 	if (msg) {
 		FREE_NULL_LIST(msg->job_ids);
+		slurm_free_job_info_filter(msg->filter);
 		xfree(msg);
 	}
 }
@@ -1582,6 +1595,29 @@ extern void slurm_free_stats_response_msg(stats_info_response_msg_t *msg)
 			xfree(msg->rpc_dump_hostlist[i]);
 		}
 		xfree(msg->rpc_dump_hostlist);
+		for (i = 0; i < msg->rpc_class_size; i++) {
+			xfree(msg->rpc_class_name[i]);
+		}
+		xfree(msg->rpc_class_name);
+		xfree(msg->rpc_class_weight);
+		xfree(msg->rpc_class_queue_len);
+		xfree(msg->rpc_class_cnt);
+		xfree(msg->rpc_class_wait);
+		xfree(msg->rpc_class_time);
+		xfree(msg->rpc_class_time_max);
+		for (i = 0; i < msg->lock_stat_size; i++) {
+			xfree(msg->lock_stat_site[i]);
+			xfree(msg->lock_stat_type[i]);
+		}
+		xfree(msg->lock_stat_site);
+		xfree(msg->lock_stat_type);
+		xfree(msg->lock_stat_cnt);
+		xfree(msg->lock_stat_wait_time);
+		xfree(msg->lock_stat_wait_max);
+		xfree(msg->lock_stat_hold_time);
+		xfree(msg->lock_stat_hold_max);
+		xfree(msg->lock_stat_wait_hist);
+		xfree(msg->lock_stat_hold_hist);
 		xfree(msg);
 	}
 }
@@ -4943,6 +4979,7 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 		break;
 	case MESSAGE_COMPOSITE:
 	case RESPONSE_MESSAGE_COMPOSITE:
+	case REQUEST_TERMINATE_JOB_AGGR:
 		slurm_free_composite_msg(data);
 		break;
 	case REQUEST_JOB_NOTIFY:
@@ -5507,6 +5544,8 @@ rpc_num2string(uint16_t opcode)
 		return "REQUEST_COMPLETE_PROLOG";
 	case RESPONSE_PROLOG_EXECUTING:				/* 6019 */
 		return "RESPONSE_PROLOG_EXECUTING";
+	case REQUEST_TERMINATE_JOB_AGGR:			/* 6020 */
+		return "REQUEST_TERMINATE_JOB_AGGR";
 
 	case SRUN_PING:						/* 7001 */
 		return "SRUN_PING";
@@ -380,6 +380,7 @@ typedef enum {
 	REQUEST_LAUNCH_PROLOG,
 	REQUEST_COMPLETE_PROLOG,
 	RESPONSE_PROLOG_EXECUTING,	/* 6019 */
+	REQUEST_TERMINATE_JOB_AGGR,	/* 6020 */
 
 	REQUEST_PERSIST_INIT = 6500,
 
@@ -604,6 +605,7 @@ typedef struct job_info_request_msg {
 	uint16_t show_flags;
 	List   job_ids;		/* Optional list of job_ids, otherwise show all
 				 * jobs. */
+	job_info_filter_t *filter; /* Optional, jobs and fields to show */
 } job_info_request_msg_t;
 
 typedef struct job_step_info_request_msg {
@@ -1365,6 +1367,7 @@ extern void slurm_free_last_update_msg(last_update_msg_t * msg);
 extern void slurm_free_return_code_msg(return_code_msg_t * msg);
 extern void slurm_free_reroute_msg(reroute_msg_t *msg);
 extern void slurm_free_job_alloc_info_msg(job_alloc_info_msg_t * msg);
+extern void slurm_free_job_info_filter(job_info_filter_t *filter);
 extern void slurm_free_job_info_request_msg(job_info_request_msg_t *msg);
 extern void slurm_free_job_step_info_request_msg(
 		job_step_info_request_msg_t *msg);
@@ -1530,6 +1530,7 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 		break;
 	case MESSAGE_COMPOSITE:
 	case RESPONSE_MESSAGE_COMPOSITE:
+	case REQUEST_TERMINATE_JOB_AGGR:
 		_pack_composite_msg((composite_msg_t *) msg->data, buffer,
 				     msg->protocol_version);
 		break;
@@ -2280,6 +2281,7 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 		break;
 	case MESSAGE_COMPOSITE:
 	case RESPONSE_MESSAGE_COMPOSITE:
+	case REQUEST_TERMINATE_JOB_AGGR:
 		rc = _unpack_composite_msg((composite_msg_t **) &(msg->data),
 					   buffer, msg->protocol_version);
 		break;
@@ -9817,6 +9819,119 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void _pack_str_list(List str_list, Buf buffer)
+{
+	uint32_t count = NO_VAL;
+	ListIterator itr;
+	char *str;
+
+	if (str_list)
+		count = list_count(str_list);
+	pack32(count, buffer);
+	if (count && (count != NO_VAL)) {
+		itr = list_iterator_create(str_list);
+		while ((str = list_next(itr)))
+			packstr(str, buffer);
+		list_iterator_destroy(itr);
+	}
+}
+
+static int _unpack_str_list(List *str_list, Buf buffer)
+{
+	uint32_t count, uint32_tmp;
+	char *str = NULL;
+	int i;
+
+	safe_unpack32(&count, buffer);
+	if (count > NO_VAL)
+		goto unpack_error;
+	if (count != NO_VAL) {
+		*str_list = list_create(slurm_destroy_char);
+		for (i = 0; i < count; i++) {
+			safe_unpackstr_xmalloc(&str, &uint32_tmp, buffer);
+			list_append(*str_list, str);
+			str = NULL;
+		}
+	}
+	return SLURM_SUCCESS;
+
+unpack_error:
+	return SLURM_ERROR;
+}
+
+static void _pack_uint32_list(List uint32_list, Buf buffer)
+{
+	uint32_t count = NO_VAL;
+	ListIterator itr;
+	uint32_t *uint32_ptr;
+
+	if (uint32_list)
+		count = list_count(uint32_list);
+	pack32(count, buffer);
+	if (count && (count != NO_VAL)) {
+		itr = list_iterator_create(uint32_list);
+		while ((uint32_ptr = list_next(itr)))
+			pack32(*uint32_ptr, buffer);
+		list_iterator_destroy(itr);
+	}
+}
+
+static int _unpack_uint32_list(List *uint32_list, Buf buffer)
+{
+	uint32_t count, *uint32_ptr = NULL;
+	int i;
+
+	safe_unpack32(&count, buffer);
+	if (count > NO_VAL)
+		goto unpack_error;
+	if (count != NO_VAL) {
+		*uint32_list = list_create(slurm_destroy_uint32_ptr);
+		for (i = 0; i < count; i++) {
+			uint32_ptr = xmalloc(sizeof(uint32_t));
+			safe_unpack32(uint32_ptr, buffer);
+			list_append(*uint32_list, uint32_ptr);
+			uint32_ptr = NULL;
+		}
+	}
+	return SLURM_SUCCESS;
+
+unpack_error:
+	xfree(uint32_ptr);
+	return SLURM_ERROR;
+}
+
+/* Filter packed only for SLURM_20_02_PROTOCOL_VERSION and later */
+static void _pack_job_info_filter(job_info_filter_t *filter, Buf buffer)
+{
+	_pack_str_list(filter->account_list, buffer);
+	_pack_str_list(filter->name_list, buffer);
+	_pack_str_list(filter->part_list, buffer);
+	pack32(filter->skip_fields, buffer);
+	_pack_uint32_list(filter->state_list, buffer);
+	_pack_uint32_list(filter->user_list, buffer);
+}
+
+static int _unpack_job_info_filter(job_info_filter_t **filter_ptr, Buf buffer)
+{
+	job_info_filter_t *filter = xmalloc(sizeof(job_info_filter_t));
+
+	*filter_ptr = filter;
+	if (_unpack_str_list(&filter->account_list, buffer) ||
+	    _unpack_str_list(&filter->name_list, buffer) ||
+	    _unpack_str_list(&filter->part_list, buffer))
+		goto unpack_error;
+	safe_unpack32(&filter->skip_fields, buffer);
+	if (_unpack_uint32_list(&filter->state_list, buffer) ||
+	    _unpack_uint32_list(&filter->user_list, buffer))
+		goto unpack_error;
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_job_info_filter(filter);
+	*filter_ptr = NULL;
+	return SLURM_ERROR;
+}
+
 static void
 _pack_job_info_request_msg(job_info_request_msg_t * msg, Buf buffer,
 			   uint16_t protocol_version)
@@ -9843,6 +9958,13 @@ _pack_job_info_request_msg(job_info_request_msg_t * msg, Buf buffer,
 			list_iterator_destroy(itr);
 		}
 
+		if (protocol_version >= SLURM_20_02_PROTOCOL_VERSION) {
+			if (msg->filter) {
+				pack8(1, buffer);
+				_pack_job_info_filter(msg->filter, buffer);
+			} else
+				pack8(0, buffer);
+		}
 	} else {
 		error("%s: protocol_version %hu not supported",
 		      __func__, protocol_version);
@@ -9855,6 +9977,7 @@ _unpack_job_info_request_msg(job_info_request_msg_t** msg,
 			     uint16_t protocol_version)
 {
 	int       i;
+	uint8_t   uint8_tmp;
 	uint32_t  count;
 	uint32_t *uint32_ptr = NULL;
 	job_info_request_msg_t *job_info;
@@ -9879,6 +10002,14 @@ _unpack_job_info_request_msg(job_info_request_msg_t** msg,
 				uint32_ptr = NULL;
 			}
 		}
+
+		if (protocol_version >= SLURM_20_02_PROTOCOL_VERSION) {
+			safe_unpack8(&uint8_tmp, buffer);
+			if (uint8_tmp &&
+			    (_unpack_job_info_filter(&job_info->filter,
+						     buffer) != SLURM_SUCCESS))
+				goto unpack_error;
+		}
 	} else {
 		error("%s: protocol_version %hu not supported",
 		      __func__, protocol_version);
@@ -12203,6 +12334,94 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 
 			safe_unpack32(&msg->bf_active,		buffer);
 			safe_unpack32(&msg->bf_backfilled_pack_jobs, buffer);
+
+			if (protocol_version >= SLURM_20_02_PROTOCOL_VERSION) {
+				safe_unpack32(&msg->rpc_pool_workers, buffer);
+				safe_unpack32(&msg->rpc_pool_busy, buffer);
+				safe_unpack64(&msg->rpc_pool_busy_time, buffer);
+				safe_unpack32(&msg->rpc_pool_pending, buffer);
+				safe_unpack32(&msg->rpc_pool_queue_len, buffer);
+				safe_unpack32(&msg->rpc_pool_queue_max, buffer);
+				safe_unpack32(&msg->rpc_pool_queue_cnt, buffer);
+				safe_unpack64(&msg->rpc_pool_queue_wait,
+					      buffer);
+				safe_unpack32(&msg->rpc_pool_throttled, buffer);
+
+				safe_unpackstr_array(&msg->rpc_class_name,
+						     &msg->rpc_class_size,
+						     buffer);
+				safe_unpack32_array(&msg->rpc_class_weight,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != msg->rpc_class_size)
+					goto unpack_error;
+				safe_unpack32_array(&msg->rpc_class_queue_len,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != msg->rpc_class_size)
+					goto unpack_error;
+				safe_unpack32_array(&msg->rpc_class_cnt,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != msg->rpc_class_size)
+					goto unpack_error;
+				safe_unpack64_array(&msg->rpc_class_wait,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != msg->rpc_class_size)
+					goto unpack_error;
+				safe_unpack64_array(&msg->rpc_class_time,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != msg->rpc_class_size)
+					goto unpack_error;
+				safe_unpack32_array(&msg->rpc_class_time_max,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != msg->rpc_class_size)
+					goto unpack_error;
+
+				safe_unpackstr_array(&msg->lock_stat_site,
+						     &msg->lock_stat_size,
+						     buffer);
+				safe_unpackstr_array(&msg->lock_stat_type,
+						     &uint32_tmp, buffer);
+				if (uint32_tmp != msg->lock_stat_size)
+					goto unpack_error;
+				safe_unpack32_array(&msg->lock_stat_cnt,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != msg->lock_stat_size)
+					goto unpack_error;
+				safe_unpack64_array(&msg->lock_stat_wait_time,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != msg->lock_stat_size)
+					goto unpack_error;
+				safe_unpack32_array(&msg->lock_stat_wait_max,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != msg->lock_stat_size)
+					goto unpack_error;
+				safe_unpack64_array(&msg->lock_stat_hold_time,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != msg->lock_stat_size)
+					goto unpack_error;
+				safe_unpack32_array(&msg->lock_stat_hold_max,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != msg->lock_stat_size)
+					goto unpack_error;
+				safe_unpack32(&msg->lock_stat_buckets, buffer);
+				safe_unpack32_array(&msg->lock_stat_wait_hist,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != (msg->lock_stat_size *
+						   msg->lock_stat_buckets))
+					goto unpack_error;
+				safe_unpack32_array(&msg->lock_stat_hold_hist,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != (msg->lock_stat_size *
+						   msg->lock_stat_buckets))
+					goto unpack_error;
+
+				safe_unpack32(&msg->msg_aggr_cnt, buffer);
+				safe_unpack32(&msg->msg_aggr_msgs, buffer);
+				safe_unpack32(&msg->msg_aggr_max, buffer);
+				safe_unpack32(&msg->kill_aggr_windows, buffer);
+				safe_unpack32(&msg->kill_aggr_full, buffer);
+				safe_unpack32(&msg->kill_aggr_msgs, buffer);
+				safe_unpack32(&msg->kill_aggr_max, buffer);
+			}
 		}
 
 		safe_unpack32(&msg->rpc_type_size,		buffer);
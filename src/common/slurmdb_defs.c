@@ -717,6 +717,7 @@ extern void slurmdb_destroy_assoc_usage(void *object)
 		FREE_NULL_LIST(usage->children_list);
 		FREE_NULL_BITMAP(usage->grp_node_bitmap);
 		xfree(usage->grp_node_job_cnt);
+		xfree(usage->grp_tres_headroom);
 		xfree(usage->grp_used_tres_run_secs);
 		xfree(usage->grp_used_tres);
 		xfree(usage->usage_tres_raw);
@@ -1311,6 +1311,8 @@ extern int bb_post_persist_create(struct job_record *job_ptr,
 			/*        grp_used_tres_run_secs[state_ptr->tres_pos]); */
 			assoc_ptr = assoc_ptr->usage->parent_assoc_ptr;
 		}
+		/* Invalidate grp_tres_headroom, see acct_policy.c */
+		assoc_mgr_assoc_gen++;
 
 		if (job_ptr && job_ptr->tres_alloc_cnt)
 			job_ptr->tres_alloc_cnt[state_ptr->tres_pos] -= size_mb;
@@ -703,6 +703,7 @@ static bb_job_t *_get_bb_job(struct job_record *job_ptr)
 	if (!have_bb) {
 		xfree(job_ptr->state_desc);
 		job_ptr->state_reason = FAIL_BURST_BUFFER_OP;
+		job_mark_dirty(job_ptr);
 		xstrfmtcat(job_ptr->state_desc,
 			   "%s: Invalid burst buffer spec (%s)",
 			   plugin_type, job_ptr->burst_buffer);
@@ -1818,6 +1819,7 @@ static void *_start_stage_in(void *x)
 	} else {
 		xfree(job_ptr->state_desc);
 		job_ptr->state_reason = FAIL_BURST_BUFFER_OP;
+		job_mark_dirty(job_ptr);
 		xstrfmtcat(job_ptr->state_desc, "%s: %s: %s",
 			   plugin_type, op, resp_msg);
 		job_ptr->priority = 0;	/* Hold job */
@@ -1954,6 +1956,7 @@ static void *_start_stage_out(void *x)
 		rc = SLURM_ERROR;
 		if (job_ptr) {
 			job_ptr->state_reason = FAIL_BURST_BUFFER_OP;
+			job_mark_dirty(job_ptr);
 			xfree(job_ptr->state_desc);
 			xstrfmtcat(job_ptr->state_desc, "%s: post_run: %s",
 				   plugin_type, resp_msg);
@@ -2020,6 +2023,7 @@ static void *_start_stage_out(void *x)
 			job_ptr = find_job_record(stage_args->job_id);
 			if (job_ptr) {
 				job_ptr->state_reason = FAIL_BURST_BUFFER_OP;
+				job_mark_dirty(job_ptr);
 				xfree(job_ptr->state_desc);
 				xstrfmtcat(job_ptr->state_desc,
 					   "%s: stage-out: %s",
@@ -2039,11 +2043,13 @@ static void *_start_stage_out(void *x)
 	} else {
 		if (rc != SLURM_SUCCESS) {
 			job_ptr->state_reason = FAIL_BURST_BUFFER_OP;
+			job_mark_dirty(job_ptr);
 			xfree(job_ptr->state_desc);
 			xstrfmtcat(job_ptr->state_desc, "%s: %s: %s",
 				   plugin_type, op, resp_msg);
 		} else {
 			job_ptr->job_state &= (~JOB_STAGE_OUT);
+			job_mark_dirty(job_ptr);
 			xfree(job_ptr->state_desc);
 			last_job_update = time(NULL);
 		}
@@ -2234,6 +2240,7 @@ static void *_start_teardown(void *x)
 		job_ptr = find_job_record(teardown_args->job_id);
 		if (job_ptr) {
 			job_ptr->state_reason = FAIL_BURST_BUFFER_OP;
+			job_mark_dirty(job_ptr);
 			xfree(job_ptr->state_desc);
 			xstrfmtcat(job_ptr->state_desc, "%s: teardown: %s",
 				   plugin_type, resp_msg);
@@ -2263,6 +2270,7 @@ static void *_start_teardown(void *x)
 			if ((bb_job = _get_bb_job(job_ptr)))
 				bb_job->state = BB_STATE_COMPLETE;
 			job_ptr->job_state &= (~JOB_STAGE_OUT);
+			job_mark_dirty(job_ptr);
 			if (!IS_JOB_PENDING(job_ptr) &&	/* No email if requeue */
 			    (job_ptr->mail_type & MAIL_JOB_STAGE_OUT)) {
 				/*
@@ -4006,6 +4014,7 @@ extern int bb_p_job_begin(struct job_record *job_ptr)
 		job_ptr->state_desc =
 			xstrdup("Could not find burst buffer record");
 		job_ptr->state_reason = FAIL_BURST_BUFFER_OP;
+		job_mark_dirty(job_ptr);
 		_queue_teardown(job_ptr->job_id, job_ptr->user_id, true);
 		slurm_mutex_unlock(&bb_state.bb_mutex);
 		return SLURM_ERROR;
@@ -4018,6 +4027,7 @@ extern int bb_p_job_begin(struct job_record *job_ptr)
 		job_ptr->state_desc =
 			xstrdup("Error managing persistent burst buffers");
 		job_ptr->state_reason = FAIL_BURST_BUFFER_OP;
+		job_mark_dirty(job_ptr);
 		_queue_teardown(job_ptr->job_id, job_ptr->user_id, true);
 		slurm_mutex_unlock(&bb_state.bb_mutex);
 		return SLURM_ERROR;
@@ -4136,6 +4146,7 @@ extern int bb_p_job_begin(struct job_record *job_ptr)
 		if (job_ptr->details) {	/* Defer launch until completion */
 			job_ptr->details->prolog_running++;
 			job_ptr->job_state |= JOB_CONFIGURING;
+			job_mark_dirty(job_ptr);
 		}
 
 		slurm_thread_create(&tid, _start_pre_run, pre_run_args);
@@ -4158,6 +4169,7 @@ static void _kill_job(struct job_record *job_ptr, bool hold_job)
 	build_cg_bitmap(job_ptr);
 	job_ptr->exit_code = 1;
 	job_ptr->state_reason = FAIL_BURST_BUFFER_OP;
+	job_mark_dirty(job_ptr);
 	xfree(job_ptr->state_desc);
 	job_ptr->state_desc = xstrdup("Burst buffer pre_run error");
 
@@ -4348,6 +4360,7 @@ extern int bb_p_job_start_stage_out(struct job_record *job_ptr)
 	} else if (bb_job->state < BB_STATE_POST_RUN) {
 		bb_job->state = BB_STATE_POST_RUN;
 		job_ptr->job_state |= JOB_STAGE_OUT;
+		job_mark_dirty(job_ptr);
 		xfree(job_ptr->state_desc);
 		xstrfmtcat(job_ptr->state_desc, "%s: Stage-out in progress",
 			   plugin_type);
@@ -4548,6 +4561,7 @@ static int _create_bufs(struct job_record *job_ptr, bb_job_t *bb_job,
 				      buf_ptr->name, bb_alloc->user_id);
 				job_ptr->priority = 0;
 				job_ptr->state_reason = FAIL_BURST_BUFFER_OP;
+				job_mark_dirty(job_ptr);
 				xfree(job_ptr->state_desc);
 				job_ptr->state_desc = xstrdup(
 					"Burst buffer create_persistent error");
@@ -4611,6 +4625,7 @@ static int _create_bufs(struct job_record *job_ptr, bb_job_t *bb_job,
 				     plugin_type, job_ptr->user_id, job_ptr,
 				     buf_ptr->name, bb_alloc->user_id);
 				job_ptr->state_reason = FAIL_BURST_BUFFER_OP;
+				job_mark_dirty(job_ptr);
 				xstrfmtcat(job_ptr->state_desc,
 					   "%s: Delete buffer %s permission "
 					   "denied",
@@ -4841,6 +4856,7 @@ static void *_create_persistent(void *x)
 			      __func__, create_args->job_id);
 		} else {
 			job_ptr->state_reason = FAIL_BAD_CONSTRAINTS;
+			job_mark_dirty(job_ptr);
 			job_ptr->priority = 0;
 			xfree(job_ptr->state_desc);
 			xstrfmtcat(job_ptr->state_desc, "%s: %s: %s",
@@ -5006,6 +5022,7 @@ static void *_destroy_persistent(void *x)
 			_update_system_comment(job_ptr, "teardown",
 					       resp_msg, 0);
 			job_ptr->state_reason = FAIL_BAD_CONSTRAINTS;
+			job_mark_dirty(job_ptr);
 			xfree(job_ptr->state_desc);
 			xstrfmtcat(job_ptr->state_desc, "%s: %s: %s",
 				   plugin_type, __func__, resp_msg);
@@ -56,6 +56,7 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include "slurm/slurm_errno.h"
 
@@ -75,6 +76,10 @@
 #define SECS_PER_DAY	(24 * 60 * 60)
 #define SECS_PER_WEEK	(7 * SECS_PER_DAY)
 
+#define DEFAULT_DECAY_THREADS 8
+#define MAX_DECAY_THREADS 64
+#define MIN_JOBS_PER_DECAY_THREAD 256
+
 /* These are defined here so when we link with something other than
  * the slurmctld we will have these symbols defined.  They will get
  * overwritten when linking with the slurmctld.
@@ -88,6 +93,8 @@ extern uint16_t part_max_priority __attribute__((weak_import));
 extern slurm_ctl_conf_t slurmctld_conf __attribute__((weak_import));
 extern int slurmctld_tres_cnt __attribute__((weak_import));
 extern int accounting_enforce __attribute__((weak_import));
+extern void job_mark_dirty(struct job_record *job_ptr)
+	__attribute__((weak_import));
 #else
 void *acct_db_conn = NULL;
 uint32_t cluster_cpus = NO_VAL;
@@ -97,6 +104,7 @@ uint16_t part_max_priority = 0;
 slurm_ctl_conf_t slurmctld_conf;
 int slurmctld_tres_cnt = 0;
 int accounting_enforce = 0;
+void job_mark_dirty(struct job_record *job_ptr) { }
 #endif
 
 /*
@@ -152,6 +160,22 @@ static uint32_t prevflags;    /* Priority Flags before _internal_setup() resets
 			       * flags after a reconfigure */
 static time_t g_last_ran = 0; /* when the last poll ran */
 static double decay_factor = 1; /* The decay factor when decaying time. */
+static int decay_threads = 1;	/* threads recalculating job priorities */
+
+/* Jobs whose priority is to be recalculated by the decay thread */
+typedef struct {
+	struct job_record **job_array;
+	int job_cnt;
+	time_t *start_time_ptr;
+} decay_jobs_t;
+
+/* Range of a decay_jobs_t job_array recalculated by one thread */
+typedef struct {
+	int begin;		/* first job_array index */
+	int end;		/* one past the last job_array index */
+	decay_jobs_t *jobs;
+	bool updated;		/* set if any job priority was set */
+} decay_range_t;
 
 /* variables defined in priority_multifactor.h */
 bool priority_debug = 0;
@@ -1192,22 +1216,6 @@ static int _apply_new_usage(struct job_record *job_ptr,
 }
 
 
-static int _decay_apply_new_usage_and_weighted_factors(
-	struct job_record *job_ptr,
-	time_t *start_time_ptr)
-{
-	/* Always return SUCCESS so that list_for_each will
-	 * continue processing list of jobs. */
-
-	if (!decay_apply_new_usage(job_ptr, start_time_ptr))
-		return SLURM_SUCCESS;
-
-	decay_apply_weighted_factors(job_ptr, start_time_ptr);
-
-	return SLURM_SUCCESS;
-}
-
-
 static void *_decay_thread(void *no_data)
 {
 	time_t start_time = time(NULL);
@@ -1381,13 +1389,9 @@ static void *_decay_thread(void *no_data)
 		 */
 		site_factor_g_update();
 
-		if (!(flags & PRIORITY_FLAGS_FAIR_TREE)) {
-			list_for_each(
-				job_list,
-				(ListForF) _decay_apply_new_usage_and_weighted_factors,
-				&start_time
-				);
-		}
+		if (!(flags & PRIORITY_FLAGS_FAIR_TREE))
+			decay_apply_weighted_factors_list(job_list,
+							  &start_time, true);
 
 		unlock_slurmctld(job_write_lock);
 
@@ -1539,7 +1543,7 @@ static void _filter_job(struct job_record *job_ptr,
 
 static void _internal_setup(void)
 {
-	char *tres_weights_str;
+	char *tres_weights_str, *prio_params, *tmp_ptr;
 	if (slurm_get_debug_flags() & DEBUG_FLAG_PRIO)
 		priority_debug = 1;
 	else
@@ -1564,6 +1568,24 @@ static void _internal_setup(void)
 	xfree(tres_weights_str);
 	flags = slurm_get_priority_flags();
 
+	prio_params = slurm_get_priority_params();
+	if ((tmp_ptr = xstrcasestr(prio_params, "decay_threads="))) {
+		decay_threads = atoi(tmp_ptr + 14);
+		if ((decay_threads < 1) ||
+		    (decay_threads > MAX_DECAY_THREADS)) {
+			error("Invalid PriorityParameters decay_threads: %d",
+			      decay_threads);
+			decay_threads = 0;		/* Use default value */
+		}
+	} else
+		decay_threads = 0;
+	if (decay_threads == 0) {
+		decay_threads = sysconf(_SC_NPROCESSORS_ONLN);
+		decay_threads = MIN(decay_threads, DEFAULT_DECAY_THREADS);
+		decay_threads = MAX(decay_threads, 1);
+	}
+	xfree(prio_params);
+
 	if (priority_debug) {
 		info("priority: Damp Factor is %u", damp_factor);
 		info("priority: AccountingStorageEnforce is %u", enforce);
@@ -1575,6 +1597,7 @@ static void _internal_setup(void)
 		info("priority: Weight Part is %u", weight_part);
 		info("priority: Weight QOS is %u", weight_qos);
 		info("priority: Flags is %u", flags);
+		info("priority: Decay Threads is %d", decay_threads);
 	}
 }
 
@@ -1768,10 +1791,7 @@ int init ( void )
 
 		/* Initialize job priority factors for valid sprio output */
 		lock_slurmctld(job_write_lock);
-		list_for_each(
-			job_list,
-			(ListForF) _decay_apply_new_usage_and_weighted_factors,
-			&start_time);
+		decay_apply_weighted_factors_list(job_list, &start_time, true);
 		unlock_slurmctld(job_write_lock);
 	} else if (assoc_mgr_root_assoc) {
 		if (!cluster_cpus)
@@ -2064,14 +2084,9 @@ extern bool decay_apply_new_usage(struct job_record *job_ptr,
 }
 
 
-extern int decay_apply_weighted_factors(struct job_record *job_ptr,
-					 time_t *start_time_ptr)
+/* Return true if the decay thread recalculates the job's priority */
+static bool _need_weighted_factors(struct job_record *job_ptr)
 {
-	uint32_t new_prio;
-
-	/* Always return SUCCESS so that list_for_each will
-	 * continue processing list of jobs. */
-
 	/*
 	 * Priority 0 is reserved for held jobs. Also skip priority
 	 * re_calculation for non-pending jobs.
@@ -2080,21 +2095,179 @@ extern int decay_apply_weighted_factors(struct job_record *job_ptr,
 	    IS_JOB_POWER_UP_NODE(job_ptr) ||
 	    (!IS_JOB_PENDING(job_ptr) &&
 	     !(flags & PRIORITY_FLAGS_CALCULATE_RUNNING)))
-		return SLURM_SUCCESS;
+		return false;
+
+	return true;
+}
+
+/*
+ * Recalculate the job's priority.
+ * Does not touch last_job_update, so it may run in several threads at once.
+ * job_mark_dirty() only changes this job's record and takes its own lock.
+ * RET true if the job's priority was set
+ */
+static bool _apply_weighted_factors(struct job_record *job_ptr,
+				    time_t start_time)
+{
+	uint32_t new_prio;
+	bool updated = false;
 
-	new_prio = _get_priority_internal(*start_time_ptr, job_ptr);
+	new_prio = _get_priority_internal(start_time, job_ptr);
 	if (((flags & PRIORITY_FLAGS_INCR_ONLY) == 0) ||
 	    (job_ptr->priority < new_prio)) {
+		if (job_ptr->priority != new_prio)
+			job_mark_dirty(job_ptr);
 		job_ptr->priority = new_prio;
-		last_job_update = time(NULL);
+		updated = true;
 	}
 
 	debug2("priority for job %u is now %u",
 	       job_ptr->job_id, job_ptr->priority);
 
+	return updated;
+}
+
+extern int decay_apply_weighted_factors(struct job_record *job_ptr,
+					 time_t *start_time_ptr)
+{
+	/* Always return SUCCESS so that list_for_each will
+	 * continue processing list of jobs. */
+
+	if (!_need_weighted_factors(job_ptr))
+		return SLURM_SUCCESS;
+
+	if (_apply_weighted_factors(job_ptr, *start_time_ptr))
+		last_job_update = time(NULL);
+
+	return SLURM_SUCCESS;
+}
+
+static int _add_decay_job(struct job_record *job_ptr, decay_jobs_t *jobs)
+{
+	if (_need_weighted_factors(job_ptr))
+		jobs->job_array[jobs->job_cnt++] = job_ptr;
+
+	return SLURM_SUCCESS;
+}
+
+static int _decay_apply_new_usage_and_add_job(struct job_record *job_ptr,
+					      decay_jobs_t *jobs)
+{
+	if (decay_apply_new_usage(job_ptr, jobs->start_time_ptr))
+		_add_decay_job(job_ptr, jobs);
+
 	return SLURM_SUCCESS;
 }
 
+static void *_decay_range_thread(void *arg)
+{
+	decay_range_t *range = arg;
+	int i;
+
+	for (i = range->begin; i < range->end; i++) {
+		if (_apply_weighted_factors(range->jobs->job_array[i],
+					    *range->jobs->start_time_ptr))
+			range->updated = true;
+	}
+
+	return NULL;
+}
+
+/*
+ * Set the effective usage of the associations whose fairshare factor the jobs
+ * in job_array need and which _set_children_usage_efctv() left at NO_VAL.
+ * _get_fairshare_priority() would otherwise set it while holding only the
+ * assoc_mgr read lock, which is not safe once several threads call it.
+ */
+static void _set_jobs_assoc_usage(decay_jobs_t *jobs)
+{
+	slurmdb_assoc_rec_t *fs_assoc;
+	assoc_mgr_lock_t locks = { WRITE_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
+				   NO_LOCK, NO_LOCK, NO_LOCK };
+	int i;
+
+	if (!calc_fairshare || !weight_fs)
+		return;
+
+	assoc_mgr_lock(&locks);
+	for (i = 0; i < jobs->job_cnt; i++) {
+		if (!(fs_assoc = jobs->job_array[i]->assoc_ptr))
+			continue;
+		if (fs_assoc->shares_raw == SLURMDB_FS_USE_PARENT)
+			fs_assoc = fs_assoc->usage->fs_assoc_ptr;
+		if (fuzzy_equal(fs_assoc->usage->usage_efctv, NO_VAL))
+			priority_p_set_assoc_usage(fs_assoc);
+	}
+	assoc_mgr_unlock(&locks);
+}
+
+/*
+ * Recalculate the priority of the jobs in job_list as
+ * decay_apply_weighted_factors() does, using up to decay_threads threads.
+ * If apply_usage is set, first apply each job's new usage as
+ * decay_apply_new_usage() does and skip the jobs it rejects.
+ * The caller must hold the job write lock. The threads run under it, so no
+ * other thread sees the new priorities before it is released.
+ */
+extern void decay_apply_weighted_factors_list(List job_list,
+					      time_t *start_time_ptr,
+					      bool apply_usage)
+{
+	decay_jobs_t jobs;
+	decay_range_t *ranges;
+	pthread_t *thread_ids;
+	int i, per_thread, thread_cnt;
+	bool updated = false;
+
+	xassert(verify_lock(JOB_LOCK, WRITE_LOCK));
+
+	jobs.job_array = xcalloc(list_count(job_list) + 1,
+				 sizeof(struct job_record *));
+	jobs.job_cnt = 0;
+	jobs.start_time_ptr = start_time_ptr;
+	if (apply_usage)
+		list_for_each(job_list,
+			      (ListForF) _decay_apply_new_usage_and_add_job,
+			      &jobs);
+	else
+		list_for_each(job_list, (ListForF) _add_decay_job, &jobs);
+
+	thread_cnt = jobs.job_cnt / MIN_JOBS_PER_DECAY_THREAD;
+	thread_cnt = MIN(thread_cnt, decay_threads);
+	if (priority_debug)	/* Keep each job's debug output together */
+		thread_cnt = 1;
+	thread_cnt = MAX(thread_cnt, 1);
+	per_thread = (jobs.job_cnt + thread_cnt - 1) / thread_cnt;
+	if (thread_cnt > 1)
+		_set_jobs_assoc_usage(&jobs);
+
+	ranges = xcalloc(thread_cnt, sizeof(decay_range_t));
+	thread_ids = xcalloc(thread_cnt, sizeof(pthread_t));
+	for (i = 0; i < thread_cnt; i++) {
+		ranges[i].begin = i * per_thread;
+		ranges[i].end = MIN((i + 1) * per_thread, jobs.job_cnt);
+		ranges[i].jobs = &jobs;
+	}
+	/* This thread calculates the first range itself */
+	for (i = 1; i < thread_cnt; i++) {
+		slurm_thread_create(&thread_ids[i], _decay_range_thread,
+				    &ranges[i]);
+	}
+	_decay_range_thread(&ranges[0]);
+	for (i = 0; i < thread_cnt; i++) {
+		if (i > 0)
+			pthread_join(thread_ids[i], NULL);
+		if (ranges[i].updated)
+			updated = true;
+	}
+	xfree(thread_ids);
+	xfree(ranges);
+	xfree(jobs.job_array);
+
+	if (updated)
+		last_job_update = time(NULL);
+}
+
 
 extern void set_priority_factors(time_t start_time, struct job_record *job_ptr)
 {
@@ -129,6 +129,8 @@ typedef struct node_space_map {
 	time_t end_time;
 	bitstr_t *avail_bitmap;
 	int next;	/* next record, by time, zero termination */
+	int left;	/* tree child with earlier begin_time, -1 if none */
+	int right;	/* tree child with later begin_time, -1 if none */
 } node_space_map_t;
 
 /*
@@ -202,6 +204,7 @@ static int yield_interval = YIELD_INTERVAL;
 static int yield_sleep   = YIELD_SLEEP;
 static List pack_job_list = NULL;
 static xhash_t *user_usage_map = NULL; /* look up user usage when no assoc */
+static int node_space_root = 0;	/* root of node_space tree by begin_time */
 
 /*********************** local functions *********************/
 static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
@@ -226,6 +229,11 @@ static void _load_config(void);
 static bool _many_pending_rpcs(void);
 static bool _more_work(time_t last_backfill_time);
 static uint32_t _my_sleep(int64_t usec);
+static int  _node_space_find(node_space_map_t *node_space, time_t when);
+static void _node_space_insert(node_space_map_t *node_space, int inx);
+static void _node_space_remove(node_space_map_t *node_space, int inx);
+static int  _node_space_split_rec(node_space_map_t *node_space, int inx,
+				  time_t when, int *node_space_recs);
 static int  _num_feature_count(struct job_record *job_ptr, bool *has_xand,
 			       bool *has_xor);
 static int  _pack_find_map(void *x, void *key);
@@ -1582,6 +1590,9 @@ static int _attempt_backfill(void)
 	bit_or(node_space[0].avail_bitmap, rs_node_bitmap);
 
 	node_space[0].next = 0;
+	node_space[0].left = -1;
+	node_space[0].right = -1;
+	node_space_root = 0;
 	node_space_recs = 1;
 	if (debug_flags & DEBUG_FLAG_BACKFILL_MAP)
 		_dump_node_space_table(node_space);
@@ -1682,6 +1693,7 @@ static int _attempt_backfill(void)
 		    (job_ptr->state_reason == WAIT_NO_REASON)) {
 			xfree(job_ptr->state_desc);
 			job_ptr->state_reason = WAIT_RESOURCES;
+			job_mark_dirty(job_ptr);
 		}
 
 		if (!_job_runnable_now(job_ptr))
@@ -1712,12 +1724,14 @@ static int _attempt_backfill(void)
 				xfree(job_ptr->state_desc);
 				job_ptr->assoc_id = assoc_rec.id;
 				last_job_update = now;
+				job_mark_dirty(job_ptr);
 			} else {
 				debug("backfill: %pJ has invalid association",
 				      job_ptr);
 				xfree(job_ptr->state_desc);
 				job_ptr->state_reason =
 					WAIT_ASSOC_RESOURCE_LIMIT;
+				job_mark_dirty(job_ptr);
 				continue;
 			}
 		}
@@ -1741,12 +1755,14 @@ static int _attempt_backfill(void)
 				xfree(job_ptr->state_desc);
 				job_ptr->state_reason = FAIL_QOS;
 				last_job_update = now;
+				job_mark_dirty(job_ptr);
 				assoc_mgr_unlock(&locks);
 				continue;
 			} else if (job_ptr->state_reason == FAIL_QOS) {
 				xfree(job_ptr->state_desc);
 				job_ptr->state_reason = WAIT_NO_REASON;
 				last_job_update = now;
+				job_mark_dirty(job_ptr);
 			}
 			assoc_mgr_unlock(&locks);
 		}
@@ -2068,7 +2084,7 @@ next_task:
 		bit_and_not(avail_bitmap, bf_ignore_node_bitmap);
 		filter_by_node_owner(job_ptr, avail_bitmap);
 		filter_by_node_mcs(job_ptr, mcs_select, avail_bitmap);
-		for (j = 0; ; ) {
+		for (j = _node_space_find(node_space, start_res); ; ) {
 			if ((node_space[j].end_time > start_res) &&
 			     node_space[j].next && (later_start == 0))
 				later_start = node_space[j].end_time;
@@ -2188,7 +2204,7 @@ next_task:
 			orig_end_time = end_time;
 			end_time += boot_time;
 
-			for (j = 0; ; ) {
+			for (j = _node_space_find(node_space, start_res); ; ) {
 				if (node_space[j].end_time <= start_res)
 					;
 				else if (node_space[j].begin_time <= end_time) {
@@ -2229,14 +2245,15 @@ next_task:
 		if (start_res > job_ptr->start_time) {
 			job_ptr->start_time = start_res;
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 		}
 		/*
 		 * avail_bitmap at this point contains a bitmap of nodes
 		 * selected for this job to be allocated
 		 */
 		if ((job_ptr->start_time <= now) &&
-		    (bit_overlap(avail_bitmap, cg_node_bitmap) ||
-		     bit_overlap(avail_bitmap, rs_node_bitmap))) {
+		    (bit_overlap_any(avail_bitmap, cg_node_bitmap) ||
+		     bit_overlap_any(avail_bitmap, rs_node_bitmap))) {
 			/* Need to wait for in-progress completion/epilog */
 			job_ptr->start_time = now + 1;
 			later_start = 0;
@@ -2262,6 +2279,7 @@ next_task:
 				     job_reason_string(job_ptr->state_reason),
 				     job_ptr->priority);
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			_set_job_time_limit(job_ptr, orig_time_limit);
 			later_start = 0;
 			if (bb == -1)
@@ -2377,6 +2395,7 @@ skip_start:
 					job_ptr->start_time = later_start;
 				else
 					job_ptr->start_time = now + 500;
+				job_mark_dirty(job_ptr);
 				if (job_ptr->qos_blocking_ptr &&
 				    job_state_qos_grp_limit(
 					    job_ptr->state_reason)) {
@@ -2616,6 +2635,7 @@ skip_start:
 		reject_array_part   = NULL;
 		xfree(job_ptr->sched_nodes);
 		job_ptr->sched_nodes = bitmap2node_name(avail_bitmap);
+		job_mark_dirty(job_ptr);
 		bit_not(avail_bitmap);
 		_add_reservation(start_time, end_reserve,
 				 avail_bitmap, node_space, &node_space_recs);
@@ -2856,16 +2876,122 @@ static bool _more_work (time_t last_backfill_time)
 	return rc;
 }
 
+/*
+ * The node_space records are also kept in a treap ordered by begin_time so
+ * that the record covering a given time can be found without walking the
+ * list. Tree priorities are a fixed hash of the record index.
+ */
+static uint32_t _node_space_prio(int inx)
+{
+	uint32_t prio = (uint32_t) inx * 2654435761U;
+
+	return prio ^ (prio >> 15);
+}
+
+/* Split tree at "when": records beginning before it go to *lo, others *hi */
+static void _node_space_cut(node_space_map_t *node_space, int root,
+			    time_t when, int *lo, int *hi)
+{
+	if (root == -1) {
+		*lo = -1;
+		*hi = -1;
+	} else if (node_space[root].begin_time < when) {
+		_node_space_cut(node_space, node_space[root].right, when,
+				&node_space[root].right, hi);
+		*lo = root;
+	} else {
+		_node_space_cut(node_space, node_space[root].left, when,
+				lo, &node_space[root].left);
+		*hi = root;
+	}
+}
+
+/* Join two trees, all records in lo beginning before those in hi */
+static int _node_space_join(node_space_map_t *node_space, int lo, int hi)
+{
+	if (lo == -1)
+		return hi;
+	if (hi == -1)
+		return lo;
+	if (_node_space_prio(lo) > _node_space_prio(hi)) {
+		node_space[lo].right = _node_space_join(node_space,
+							node_space[lo].right,
+							hi);
+		return lo;
+	}
+	node_space[hi].left = _node_space_join(node_space, lo,
+					       node_space[hi].left);
+	return hi;
+}
+
+/* Return the last record beginning at or before "when", else record zero */
+static int _node_space_find(node_space_map_t *node_space, time_t when)
+{
+	int inx = 0, j = node_space_root;
+
+	while (j != -1) {
+		if (node_space[j].begin_time <= when) {
+			inx = j;
+			j = node_space[j].right;
+		} else {
+			j = node_space[j].left;
+		}
+	}
+	return inx;
+}
+
+static void _node_space_insert(node_space_map_t *node_space, int inx)
+{
+	int lo, hi;
+
+	node_space[inx].left = -1;
+	node_space[inx].right = -1;
+	_node_space_cut(node_space, node_space_root,
+			node_space[inx].begin_time, &lo, &hi);
+	node_space_root = _node_space_join(node_space,
+					   _node_space_join(node_space, lo, inx),
+					   hi);
+}
+
+static void _node_space_remove(node_space_map_t *node_space, int inx)
+{
+	int lo, mid, hi;
+
+	_node_space_cut(node_space, node_space_root,
+			node_space[inx].begin_time, &lo, &mid);
+	_node_space_cut(node_space, mid, node_space[inx].begin_time + 1,
+			&mid, &hi);
+	xassert(mid == inx);
+	node_space_root = _node_space_join(node_space, lo, hi);
+}
+
+/* Split record inx at time "when", return the index of the new later record */
+static int _node_space_split_rec(node_space_map_t *node_space, int inx,
+				 time_t when, int *node_space_recs)
+{
+	int i = (*node_space_recs)++;
+
+	node_space[i].begin_time = when;
+	node_space[i].end_time = node_space[inx].end_time;
+	node_space[inx].end_time = when;
+	node_space[i].avail_bitmap = bit_copy(node_space[inx].avail_bitmap);
+	node_space[i].next = node_space[inx].next;
+	node_space[inx].next = i;
+	_node_space_insert(node_space, i);
+
+	return i;
+}
+
 /* Create a reservation for a job in the future */
 static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 			     bitstr_t *res_bitmap,
 			     node_space_map_t *node_space,
 			     int *node_space_recs)
 {
-	bool placed = false;
-	int i, j;
+	int i, j, first, last, prev = -1;
+	bool done;
 
-#if 0	
+#if 0
 	info("add job start:%u end:%u", start_time, end_reserve);
 	for (j = 0; ; ) {
 		info("node start:%u end:%u",
@@ -2877,74 +3003,51 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 #endif
 
 	start_time = MAX(start_time, node_space[0].begin_time);
-	for (j = 0; ; ) {
-		if (node_space[j].end_time > start_time) {
-			/* insert start entry record */
-			i = *node_space_recs;
-			node_space[i].begin_time = start_time;
-			node_space[i].end_time = node_space[j].end_time;
-			node_space[j].end_time = start_time;
-			node_space[i].avail_bitmap =
-				bit_copy(node_space[j].avail_bitmap);
-			node_space[i].next = node_space[j].next;
-			node_space[j].next = i;
-			(*node_space_recs)++;
-			placed = true;
-		}
-		if (node_space[j].end_time == start_time) {
-			/* no need to insert new start entry record */
-			placed = true;
-		}
-		if (placed == true) {
-			while ((j = node_space[j].next)) {
-				if (end_reserve < node_space[j].end_time) {
-					/* insert end entry record */
-					i = *node_space_recs;
-					node_space[i].begin_time = end_reserve;
-					node_space[i].end_time = node_space[j].
-								 end_time;
-					node_space[j].end_time = end_reserve;
-					node_space[i].avail_bitmap =
-						bit_copy(node_space[j].
-							 avail_bitmap);
-					node_space[i].next = node_space[j].next;
-					node_space[j].next = i;
-					(*node_space_recs)++;
-					break;
-				}
-				if (end_reserve == node_space[j].end_time) {
-					break;
-				}
-			}
-			break;
-		}
-		if ((j = node_space[j].next) == 0)
+	if (end_reserve <= start_time)
+		return;
+	first = _node_space_find(node_space, start_time);
+	if (node_space[first].end_time <= start_time)
+		return;		/* Starts after end of backfill window */
+	if (node_space[first].begin_time < start_time) {
+		/* insert start entry record */
+		prev = first;
+		first = _node_space_split_rec(node_space, first, start_time,
+					      node_space_recs);
+	} else if (first != 0) {
+		prev = _node_space_find(node_space, start_time - 1);
+	}
+
+	j = _node_space_find(node_space, end_reserve);
+	if ((node_space[j].begin_time < end_reserve) &&
+	    (node_space[j].end_time > end_reserve)) {
+		/* insert end entry record */
+		(void) _node_space_split_rec(node_space, j, end_reserve,
+					     node_space_recs);
+	}
+
+	for (last = first; ; ) {
+		if (node_space[last].begin_time >= end_reserve)
 			break;
-	}
-
-	for (j = 0; ; ) {
-		if ((node_space[j].begin_time >= start_time) &&
-		    (node_space[j].end_time <= end_reserve))
-			bit_and(node_space[j].avail_bitmap, res_bitmap);
-		if ((node_space[j].begin_time >= end_reserve) ||
-		    ((j = node_space[j].next) == 0))
+		bit_and(node_space[last].avail_bitmap, res_bitmap);
+		if ((last = node_space[last].next) == 0)
 			break;
 	}
 
-	/* Drop records with identical bitmaps (up to one record).
+	/* Drop records with identical bitmaps around the modified ones.
 	 * This can significantly improve performance of the backfill tests. */
-	for (i = 0; ; ) {
-		if ((j = node_space[i].next) == 0)
-			break;
-		if (!bit_equal(node_space[i].avail_bitmap,
-			       node_space[j].avail_bitmap)) {
+	for (i = (prev != -1) ? prev : first; (j = node_space[i].next); ) {
+		done = (j == last);
+		if (bit_equal(node_space[i].avail_bitmap,
+			      node_space[j].avail_bitmap)) {
+			node_space[i].end_time = node_space[j].end_time;
+			node_space[i].next = node_space[j].next;
+			FREE_NULL_BITMAP(node_space[j].avail_bitmap);
+			_node_space_remove(node_space, j);
+		} else {
 			i = j;
-			continue;
 		}
-		node_space[i].end_time = node_space[j].end_time;
-		node_space[i].next = node_space[j].next;
-		FREE_NULL_BITMAP(node_space[j].avail_bitmap);
-		break;
+		if (done)
+			break;
 	}
 }
 
@@ -3103,10 +3206,12 @@ static time_t _pack_start_find(struct job_record *job_ptr, time_t now)
 			if (job_ptr->state_reason == WAIT_TIME) {
 				job_ptr->state_reason = WAIT_NO_REASON;
 				last_job_update = now;
+				job_mark_dirty(job_ptr);
 			}
 			if (job_ptr->state_reason_prev == WAIT_TIME) {
 				job_ptr->state_reason_prev = WAIT_NO_REASON;
 				last_job_update = now;
+				job_mark_dirty(job_ptr);
 			}
 		}
 
@@ -3449,6 +3554,7 @@ static void _pack_kill_now(pack_job_map_t *map)
 		job_ptr->end_time   = now;
 		job_ptr->job_state  = JOB_PENDING | JOB_COMPLETING;
 		last_job_update     = now;
+		job_mark_dirty(job_ptr);
 		build_cg_bitmap(job_ptr);
 		job_completion_logger(job_ptr, false);
 		deallocate_nodes(job_ptr, false, false, false);
@@ -41,6 +41,21 @@
 
 #define _DEBUG 0	/* Enables module specific debugging */
 
+/*
+ * Repack a partition's rows with build_row_bitmaps() once the count of jobs
+ * removed from below jobs in other rows reaches 1/ROW_REPACK_DIVISOR of the
+ * jobs remaining in the partition
+ */
+#define ROW_REPACK_DIVISOR 4
+
+/*
+ * _get_res_avail() evaluates nodes in parallel only if there are at least
+ * RES_AVAIL_MIN_NODES candidate nodes per thread. Each thread claims
+ * RES_AVAIL_CHUNK node indexes at a time.
+ */
+#define RES_AVAIL_MIN_NODES 64
+#define RES_AVAIL_CHUNK 32
+
 /*
  * These symbols are defined here so when we link with something other
  * than the slurmctld we will have these symbols defined. They will get
@@ -93,6 +108,39 @@ typedef struct topo_weight_info {
 	uint64_t weight;
 } topo_weight_info_t;
 
+typedef struct res_avail_args {	/* _get_res_avail() work for all threads */
+	avail_res_t **avail_res_array;	/* Results, indexed by node */
+	bitstr_t **core_map;
+	uint16_t cr_type;
+	int i_last;		/* Last candidate node index */
+	struct job_record *job_ptr;
+	int next_inx;		/* Next node index to claim, res_pool_mutex */
+	bitstr_t *node_map;
+	struct node_use_record *node_usage;
+	bitstr_t **part_core_map;
+	uint32_t s_p_n;
+	bool test_only;
+} res_avail_args_t;
+
+/*
+ * Threads which help _get_res_avail() evaluate nodes. res_pool_call_mutex
+ * serializes their use, res_pool_mutex protects the remaining variables.
+ */
+static pthread_mutex_t res_pool_call_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t res_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t res_pool_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t res_pool_done_cond = PTHREAD_COND_INITIALIZER;
+static int res_pool_busy = 0;		/* Threads working on res_pool_work */
+static uint32_t res_pool_gen = 0;	/* Incremented as work is posted */
+static bool res_pool_shutdown = false;
+static int res_pool_thread_cnt = 0;
+static pthread_t *res_pool_tids = NULL;
+static res_avail_args_t *res_pool_work = NULL;
+
+/* Cache of _get_node_weight_list() */
+static pthread_mutex_t node_weight_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List node_weight_list_cache = NULL;
+
 /* Local functions */
 static void _add_job_res(job_resources_t *job_resrcs_ptr,
 			 bitstr_t ***sys_resrcs_ptr);
@@ -100,16 +148,18 @@ static void _block_whole_nodes(bitstr_t *node_bitmap,
 			       bitstr_t **orig_core_bitmap,
 			       bitstr_t **new_core_bitmap);
 static gres_mc_data_t *_build_gres_mc_data(struct job_record *job_ptr);
-static List _build_node_weight_list(bitstr_t *node_bitmap);
+static void _clear_row(struct part_row_data *r_ptr);
 static int  _compare_support(const void *v, const void *v1);
+static struct node_use_record *_cow_node_usage(
+					struct node_use_record *orig_ptr);
+static struct part_res_record *_cow_part_data(struct part_res_record *orig_ptr);
+static struct part_row_data *_cow_row_data(struct part_row_data *orig_row,
+					   uint16_t num_rows);
 static void _cpus_to_use(uint16_t *avail_cpus, int64_t rem_cpus, int rem_nodes,
 			 struct job_details *details_ptr,
 			 avail_res_t *avail_res, int node_inx,
 			 uint16_t cr_type);
 static int _cr_job_list_sort(void *x, void *y);
-static struct node_use_record *_dup_node_usage(
-					struct node_use_record *orig_ptr);
-static struct part_res_record *_dup_part_data(struct part_res_record *orig_ptr);
 static struct part_row_data *_dup_row_data(struct part_row_data *orig_row,
 					   uint16_t num_rows);
 static bool _enough_nodes(int avail_nodes, int rem_nodes,
@@ -163,6 +213,7 @@ static avail_res_t **_get_res_avail(struct job_record *job_ptr,
 				    struct node_use_record *node_usage,
 				    uint16_t cr_type, bool test_only,
 				    bitstr_t **part_core_map);
+static List _get_node_weight_list(void);
 static time_t _guess_job_end(struct job_record * job_ptr, time_t now);
 static int _handle_job_res(job_resources_t *job_resrcs_ptr,
 			   bitstr_t ***sys_resrcs_ptr,
@@ -183,10 +234,18 @@ static int _job_test(struct job_record *job_ptr, bitstr_t *node_bitmap,
 static inline void _log_select_maps(char *loc, bitstr_t *node_map,
 				    bitstr_t **core_map);
 static int _node_weight_find(void *x, void *key);
+static int _node_weight_find_inx(void *x, void *key);
 static void _node_weight_free(void *x);
 static int _node_weight_sort(void *x, void *y);
+static void _res_avail_nodes(res_avail_args_t *args);
+static void _res_avail_pool_start(int thread_cnt);
+static void _res_avail_pool_stop(void);
+static void *_res_avail_thread(void *arg);
+static void _rm_job_from_row(struct part_res_record *p_ptr, uint32_t r,
+			     struct job_record *job_ptr);
 static void _rm_job_res(job_resources_t *job_resrcs_ptr,
 			bitstr_t ***sys_resrcs_ptr);
+static void _row_unshare(struct part_row_data *r_ptr, bitstr_t *node_bitmap);
 static avail_res_t **_select_nodes(struct job_record *job_ptr,
 				uint32_t min_nodes, uint32_t max_nodes,
 				uint32_t req_nodes,
@@ -215,6 +274,16 @@ static int _node_weight_find(void *x, void *key)
 	return 0;
 }
 
+/* Find node_weight_type element from list which includes node index key */
+static int _node_weight_find_inx(void *x, void *key)
+{
+	node_weight_type *nwt = (node_weight_type *) x;
+	int *node_inx = (int *) key;
+	if (bit_test(nwt->node_bitmap, *node_inx))
+		return 1;
+	return 0;
+}
+
 /* Free node_weight_type element from list */
 static void _node_weight_free(void *x)
 {
@@ -232,42 +301,73 @@ static int _node_weight_sort(void *x, void *y)
 }
 
 /*
- * Given a bitmap of available nodes, return a list of node_weight_type
- * records in order of increasing "weight" (priority)
+ * Return a list of node_weight_type records, one per node weight, sorted by
+ * increasing weight, for all nodes. Node weights change only with node
+ * configuration, so the list is built once and kept until
+ * free_node_weight_list() is called. Do not modify or free the returned list.
+ *
+ * Callers hold the node read lock and the list is only freed with the node
+ * write lock held, so it can not be freed while any caller uses it.
  */
-static List _build_node_weight_list(bitstr_t *node_bitmap)
+static List _get_node_weight_list(void)
 {
-	int i, i_first, i_last;
-	List node_list;
+	int i;
 	struct node_record *node_ptr;
 	node_weight_type *nwt;
 
-	xassert(node_bitmap);
+	slurm_mutex_lock(&node_weight_mutex);
+	if (node_weight_list_cache) {
+		slurm_mutex_unlock(&node_weight_mutex);
+		return node_weight_list_cache;
+	}
+
 	/* Build list of node_weight_type records, one per node weight */
-	node_list = list_create(_node_weight_free);
-	i_first = bit_ffs(node_bitmap);
-	if (i_first == -1)
-		return node_list;
-	i_last = bit_fls(node_bitmap);
-	for (i = i_first; i <= i_last; i++) {
-		if (!bit_test(node_bitmap, i))
-			continue;
-		node_ptr = node_record_table_ptr + i;
-		nwt = list_find_first(node_list, _node_weight_find,
-				      node_ptr->config_ptr);
+	node_weight_list_cache = list_create(_node_weight_free);
+	for (i = 0, node_ptr = node_record_table_ptr; i < select_node_cnt;
+	     i++, node_ptr++) {
+		nwt = list_find_first(node_weight_list_cache,
+				      _node_weight_find, node_ptr->config_ptr);
 		if (!nwt) {
 			nwt = xmalloc(sizeof(node_weight_type));
 			nwt->node_bitmap = bit_alloc(select_node_cnt);
 			nwt->weight = node_ptr->config_ptr->weight;
-			list_append(node_list, nwt);
+			list_append(node_weight_list_cache, nwt);
 		}
 		bit_set(nwt->node_bitmap, i);
 	}
 
 	/* Sort the list in order of increasing node weight */
-	list_sort(node_list, _node_weight_sort);
+	list_sort(node_weight_list_cache, _node_weight_sort);
+	slurm_mutex_unlock(&node_weight_mutex);
 
-	return node_list;
+	return node_weight_list_cache;
+}
+
+/* Free the list built by _get_node_weight_list(), node weights changed */
+extern void free_node_weight_list(void)
+{
+	slurm_mutex_lock(&node_weight_mutex);
+	FREE_NULL_LIST(node_weight_list_cache);
+	slurm_mutex_unlock(&node_weight_mutex);
+}
+
+/*
+ * Free the list built by _get_node_weight_list() if the node with index
+ * node_inx is no longer listed under its current weight
+ */
+extern void update_node_weight_list(int node_inx)
+{
+	struct node_record *node_ptr = node_record_table_ptr + node_inx;
+	node_weight_type *nwt;
+
+	slurm_mutex_lock(&node_weight_mutex);
+	if (node_weight_list_cache) {
+		nwt = list_find_first(node_weight_list_cache,
+				      _node_weight_find_inx, &node_inx);
+		if (!nwt || (nwt->weight != node_ptr->config_ptr->weight))
+			FREE_NULL_LIST(node_weight_list_cache);
+	}
+	slurm_mutex_unlock(&node_weight_mutex);
 }
 
 static void _free_avail_res(avail_res_t *avail_res)
@@ -333,8 +433,9 @@ extern void add_job_to_row(struct job_resources *job,
 	/* add the job to the row_bitmap */
 	if (r_ptr->row_bitmap && (r_ptr->num_jobs == 0)) {
 		/* if no jobs, clear the existing row_bitmap first */
-		clear_core_array(r_ptr->row_bitmap);
+		_clear_row(r_ptr);
 	}
+	_row_unshare(r_ptr, job->node_bitmap);
 	_add_job_res(job, &r_ptr->row_bitmap);
 
 	/*  add the job to the job_list */
@@ -499,6 +600,7 @@ extern int rm_job_res(struct part_res_record *part_record_ptr,
 	struct node_record *node_ptr;
 	int i_first, i_last;
 	int i, n;
+	uint32_t row_inx = 0;
 	List gres_list;
 	bool old_job = false;
 
@@ -547,6 +649,13 @@ extern int rm_job_res(struct part_res_record *part_record_ptr,
 				gres_list = node_usage[i].gres_list;
 			else
 				gres_list = node_ptr->gres_list;
+			if (node_usage[i].gres_cow) {
+				/* See _cow_node_usage() */
+				gres_list = gres_plugin_node_state_dup(
+					gres_list);
+				node_usage[i].gres_list = gres_list;
+				node_usage[i].gres_cow = false;
+			}
 			gres_plugin_job_dealloc(job_ptr->gres_list, gres_list,
 						n, job_ptr->job_id,
 						node_ptr->name, old_job,
@@ -620,13 +729,14 @@ extern int rm_job_res(struct part_res_record *part_record_ptr,
 				p_ptr->row[i].num_jobs--;
 				/* found job - we're done */
 				n = 1;
+				row_inx = i;
 				i = p_ptr->num_rows;
 				break;
 			}
 		}
 		if (n) {
 			/* job was found and removed, so refresh the bitmaps */
-			build_row_bitmaps(p_ptr, job_ptr);
+			_rm_job_from_row(p_ptr, row_inx, job_ptr);
 			/*
 			 * Adjust the node_state of all nodes affected by
 			 * the removal of this job. If all cores are now
@@ -663,6 +773,44 @@ extern int rm_job_res(struct part_res_record *part_record_ptr,
 	return SLURM_SUCCESS;
 }
 
+/*
+ * A job has been removed from row "r" of the given partition, so clear just
+ * its cores from that row's row_bitmap. This leaves a hole that jobs in the
+ * less allocated rows might now fit into. Rather than repacking every row
+ * on every job removal, do so only after enough such holes accumulate.
+ */
+static void _rm_job_from_row(struct part_res_record *p_ptr, uint32_t r,
+			     struct job_record *job_ptr)
+{
+	struct part_row_data *this_row = &p_ptr->row[r];
+	uint32_t i, num_jobs = 0;
+	bool jobs_above = false;
+
+	if (this_row->num_jobs == 0) {
+		_clear_row(this_row);
+	} else {
+		xassert(job_ptr->job_resrcs);
+		_row_unshare(this_row, job_ptr->job_resrcs->node_bitmap);
+		_rm_job_res(job_ptr->job_resrcs, &this_row->row_bitmap);
+	}
+
+	for (i = 0; i < p_ptr->num_rows; i++) {
+		num_jobs += p_ptr->row[i].num_jobs;
+		if ((i > r) && p_ptr->row[i].num_jobs)
+			jobs_above = true;
+	}
+	if (!jobs_above)
+		return;
+
+	p_ptr->hole_cnt++;
+	if ((p_ptr->hole_cnt * ROW_REPACK_DIVISOR) >= num_jobs) {
+		debug3("%s: %s: repacking part %s after %u holes",
+		       plugin_type, __func__, p_ptr->part_ptr->name,
+		       p_ptr->hole_cnt);
+		build_row_bitmaps(p_ptr, NULL);
+	}
+}
+
 /*
  * build_row_bitmaps: A job has been removed from the given partition,
  *                    so the row_bitmap(s) need to be reconstructed.
@@ -682,18 +830,21 @@ extern void build_row_bitmaps(struct part_res_record *p_ptr,
 
 	if (!p_ptr->row)
 		return;
+	p_ptr->hole_cnt = 0;
 
 	if (p_ptr->num_rows == 1) {
 		this_row = p_ptr->row;
 		if (this_row->num_jobs == 0) {
-			clear_core_array(this_row->row_bitmap);
+			_clear_row(this_row);
 		} else {
 			if (job_ptr) { /* just remove the job */
 				xassert(job_ptr->job_resrcs);
+				_row_unshare(this_row,
+					     job_ptr->job_resrcs->node_bitmap);
 				_rm_job_res(job_ptr->job_resrcs,
 					    &this_row->row_bitmap);
 			} else { /* totally rebuild the bitmap */
-				clear_core_array(this_row->row_bitmap);
+				_clear_row(this_row);
 				for (j = 0; j < this_row->num_jobs; j++) {
 					_add_job_res(this_row->job_list[j],
 						     &this_row->row_bitmap);
@@ -710,7 +861,7 @@ extern void build_row_bitmaps(struct part_res_record *p_ptr,
 	}
 	if (num_jobs == 0) {
 		for (i = 0; i < p_ptr->num_rows; i++)
-			clear_core_array(p_ptr->row[i].row_bitmap);
+			_clear_row(&p_ptr->row[i]);
 		return;
 	}
 
@@ -738,7 +889,7 @@ extern void build_row_bitmaps(struct part_res_record *p_ptr,
 			x++;
 		}
 		p_ptr->row[i].num_jobs = 0;
-		clear_core_array(p_ptr->row[i].row_bitmap);
+		_clear_row(&p_ptr->row[i]);
 	}
 
 	/*
@@ -808,7 +959,7 @@ extern void build_row_bitmaps(struct part_res_record *p_ptr,
 
 		/* still need to rebuild row_bitmaps */
 		for (i = 0; i < p_ptr->num_rows; i++) {
-			clear_core_array(p_ptr->row[i].row_bitmap);
+			_clear_row(&p_ptr->row[i]);
 			if (p_ptr->row[i].num_jobs == 0)
 				continue;
 			for (j = 0; j < p_ptr->row[i].num_jobs; j++) {
@@ -917,33 +1068,35 @@ extern int vpus_per_core(struct job_details *details, int node_inx)
 	return vpus_per_core;
 }
 
-/* Create a duplicate part_res_record list */
-static struct node_use_record *_dup_node_usage(struct node_use_record *orig_ptr)
+/*
+ * Create a copy-on-write copy of a node_use_record array for simulating
+ * future node state. GRES state is shared with orig_ptr, or with the node's
+ * gres_list, until rm_job_res() changes it. orig_ptr must not change while
+ * the copy exists. Free with cr_destroy_node_data().
+ */
+static struct node_use_record *_cow_node_usage(struct node_use_record *orig_ptr)
 {
-	struct node_use_record *new_use_ptr, *new_ptr;
-	List gres_list;
+	struct node_use_record *new_use_ptr;
 	uint32_t i;
 
 	if (orig_ptr == NULL)
 		return NULL;
 
 	new_use_ptr = xmalloc(select_node_cnt * sizeof(struct node_use_record));
-	new_ptr = new_use_ptr;
+	memcpy(new_use_ptr, orig_ptr,
+	       select_node_cnt * sizeof(struct node_use_record));
+	for (i = 0; i < select_node_cnt; i++)
+		new_use_ptr[i].gres_cow = true;
 
-	for (i = 0; i < select_node_cnt; i++) {
-		new_ptr[i].node_state   = orig_ptr[i].node_state;
-		new_ptr[i].alloc_memory = orig_ptr[i].alloc_memory;
-		if (orig_ptr[i].gres_list)
-			gres_list = orig_ptr[i].gres_list;
-		else
-			gres_list = node_record_table_ptr[i].gres_list;
-		new_ptr[i].gres_list = gres_plugin_node_state_dup(gres_list);
-	}
 	return new_use_ptr;
 }
 
-/* Create a duplicate part_res_record list */
-static struct part_res_record *_dup_part_data(struct part_res_record *orig_ptr)
+/*
+ * Create a copy-on-write copy of a part_res_record list for simulating
+ * future partition state, see _cow_row_data(). orig_ptr must not change
+ * while the copy exists. Free with cr_destroy_part_data().
+ */
+static struct part_res_record *_cow_part_data(struct part_res_record *orig_ptr)
 {
 	struct part_res_record *new_part_ptr, *new_ptr;
 
@@ -956,7 +1109,8 @@ static struct part_res_record *_dup_part_data(struct part_res_record *orig_ptr)
 	while (orig_ptr) {
 		new_ptr->part_ptr = orig_ptr->part_ptr;
 		new_ptr->num_rows = orig_ptr->num_rows;
-		new_ptr->row = _dup_row_data(orig_ptr->row,
+		new_ptr->hole_cnt = orig_ptr->hole_cnt;
+		new_ptr->row = _cow_row_data(orig_ptr->row,
 					     orig_ptr->num_rows);
 		if (orig_ptr->next) {
 			new_ptr->next = xmalloc(sizeof(struct part_res_record));
@@ -967,7 +1121,82 @@ static struct part_res_record *_dup_part_data(struct part_res_record *orig_ptr)
 	return new_part_ptr;
 }
 
-/* Helper function for _dup_part_data: create a duplicate part_row_data array */
+/*
+ * Helper function for _cow_part_data: create a part_row_data array sharing
+ * each node's row_bitmap with orig_row until _row_unshare() is called for
+ * that node. Only the job lists and the per-row bitmap pointer arrays are
+ * copied.
+ */
+static struct part_row_data *_cow_row_data(struct part_row_data *orig_row,
+					   uint16_t num_rows)
+{
+	struct part_row_data *new_row;
+	int i;
+
+	if (num_rows == 0 || !orig_row)
+		return NULL;
+
+	new_row = xmalloc(num_rows * sizeof(struct part_row_data));
+	for (i = 0; i < num_rows; i++) {
+		new_row[i].num_jobs = orig_row[i].num_jobs;
+		new_row[i].job_list_size = orig_row[i].job_list_size;
+		if (orig_row[i].row_bitmap) {
+			new_row[i].row_bitmap = xmalloc(sizeof(bitstr_t *) *
+							select_node_cnt);
+			memcpy(new_row[i].row_bitmap, orig_row[i].row_bitmap,
+			       sizeof(bitstr_t *) * select_node_cnt);
+			new_row[i].cow_bitmap = bit_alloc(select_node_cnt);
+			bit_set_all(new_row[i].cow_bitmap);
+		}
+		if (new_row[i].job_list_size == 0)
+			continue;
+		/* copy the job list */
+		new_row[i].job_list = xmalloc(new_row[i].job_list_size *
+					      sizeof(struct job_resources *));
+		memcpy(new_row[i].job_list, orig_row[i].job_list,
+		       (sizeof(struct job_resources *) * new_row[i].num_jobs));
+	}
+	return new_row;
+}
+
+/*
+ * Give a copy-on-write row its own row_bitmap for the nodes in node_bitmap,
+ * or for all nodes if NULL, before they are changed
+ */
+static void _row_unshare(struct part_row_data *r_ptr, bitstr_t *node_bitmap)
+{
+	int i, i_first, i_last;
+
+	if (!r_ptr->cow_bitmap)
+		return;
+
+	if (!node_bitmap)
+		node_bitmap = r_ptr->cow_bitmap;
+	i_first = bit_ffs(node_bitmap);
+	if (i_first != -1)
+		i_last = bit_fls(node_bitmap);
+	else
+		i_last = -2;
+	for (i = i_first; i <= i_last; i++) {
+		if (!bit_test(r_ptr->cow_bitmap, i) ||
+		    !bit_test(node_bitmap, i))
+			continue;
+		if (r_ptr->row_bitmap[i])
+			r_ptr->row_bitmap[i] = bit_copy(r_ptr->row_bitmap[i]);
+		bit_clear(r_ptr->cow_bitmap, i);
+	}
+	if (bit_ffs(r_ptr->cow_bitmap) == -1)
+		FREE_NULL_BITMAP(r_ptr->cow_bitmap);
+}
+
+/* Clear all cores of a row's row_bitmap */
+static void _clear_row(struct part_row_data *r_ptr)
+{
+	_row_unshare(r_ptr, NULL);
+	clear_core_array(r_ptr->row_bitmap);
+}
+
+/* Create a duplicate part_row_data array */
 static struct part_row_data *_dup_row_data(struct part_row_data *orig_row,
 					   uint16_t num_rows)
 {
@@ -3110,7 +3339,7 @@ static int _eval_nodes_spread(struct job_record *job_ptr,
 
 	if (max_nodes == 0)
 		all_done = true;
-	node_weight_list = _build_node_weight_list(orig_node_map);
+	node_weight_list = _get_node_weight_list();
 	iter = list_iterator_create(node_weight_list);
 	while (!all_done && (nwt = (node_weight_type *) list_next(iter))) {
 		for (i = i_start; i <= i_end; i++) {
@@ -3119,6 +3348,7 @@ static int _eval_nodes_spread(struct job_record *job_ptr,
 				continue;
 			/* Node not available or already selected */
 			if (!bit_test(nwt->node_bitmap, i) ||
+			    !bit_test(orig_node_map, i) ||
 			    bit_test(node_map, i))
 				continue;
 			_select_cores(job_ptr, mc_ptr, enforce_binding, i,
@@ -3174,8 +3404,7 @@ static int _eval_nodes_spread(struct job_record *job_ptr,
 		error_code = SLURM_SUCCESS;
 	}
 
-fini:	FREE_NULL_LIST(node_weight_list);
-	bit_free(orig_node_map);
+fini:	bit_free(orig_node_map);
 	return error_code;
 }
 
@@ -3299,7 +3528,7 @@ static int _eval_nodes_busy(struct job_record *job_ptr,
 	 */
 	if (max_nodes == 0)
 		all_done = true;
-	node_weight_list = _build_node_weight_list(orig_node_map);
+	node_weight_list = _get_node_weight_list();
 	iter = list_iterator_create(node_weight_list);
 	while (!all_done && (nwt = (node_weight_type *) list_next(iter))) {
 		for (idle_test = 0; idle_test < 2; idle_test++) {
@@ -3309,6 +3538,7 @@ static int _eval_nodes_busy(struct job_record *job_ptr,
 					continue;
 				/* Node not available or already selected */
 				if (!bit_test(nwt->node_bitmap, i) ||
+				    !bit_test(orig_node_map, i) ||
 				    bit_test(node_map, i))
 					continue;
 				if (((idle_test == 0) &&
@@ -3375,8 +3605,7 @@ static int _eval_nodes_busy(struct job_record *job_ptr,
 		error_code = SLURM_SUCCESS;
 	}
 
-fini:	FREE_NULL_LIST(node_weight_list);
-	bit_free(orig_node_map);
+fini:	bit_free(orig_node_map);
 	return error_code;
 }
 
@@ -3411,6 +3640,71 @@ static int _topo_weight_sort(void *x, void *y)
 	return (int) (nwt1->weight - nwt2->weight);
 }
 
+/*
+ * Return a bitmap of the switches with any node in node_bitmap, indexed like
+ * switch_record_table. Uses each node's list of switches rather than testing
+ * every switch's node_bitmap.
+ */
+static bitstr_t *_switches_with_nodes(bitstr_t *node_bitmap)
+{
+	bitstr_t *switch_bitmap = bit_alloc(switch_record_cnt);
+	int i, i_first, i_last, s;
+
+	i_first = bit_ffs(node_bitmap);
+	if (i_first >= 0)
+		i_last = bit_fls(node_bitmap);
+	else
+		i_last = -2;
+	for (i = i_first; i <= i_last; i++) {
+		if (!bit_test(node_bitmap, i))
+			continue;
+		for (s = 0; s < select_node_record[i].switch_cnt; s++) {
+			bit_set(switch_bitmap,
+				select_node_record[i].switch_inx[s]);
+		}
+	}
+
+	return switch_bitmap;
+}
+
+/*
+ * Build per-switch bitmaps and counts of the nodes in node_bitmap. Switches
+ * without any of those nodes are left with a NULL bitmap and a zero count, so
+ * callers can skip them without testing their nodes.
+ * IN node_bitmap - nodes to record
+ * OUT switch_node_bitmap - nodes of each switch in node_bitmap
+ * OUT switch_node_cnt - count of nodes of each switch in node_bitmap
+ * OUT avail_nodes_bitmap - set for nodes of node_bitmap on any switch
+ */
+static void _switch_nodes_build(bitstr_t *node_bitmap,
+				bitstr_t **switch_node_bitmap,
+				int *switch_node_cnt,
+				bitstr_t *avail_nodes_bitmap)
+{
+	int i, i_first, i_last, s, switch_inx;
+
+	i_first = bit_ffs(node_bitmap);
+	if (i_first >= 0)
+		i_last = bit_fls(node_bitmap);
+	else
+		i_last = -2;
+	for (i = i_first; i <= i_last; i++) {
+		if (!bit_test(node_bitmap, i) ||
+		    !select_node_record[i].switch_cnt)
+			continue;
+		bit_set(avail_nodes_bitmap, i);
+		for (s = 0; s < select_node_record[i].switch_cnt; s++) {
+			switch_inx = select_node_record[i].switch_inx[s];
+			if (!switch_node_bitmap[switch_inx]) {
+				switch_node_bitmap[switch_inx] =
+					bit_alloc(select_node_cnt);
+			}
+			bit_set(switch_node_bitmap[switch_inx], i);
+			switch_node_cnt[switch_inx]++;
+		}
+	}
+}
+
 /*
  * Allocate resources to the job on one leaf switch if possible,
  * otherwise distribute the job allocation over many leaf switches.
@@ -3431,10 +3725,10 @@ static int _eval_nodes_dfly(struct job_record *job_ptr,
 	bitstr_t  *req_nodes_bitmap   = NULL;	/* required node bitmap */
 	bitstr_t  *req2_nodes_bitmap  = NULL;	/* required+lowest prio nodes */
 	bitstr_t  *best_nodes_bitmap  = NULL;	/* required+low prio nodes */
+	bitstr_t  *switch_bitmap      = NULL;	/* switches with given nodes */
 	int i, i_first, i_last, j, rc = SLURM_SUCCESS;
 	int best_cpu_cnt = 0, best_node_cnt = 0, req_node_cnt = 0;
 	List best_gres = NULL;
-	struct switch_record *switch_ptr;
 	List node_weight_list = NULL;
 	topo_weight_info_t *nw = NULL;
 	ListIterator iter;
@@ -3596,33 +3890,29 @@ static int _eval_nodes_dfly(struct job_record *job_ptr,
 	switch_node_cnt    = xmalloc(sizeof(int)        * switch_record_cnt);
 	switch_required    = xmalloc(sizeof(int)        * switch_record_cnt);
 
-	if (!req_nodes_bitmap)
+	if (req_nodes_bitmap) {
+		switch_bitmap = _switches_with_nodes(req_nodes_bitmap);
+	} else {
 		nw = list_peek(node_weight_list);
-	for (i = 0, switch_ptr = switch_record_table; i < switch_record_cnt;
-	     i++, switch_ptr++) {
-		switch_node_bitmap[i] = bit_copy(switch_ptr->node_bitmap);
-		if (req_nodes_bitmap &&
-		    bit_overlap(req_nodes_bitmap, switch_node_bitmap[i])) {
+		switch_bitmap = _switches_with_nodes(nw->node_bitmap);
+	}
+	for (i = 0; i < switch_record_cnt; i++) {
+		if (!bit_test(switch_bitmap, i))
+			continue;
+		if (req_nodes_bitmap) {
 			switch_required[i] = 1;
 			if (switch_record_table[i].level == 0) {
 				leaf_switch_count++;
 				req_leaf_switch_count++;
 			}
-			if ((top_switch_inx == -1) ||
-			    (switch_record_table[i].level >
-			     switch_record_table[top_switch_inx].level)) {
-				top_switch_inx = i;
-			}
 		}
-		if (!req_nodes_bitmap &&
-		    bit_overlap(nw->node_bitmap, switch_node_bitmap[i])) {
-			if ((top_switch_inx == -1) ||
-			    (switch_record_table[i].level >
-			     switch_record_table[top_switch_inx].level)) {
-				top_switch_inx = i;
-			}
+		if ((top_switch_inx == -1) ||
+		    (switch_record_table[i].level >
+		     switch_record_table[top_switch_inx].level)) {
+			top_switch_inx = i;
 		}
 	}
+	FREE_NULL_BITMAP(switch_bitmap);
 
 	/*
 	 * Top switch is highest level switch containing all required nodes
@@ -3639,24 +3929,13 @@ static int _eval_nodes_dfly(struct job_record *job_ptr,
 	/* Check that all specificly required nodes are on shared network */
 	if (req_nodes_bitmap &&
 	    !bit_super_set(req_nodes_bitmap,
-			   switch_node_bitmap[top_switch_inx])) {
+			   switch_record_table[top_switch_inx].node_bitmap)) {
 		rc = SLURM_ERROR;
 		info("%s: %s: %pJ requires nodes that do not have shared network",
 		     plugin_type, __func__, job_ptr);
 		goto fini;
 	}
 
-	/*
-	 * Remove nodes from consideration that can not be reached from this
-	 * top level switch
-	 */
-	for (i = 0; i < switch_record_cnt; i++) {
-		if (top_switch_inx != i) {
-			  bit_and(switch_node_bitmap[i],
-				  switch_node_bitmap[top_switch_inx]);
-		}
-	}
-
 	/*
 	 * Identify the best set of nodes (i.e. nodes with the lowest weight,
 	 * in addition to the required nodes) that can be used to satisfy the
@@ -3687,7 +3966,8 @@ static int _eval_nodes_dfly(struct job_record *job_ptr,
 			if (avail_cpu_per_node[i])
 				continue;	/* Required node */
 			if (!bit_test(nw->node_bitmap, i) ||
-			    !bit_test(switch_node_bitmap[top_switch_inx], i))
+			    !bit_test(switch_record_table[top_switch_inx].
+				      node_bitmap, i))
 				continue;
 			_select_cores(job_ptr, mc_ptr, enforce_binding, i,
 				      &avail_cpus, max_nodes, min_rem_nodes,
@@ -3771,19 +4051,17 @@ static int _eval_nodes_dfly(struct job_record *job_ptr,
 			}
 		}
 
-		for (i = 0, switch_ptr = switch_record_table;
-		     i < switch_record_cnt; i++, switch_ptr++) {
-			if (switch_required[i])
+		switch_bitmap = _switches_with_nodes(req2_nodes_bitmap);
+		for (i = 0; i < switch_record_cnt; i++) {
+			if (switch_required[i] || !bit_test(switch_bitmap, i))
 				continue;
-			if (bit_overlap(req2_nodes_bitmap,
-					switch_node_bitmap[i])) {
-				switch_required[i] = 1;
-				if (switch_record_table[i].level == 0) {
-					leaf_switch_count++;
-					req_leaf_switch_count++;
-				}
+			switch_required[i] = 1;
+			if (switch_record_table[i].level == 0) {
+				leaf_switch_count++;
+				req_leaf_switch_count++;
 			}
 		}
+		FREE_NULL_BITMAP(switch_bitmap);
 		bit_or(node_map, req2_nodes_bitmap);
 		if ((job_ptr->req_switch > 0) &&
 		    (req_leaf_switch_count > job_ptr->req_switch) &&
@@ -3815,15 +4093,12 @@ static int _eval_nodes_dfly(struct job_record *job_ptr,
 	/*
 	 * Construct a set of switch array entries.
 	 * Use the same indexes as switch_record_table in slurmctld.
+	 * All of these nodes are below the top switch.
 	 */
 	bit_or(best_nodes_bitmap, node_map);
 	avail_nodes_bitmap = bit_alloc(node_record_count);
-	for (i = 0, switch_ptr = switch_record_table; i < switch_record_cnt;
-	     i++, switch_ptr++) {
-		bit_and(switch_node_bitmap[i], best_nodes_bitmap);
-		bit_or(avail_nodes_bitmap, switch_node_bitmap[i]);
-		switch_node_cnt[i] = bit_set_count(switch_node_bitmap[i]);
-	}
+	_switch_nodes_build(best_nodes_bitmap, switch_node_bitmap,
+			    switch_node_cnt, avail_nodes_bitmap);
 
 	if (select_debug_flags & DEBUG_FLAG_SELECT_TYPE) {
 		for (i = 0; i < switch_record_cnt; i++) {
@@ -4069,10 +4344,10 @@ static int _eval_nodes_topo(struct job_record *job_ptr,
 	bitstr_t  *req_nodes_bitmap   = NULL;	/* required node bitmap */
 	bitstr_t  *req2_nodes_bitmap  = NULL;	/* required+lowest prio nodes */
 	bitstr_t  *best_nodes_bitmap  = NULL;	/* required+low prio nodes */
+	bitstr_t  *switch_bitmap      = NULL;	/* switches with given nodes */
 	int i, i_first, i_last, j, rc = SLURM_SUCCESS;
 	int best_cpu_cnt = 0, best_node_cnt = 0, req_node_cnt = 0;
 	List best_gres = NULL;
-	struct switch_record *switch_ptr;
 	List node_weight_list = NULL;
 	topo_weight_info_t *nw = NULL;
 	ListIterator iter;
@@ -4228,33 +4503,29 @@ static int _eval_nodes_topo(struct job_record *job_ptr,
 	switch_node_cnt    = xmalloc(sizeof(int)        * switch_record_cnt);
 	switch_required    = xmalloc(sizeof(int)        * switch_record_cnt);
 
-	if (!req_nodes_bitmap)
+	if (req_nodes_bitmap) {
+		switch_bitmap = _switches_with_nodes(req_nodes_bitmap);
+	} else {
 		nw = list_peek(node_weight_list);
-	for (i = 0, switch_ptr = switch_record_table; i < switch_record_cnt;
-	     i++, switch_ptr++) {
-		switch_node_bitmap[i] = bit_copy(switch_ptr->node_bitmap);
-		if (req_nodes_bitmap &&
-		    bit_overlap(req_nodes_bitmap, switch_node_bitmap[i])) {
+		switch_bitmap = _switches_with_nodes(nw->node_bitmap);
+	}
+	for (i = 0; i < switch_record_cnt; i++) {
+		if (!bit_test(switch_bitmap, i))
+			continue;
+		if (req_nodes_bitmap) {
 			switch_required[i] = 1;
 			if (switch_record_table[i].level == 0) {
 				leaf_switch_count++;
 				req_leaf_switch_count++;
 			}
-			if ((top_switch_inx == -1) ||
-			    (switch_record_table[i].level >
-			     switch_record_table[top_switch_inx].level)) {
-				top_switch_inx = i;
-			}
 		}
-		if (!req_nodes_bitmap &&
-		    bit_overlap(nw->node_bitmap, switch_node_bitmap[i])) {
-			if ((top_switch_inx == -1) ||
-			    (switch_record_table[i].level >
-			     switch_record_table[top_switch_inx].level)) {
-				top_switch_inx = i;
-			}
+		if ((top_switch_inx == -1) ||
+		    (switch_record_table[i].level >
+		     switch_record_table[top_switch_inx].level)) {
+			top_switch_inx = i;
 		}
 	}
+	FREE_NULL_BITMAP(switch_bitmap);
 
 	/*
 	 * Top switch is highest level switch containing all required nodes
@@ -4271,24 +4542,13 @@ static int _eval_nodes_topo(struct job_record *job_ptr,
 	/* Check that all specificly required nodes are on shared network */
 	if (req_nodes_bitmap &&
 	    !bit_super_set(req_nodes_bitmap,
-			   switch_node_bitmap[top_switch_inx])) {
+			   switch_record_table[top_switch_inx].node_bitmap)) {
 		rc = SLURM_ERROR;
 		info("%s: %s: %pJ requires nodes that do not have shared network",
 		     plugin_type, __func__, job_ptr);
 		goto fini;
 	}
 
-	/*
-	 * Remove nodes from consideration that can not be reached from this
-	 * top level switch.
-	 */
-	for (i = 0; i < switch_record_cnt; i++) {
-		if (top_switch_inx != i) {
-			  bit_and(switch_node_bitmap[i],
-				  switch_node_bitmap[top_switch_inx]);
-		}
-	}
-
 	/*
 	 * Identify the best set of nodes (i.e. nodes with the lowest weight,
 	 * in addition to the required nodes) that can be used to satisfy the
@@ -4319,7 +4579,8 @@ static int _eval_nodes_topo(struct job_record *job_ptr,
 			if (avail_cpu_per_node[i])
 				continue;	/* Required node */
 			if (!bit_test(nw->node_bitmap, i) ||
-			    !bit_test(switch_node_bitmap[top_switch_inx], i))
+			    !bit_test(switch_record_table[top_switch_inx].
+				      node_bitmap, i))
 				continue;
 			_select_cores(job_ptr, mc_ptr, enforce_binding, i,
 				      &avail_cpus, max_nodes, min_rem_nodes,
@@ -4403,19 +4664,17 @@ static int _eval_nodes_topo(struct job_record *job_ptr,
 			}
 		}
 
-		for (i = 0, switch_ptr = switch_record_table;
-		     i < switch_record_cnt; i++, switch_ptr++) {
-			if (switch_required[i])
+		switch_bitmap = _switches_with_nodes(req2_nodes_bitmap);
+		for (i = 0; i < switch_record_cnt; i++) {
+			if (switch_required[i] || !bit_test(switch_bitmap, i))
 				continue;
-			if (bit_overlap(req2_nodes_bitmap,
-					switch_node_bitmap[i])) {
-				switch_required[i] = 1;
-				if (switch_record_table[i].level == 0) {
-					leaf_switch_count++;
-					req_leaf_switch_count++;
-				}
+			switch_required[i] = 1;
+			if (switch_record_table[i].level == 0) {
+				leaf_switch_count++;
+				req_leaf_switch_count++;
 			}
 		}
+		FREE_NULL_BITMAP(switch_bitmap);
 		bit_or(node_map, req2_nodes_bitmap);
 		if ((job_ptr->req_switch > 0) &&
 		    (req_leaf_switch_count > job_ptr->req_switch) &&
@@ -4448,15 +4707,12 @@ static int _eval_nodes_topo(struct job_record *job_ptr,
 	/*
 	 * Construct a set of switch array entries.
 	 * Use the same indexes as switch_record_table in slurmctld.
+	 * All of these nodes are below the top switch.
 	 */
 	bit_or(best_nodes_bitmap, node_map);
 	avail_nodes_bitmap = bit_alloc(node_record_count);
-	for (i = 0, switch_ptr = switch_record_table; i < switch_record_cnt;
-	     i++, switch_ptr++) {
-		bit_and(switch_node_bitmap[i], best_nodes_bitmap);
-		bit_or(avail_nodes_bitmap, switch_node_bitmap[i]);
-		switch_node_cnt[i] = bit_set_count(switch_node_bitmap[i]);
-	}
+	_switch_nodes_build(best_nodes_bitmap, switch_node_bitmap,
+			    switch_node_cnt, avail_nodes_bitmap);
 
 	if (select_debug_flags & DEBUG_FLAG_SELECT_TYPE) {
 		for (i = 0; i < switch_record_cnt; i++) {
@@ -4749,7 +5005,7 @@ static int _eval_nodes_lln(struct job_record *job_ptr,
 	if (max_nodes == 0)
 		all_done = true;
 	avail_cpu_per_node = xmalloc(sizeof(uint16_t) * select_node_cnt);
-	node_weight_list = _build_node_weight_list(orig_node_map);
+	node_weight_list = _get_node_weight_list();
 	iter = list_iterator_create(node_weight_list);
 	while (!all_done && (nwt = (node_weight_type *) list_next(iter))) {
 		int last_max_cpu_cnt = -1;
@@ -4758,6 +5014,7 @@ static int _eval_nodes_lln(struct job_record *job_ptr,
 			for (i = i_start; i <= i_end; i++) {
 				/* Node not available or already selected */
 				if (!bit_test(nwt->node_bitmap, i) ||
+				    !bit_test(orig_node_map, i) ||
 				    bit_test(node_map, i))
 					continue;
 				_select_cores(job_ptr, mc_ptr, enforce_binding,
@@ -4792,7 +5049,7 @@ static int _eval_nodes_lln(struct job_record *job_ptr,
 			    (total_cpus > details_ptr->max_cpus)) {
 				debug2("%s: %s: %pJ can't use node %d without exceeding job limit",
 				       plugin_type, __func__, job_ptr, i);
-				bit_clear(nwt->node_bitmap, i);
+				bit_clear(orig_node_map, i);
 				total_cpus -= avail_cpus;
 				continue;
 			}
@@ -4833,8 +5090,7 @@ static int _eval_nodes_lln(struct job_record *job_ptr,
 		error_code = SLURM_SUCCESS;
 	}
 
-fini:	FREE_NULL_LIST(node_weight_list);
-	bit_free(orig_node_map);
+fini:	bit_free(orig_node_map);
 	xfree(avail_cpu_per_node);
 	return error_code;
 }
@@ -4954,7 +5210,7 @@ static int _eval_nodes_serial(struct job_record *job_ptr,
 
 	if (max_nodes == 0)
 		all_done = true;
-	node_weight_list = _build_node_weight_list(orig_node_map);
+	node_weight_list = _get_node_weight_list();
 	iter = list_iterator_create(node_weight_list);
 	while (!all_done && (nwt = (node_weight_type *) list_next(iter))) {
 		for (i = i_end; ((i >= i_start) && (max_nodes > 0)); i--) {
@@ -4963,6 +5219,7 @@ static int _eval_nodes_serial(struct job_record *job_ptr,
 				continue;
 			/* Node not available or already selected */
 			if (!bit_test(nwt->node_bitmap, i) ||
+			    !bit_test(orig_node_map, i) ||
 			    bit_test(node_map, i))
 				continue;
 			_select_cores(job_ptr, mc_ptr, enforce_binding, i,
@@ -5018,8 +5275,7 @@ static int _eval_nodes_serial(struct job_record *job_ptr,
 		error_code = SLURM_SUCCESS;
 	}
 
-fini:	FREE_NULL_LIST(node_weight_list);
-	bit_free(orig_node_map);
+fini:	bit_free(orig_node_map);
 	return error_code;
 
 }
@@ -6037,9 +6293,104 @@ static void _set_gpu_defaults(struct job_record *job_ptr)
 				 mem_per_gpu);
 }
 
+/* Evaluate candidate nodes of args, RES_AVAIL_CHUNK at a time, until none
+ * remain. Called by _get_res_avail() and its helper threads. */
+static void _res_avail_nodes(res_avail_args_t *args)
+{
+	int i, i_first, i_last;
+
+	while (1) {
+		slurm_mutex_lock(&res_pool_mutex);
+		i_first = args->next_inx;
+		args->next_inx += RES_AVAIL_CHUNK;
+		slurm_mutex_unlock(&res_pool_mutex);
+		if (i_first > args->i_last)
+			break;
+		i_last = MIN(i_first + RES_AVAIL_CHUNK - 1, args->i_last);
+		for (i = i_first; i <= i_last; i++) {
+			if (!bit_test(args->node_map, i))
+				continue;
+			args->avail_res_array[i] = _can_job_run_on_node(
+					args->job_ptr, args->core_map, i,
+					args->s_p_n, args->node_usage,
+					args->cr_type, args->test_only,
+					args->part_core_map);
+		}
+	}
+}
+
+static void *_res_avail_thread(void *arg)
+{
+	uint32_t gen = 0;
+	res_avail_args_t *args;
+
+	slurm_mutex_lock(&res_pool_mutex);
+	while (1) {
+		while (!res_pool_shutdown && (gen == res_pool_gen))
+			slurm_cond_wait(&res_pool_cond, &res_pool_mutex);
+		if (res_pool_shutdown)
+			break;
+		gen = res_pool_gen;
+		if (!(args = res_pool_work))
+			continue;	/* Woke after the work was done */
+		res_pool_busy++;
+		slurm_mutex_unlock(&res_pool_mutex);
+
+		_res_avail_nodes(args);
+
+		slurm_mutex_lock(&res_pool_mutex);
+		if (--res_pool_busy == 0)
+			slurm_cond_signal(&res_pool_done_cond);
+	}
+	slurm_mutex_unlock(&res_pool_mutex);
+
+	return NULL;
+}
+
+/* Start thread_cnt helper threads. Call with res_pool_call_mutex locked. */
+static void _res_avail_pool_start(int thread_cnt)
+{
+	int i;
+
+	res_pool_shutdown = false;
+	res_pool_thread_cnt = thread_cnt;
+	res_pool_tids = xcalloc(thread_cnt, sizeof(pthread_t));
+	for (i = 0; i < thread_cnt; i++)
+		slurm_thread_create(&res_pool_tids[i], _res_avail_thread, NULL);
+}
+
+/* Stop all helper threads. Call with res_pool_call_mutex locked. */
+static void _res_avail_pool_stop(void)
+{
+	int i;
+
+	if (!res_pool_tids)
+		return;
+	slurm_mutex_lock(&res_pool_mutex);
+	res_pool_shutdown = true;
+	slurm_cond_broadcast(&res_pool_cond);
+	slurm_mutex_unlock(&res_pool_mutex);
+	for (i = 0; i < res_pool_thread_cnt; i++)
+		pthread_join(res_pool_tids[i], NULL);
+	xfree(res_pool_tids);
+	res_pool_thread_cnt = 0;
+}
+
+/* Stop the threads used by _get_res_avail(), called when unloading plugin */
+extern void res_avail_fini(void)
+{
+	slurm_mutex_lock(&res_pool_call_mutex);
+	_res_avail_pool_stop();
+	slurm_mutex_unlock(&res_pool_call_mutex);
+}
+
 /*
  * Determine resource availability for pending job
  *
+ * Each node is evaluated independently of the others, so when there are
+ * enough candidate nodes, up to select_threads threads evaluate them in
+ * parallel, each filling in different entries of the returned array.
+ *
  * IN: job_ptr       - pointer to the job requesting resources
  * IN: node_map      - bitmap of available nodes
  * IN/OUT: core_map  - per-node bitmaps of available cores
@@ -6056,27 +6407,60 @@ static avail_res_t **_get_res_avail(struct job_record *job_ptr,
 				    uint16_t cr_type, bool test_only,
 				    bitstr_t **part_core_map)
 {
-	int i, i_first, i_last;
-	avail_res_t **avail_res_array = NULL;
-	uint32_t s_p_n = _socks_per_node(job_ptr);
+	int i, i_first, thread_cnt = 1;
+	res_avail_args_t args;
 
 	_set_gpu_defaults(job_ptr);
-	avail_res_array = xmalloc(sizeof(avail_res_t *) * select_node_cnt);
+	memset(&args, 0, sizeof(args));
+	args.avail_res_array = xmalloc(sizeof(avail_res_t *) *
+				       select_node_cnt);
+	args.core_map = core_map;
+	args.cr_type = cr_type;
+	args.job_ptr = job_ptr;
+	args.node_map = node_map;
+	args.node_usage = node_usage;
+	args.part_core_map = part_core_map;
+	args.s_p_n = _socks_per_node(job_ptr);
+	args.test_only = test_only;
 	i_first = bit_ffs(node_map);
 	if (i_first >= 0)
-		i_last = bit_fls(node_map);
+		args.i_last = bit_fls(node_map);
 	else
-		i_last = i_first - 1;
-	for (i = i_first; i <= i_last; i++) {
-		if (!bit_test(node_map, i))
-			continue;
-		avail_res_array[i] = _can_job_run_on_node(job_ptr, core_map, i,
-							  s_p_n, node_usage,
-							  cr_type, test_only,
-							  part_core_map);
+		args.i_last = i_first - 1;
+	args.next_inx = i_first;
+
+	if ((select_threads > 1) && (i_first >= 0)) {
+		thread_cnt = bit_set_count(node_map) / RES_AVAIL_MIN_NODES;
+		thread_cnt = MIN(thread_cnt, select_threads);
+	}
+	/* Evaluate serially if another caller is using the helper threads */
+	if ((thread_cnt <= 1) ||
+	    (pthread_mutex_trylock(&res_pool_call_mutex) != 0)) {
+		_res_avail_nodes(&args);
+		return args.avail_res_array;
 	}
 
-	return avail_res_array;
+	if (res_pool_thread_cnt != (select_threads - 1)) {
+		_res_avail_pool_stop();
+		_res_avail_pool_start(select_threads - 1);
+	}
+	slurm_mutex_lock(&res_pool_mutex);
+	res_pool_work = &args;
+	res_pool_gen++;
+	for (i = 1; i < thread_cnt; i++)
+		slurm_cond_signal(&res_pool_cond);
+	slurm_mutex_unlock(&res_pool_mutex);
+
+	_res_avail_nodes(&args);
+
+	slurm_mutex_lock(&res_pool_mutex);
+	while (res_pool_busy)
+		slurm_cond_wait(&res_pool_done_cond, &res_pool_mutex);
+	res_pool_work = NULL;
+	slurm_mutex_unlock(&res_pool_mutex);
+	slurm_mutex_unlock(&res_pool_call_mutex);
+
+	return args.avail_res_array;
 }
 
 /*
@@ -6449,13 +6833,13 @@ top:	orig_node_map = bit_copy(save_node_map);
 		int preemptee_cand_cnt = list_count(preemptee_candidates);
 		/* Remove preemptable jobs from simulated environment */
 		preempt_mode = true;
-		future_part = _dup_part_data(select_part_record);
+		future_part = _cow_part_data(select_part_record);
 		if (future_part == NULL) {
 			FREE_NULL_BITMAP(orig_node_map);
 			FREE_NULL_BITMAP(save_node_map);
 			return SLURM_ERROR;
 		}
-		future_usage = _dup_node_usage(select_node_usage);
+		future_usage = _cow_node_usage(select_node_usage);
 		if (future_usage == NULL) {
 			cr_destroy_part_data(future_part);
 			FREE_NULL_BITMAP(orig_node_map);
@@ -6699,12 +7083,12 @@ extern int will_run_test(struct job_record *job_ptr, bitstr_t *node_bitmap,
 	 * Job is still pending. Simulate termination of jobs one at a time
 	 * to determine when and where the job can start.
 	 */
-	future_part = _dup_part_data(select_part_record);
+	future_part = _cow_part_data(select_part_record);
 	if (future_part == NULL) {
 		FREE_NULL_BITMAP(orig_map);
 		return SLURM_ERROR;
 	}
-	future_usage = _dup_node_usage(select_node_usage);
+	future_usage = _cow_node_usage(select_node_usage);
 	if (future_usage == NULL) {
 		cr_destroy_part_data(future_part);
 		FREE_NULL_BITMAP(orig_map);
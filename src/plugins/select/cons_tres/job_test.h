@@ -105,6 +105,18 @@ extern void core_array_or(bitstr_t **core_array1, bitstr_t **core_array2);
 /* Free an array of bitmaps, one per node */
 extern void free_core_array(bitstr_t ***core_array);
 
+/*
+ * Free the cached list of nodes by weight, call when node weights may have
+ * changed
+ */
+extern void free_node_weight_list(void);
+
+/*
+ * Free the cached list of nodes by weight if the weight of the node with
+ * index node_inx has changed
+ */
+extern void update_node_weight_list(int node_inx);
+
 /*
  * Get configured DefCpuPerGPU information from a list
  * (either global or per partition list)
@@ -160,6 +172,9 @@ extern int rm_job_res(struct part_res_record *part_record_ptr,
 		      struct node_use_record *node_usage,
 		      struct job_record *job_ptr, int action, bool job_fini);
 
+/* Stop the threads used to evaluate nodes, called when unloading plugin */
+extern void res_avail_fini(void);
+
 /* Allocate resources for a job now, if possible */
 extern int run_now(struct job_record *job_ptr, bitstr_t *node_bitmap,
 		   uint32_t min_nodes, uint32_t max_nodes,
@@ -41,6 +41,7 @@
 
 #include <inttypes.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "src/common/slurm_xlator.h"
 #include "src/common/assoc_mgr.h"
@@ -52,6 +53,10 @@
 #define _DEBUG 0	/* Enables module specific debugging */
 #define NODEINFO_MAGIC 0x8a5d
 
+/* Threads used to evaluate nodes, default limited by CPU count */
+#define DEFAULT_SELECT_THREADS 8
+#define MAX_SELECT_THREADS 64
+
 /*
  * These symbols are defined here so when we link with something other
  * than the slurmctld we will have these symbols defined. They will get
@@ -149,6 +154,7 @@ struct node_res_record *select_node_record	= NULL;
 struct node_use_record *select_node_usage	= NULL;
 struct part_res_record *select_part_record	= NULL;
 bool       select_state_initializing = true;
+int        select_threads	= 1;
 bool       spec_cores_first	= false;
 bitstr_t **spec_core_res	= NULL;
 bool       topo_optional	= false;
@@ -160,6 +166,7 @@ extern int select_p_select_nodeinfo_free(select_nodeinfo_t *nodeinfo);
 /* Local functions */
 static int _add_job_to_res(struct job_record *job_ptr, int action);
 static bitstr_t *_array_to_core_bitmap(bitstr_t **core_res);
+static void _build_node_switches(void);
 static bitstr_t **_core_bitmap_to_array(bitstr_t *core_bitmap);
 static struct multi_core_data * _create_default_mc(void);
 static void _create_part_data(void);
@@ -428,6 +435,42 @@ static bitstr_t *_array_to_core_bitmap(bitstr_t **core_array)
 	return core_bitmap;
 }
 
+/*
+ * Record in select_node_record the switches of every level with each node,
+ * so topology-aware node selection can find the switches of a set of nodes
+ * without testing every switch's node bitmap
+ */
+static void _build_node_switches(void)
+{
+	struct node_res_record *node_res_ptr;
+	struct switch_record *switch_ptr;
+	int i, i_first, i_last, n;
+
+	if (!switch_record_cnt || !switch_record_table)
+		return;
+
+	for (i = 0, switch_ptr = switch_record_table; i < switch_record_cnt;
+	     i++, switch_ptr++) {
+		if (!switch_ptr->node_bitmap)
+			continue;
+		i_first = bit_ffs(switch_ptr->node_bitmap);
+		if (i_first >= 0)
+			i_last = bit_fls(switch_ptr->node_bitmap);
+		else
+			i_last = -2;
+		i_last = MIN(i_last, select_node_cnt - 1);
+		for (n = i_first; n <= i_last; n++) {
+			if (!bit_test(switch_ptr->node_bitmap, n))
+				continue;
+			node_res_ptr = select_node_record + n;
+			xrealloc(node_res_ptr->switch_inx, sizeof(uint16_t) *
+				 (node_res_ptr->switch_cnt + 1));
+			node_res_ptr->switch_inx[node_res_ptr->switch_cnt] = i;
+			node_res_ptr->switch_cnt++;
+		}
+	}
+}
+
 static struct multi_core_data * _create_default_mc(void)
 {
 	struct multi_core_data *mc_ptr;
@@ -949,7 +992,9 @@ extern int fini(void)
 	cr_destroy_part_data(select_part_record);
 	select_part_record = NULL;
 	free_core_array(&spec_core_res);
+	free_node_weight_list();
 	cr_fini_global_core_data();
+	res_avail_fini();
 
 	return SLURM_SUCCESS;
 }
@@ -1046,6 +1091,21 @@ extern int select_p_node_init(struct node_record *node_ptr, int node_cnt)
 		backfill_busy_nodes = true;
 	else
 		backfill_busy_nodes = false;
+	if ((tmp_ptr = xstrcasestr(sched_params, "select_threads="))) {
+		select_threads = atoi(tmp_ptr + 15);
+		if ((select_threads < 1) ||
+		    (select_threads > MAX_SELECT_THREADS)) {
+			error("Invalid SchedulerParameters select_threads: %d",
+			      select_threads);
+			select_threads = 0;		/* Use default value */
+		}
+	} else
+		select_threads = 0;
+	if (select_threads == 0) {
+		select_threads = sysconf(_SC_NPROCESSORS_ONLN);
+		select_threads = MIN(select_threads, DEFAULT_SELECT_THREADS);
+		select_threads = MAX(select_threads, 1);
+	}
 	xfree(sched_params);
 
 	preempt_type = slurm_get_preempt_type();
@@ -1065,6 +1125,7 @@ extern int select_p_node_init(struct node_record *node_ptr, int node_cnt)
 	cr_init_global_core_data(node_ptr, node_cnt, select_fast_schedule);
 
 	cr_destroy_node_data(select_node_usage, select_node_record);
+	free_node_weight_list();
 	select_node_cnt = node_cnt;
 	select_node_record = xcalloc(node_cnt,
 				     sizeof(struct node_res_record));
@@ -1111,6 +1172,7 @@ extern int select_p_node_init(struct node_record *node_ptr, int node_cnt)
 		gres_plugin_node_state_dealloc_all(
 				select_node_record[i].node_ptr->gres_list);
 	}
+	_build_node_switches();
 	_create_part_data();
 	_dump_nodes();
 
@@ -2184,6 +2246,9 @@ extern int select_p_update_node_config(int index)
 		return SLURM_ERROR;
 	}
 
+	/* Node weight may have changed */
+	update_node_weight_list(index);
+
 	/*
 	 * Socket and core count can be changed when KNL node reboots in a
 	 * different NUMA configuration
@@ -2671,10 +2736,15 @@ extern void cr_destroy_node_data(struct node_use_record *node_usage,
 {
 	int i;
 
-	xfree(node_data);
+	if (node_data) {
+		for (i = 0; i < select_node_cnt; i++)
+			xfree(node_data[i].switch_inx);
+		xfree(node_data);
+	}
 	if (node_usage) {
 		for (i = 0; i < select_node_cnt; i++) {
-			FREE_NULL_LIST(node_usage[i].gres_list);
+			if (!node_usage[i].gres_cow)
+				FREE_NULL_LIST(node_usage[i].gres_list);
 		}
 		xfree(node_usage);
 	}
@@ -2705,10 +2775,15 @@ extern void cr_destroy_row_data(struct part_row_data *row, uint16_t num_rows)
 
 	for (r = 0; r < num_rows; r++) {
 		if (row[r].row_bitmap) {
-			for (n = 0; n < select_node_cnt; n++)
+			for (n = 0; n < select_node_cnt; n++) {
+				if (row[r].cow_bitmap &&
+				    bit_test(row[r].cow_bitmap, n))
+					continue;
 				FREE_NULL_BITMAP(row[r].row_bitmap[n]);
+			}
 			xfree(row[r].row_bitmap);
 		}
+		FREE_NULL_BITMAP(row[r].cow_bitmap);
 		xfree(row[r].job_list);
 	}
 	xfree(row);
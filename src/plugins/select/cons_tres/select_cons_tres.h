@@ -80,6 +80,9 @@ struct node_res_record {
 					 * core count */
 	uint64_t real_memory;		/* MB of real memory configured */
 	uint64_t mem_spec_limit;	/* MB of specialized/system memory */
+	uint16_t switch_cnt;		/* count of switches with this node */
+	uint16_t *switch_inx;		/* indexes in switch_record_table of
+					 * switches with this node, any level */
 };
 
 /* per-node resource usage record */
@@ -90,11 +93,15 @@ struct node_use_record {
 					 * defined in in src/common/gres.h.
 					 * Local data used only in state copy
 					 * to emulate future node state */
+	bool gres_cow;			/* gres_list shared with the state
+					 * copied from, copy before changing */
 	uint16_t node_state;		/* see node_cr_state comments */
 };
 
 /* a partition's per-row core allocation bitmap arrays (1 bitmap per node) */
 struct part_row_data {
+	bitstr_t *cow_bitmap;		/* nodes whose row_bitmap is shared with
+					 * the row copied from, NULL if none */
 	bitstr_t **row_bitmap;		/* contains core bitmap for all jobs in
 					 * this row, one bitstr_t for each node */
 	struct job_resources **job_list;/* List of jobs in this row */
@@ -105,6 +112,8 @@ struct part_row_data {
 /* partition core allocation bitmap arrays (1 bitmap per node) */
 struct part_res_record {
 	struct part_res_record *next;	/* Ptr to next part_res_record */
+	uint32_t hole_cnt;		/* Jobs removed from below jobs in
+					 * other rows since rows were packed */
 	uint16_t num_rows;		/* Number of elements in "row" array */
 	struct part_record *part_ptr;   /* controller part record pointer */
 	struct part_row_data *row;	/* array of rows containing jobs */
@@ -132,6 +141,7 @@ extern struct node_res_record *select_node_record;
 extern struct node_use_record *select_node_usage;
 extern struct part_res_record *select_part_record;
 extern bool	select_state_initializing;
+extern int	select_threads;
 extern bool	spec_cores_first;
 extern bitstr_t **spec_core_res;
 extern bool	topo_optional;
@@ -177,12 +177,51 @@ static void
 _load_job_records (void)
 {
 	int error_code;
+	job_info_filter_t filter;
+
+	/*
+	 * Let slurmctld skip jobs which _filter_job_records() would reject.
+	 * Explicitly named jobs must still be loaded for _verify_job_ids().
+	 */
+	memset(&filter, 0, sizeof(filter));
+	if (opt.job_cnt == 0) {
+		if (opt.account) {
+			filter.account_list = list_create(NULL);
+			list_append(filter.account_list, opt.account);
+		}
+		if (opt.job_name) {
+			filter.name_list = list_create(NULL);
+			list_append(filter.name_list, opt.job_name);
+		}
+		if (opt.partition) {
+			filter.part_list = list_create(slurm_destroy_char);
+			slurm_addto_char_list_with_case(filter.part_list,
+							opt.partition, false);
+		}
+		if (opt.state != JOB_END) {
+			filter.state_list = list_create(NULL);
+			list_append(filter.state_list, &opt.state);
+		}
+		if (opt.user_name) {
+			filter.user_list = list_create(NULL);
+			list_append(filter.user_list, &opt.user_id);
+		}
+	}
+	filter.skip_fields = JOB_FIELD_COMMENT | JOB_FIELD_COMMAND |
+			     JOB_FIELD_STD_IO | JOB_FIELD_NODE_INX |
+			     JOB_FIELD_TRES_FMT;
 
 	/* We need the fill job array string representation for identifying
 	 * and killing job arrays */
 	setenv("SLURM_BITSTR_LEN", "0", 1);
-	error_code = slurm_load_jobs ((time_t) NULL, &job_buffer_ptr,
-				      SHOW_ALL | SHOW_FEDERATION);
+	error_code = slurm_load_jobs_filter((time_t) NULL, &job_buffer_ptr,
+					    SHOW_ALL | SHOW_FEDERATION,
+					    &filter);
+	FREE_NULL_LIST(filter.account_list);
+	FREE_NULL_LIST(filter.name_list);
+	FREE_NULL_LIST(filter.part_list);
+	FREE_NULL_LIST(filter.state_list);
+	FREE_NULL_LIST(filter.user_list);
 
 	if (error_code) {
 		slurm_perror ("slurm_load_jobs error");
@@ -48,6 +48,8 @@
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
+#define LOCK_SITE_TOP 10	/* lock call sites to report */
+
 /********************
  * Global Variables *
  ********************/
@@ -187,6 +189,94 @@ static int _print_stats(void)
 	printf("\nLatency for 1000 calls to gettimeofday(): %d microseconds\n",
 	       buf->gettimeofday_latency);
 
+	printf("\nRPC worker pool statistics\n");
+	printf("\tWorker threads: %u\n", buf->rpc_pool_workers);
+	printf("\tBusy workers: %u\n", buf->rpc_pool_busy);
+	if (buf->rpc_pool_workers &&
+	    (buf->req_time > buf->req_time_start)) {
+		printf("\tWorker utilization: %.1f%%\n",
+		       (double) buf->rpc_pool_busy_time * 100.0 /
+		       ((double) buf->rpc_pool_workers * 1000000.0 *
+			(buf->req_time - buf->req_time_start)));
+	}
+	printf("\tConnections awaiting data: %u\n", buf->rpc_pool_pending);
+	printf("\tQueue length: %u\n", buf->rpc_pool_queue_len);
+	printf("\tMax queue length: %u\n", buf->rpc_pool_queue_max);
+	printf("\tTotal queued: %u\n", buf->rpc_pool_queue_cnt);
+	if (buf->rpc_pool_queue_cnt > 0) {
+		printf("\tMean queue wait (microseconds): %"PRIu64"\n",
+		       buf->rpc_pool_queue_wait / buf->rpc_pool_queue_cnt);
+	}
+	printf("\tAccept throttled: %u\n", buf->rpc_pool_throttled);
+
+	if (buf->rpc_class_size)
+		printf("\nRPC worker statistics by priority class\n");
+	for (i = 0; i < buf->rpc_class_size; i++) {
+		uint32_t cnt = buf->rpc_class_cnt[i];
+
+		printf("\t%-6s weight:%-4u queued:%-5u count:%-8u "
+		       "ave_wait:%-8"PRIu64" ave_time:%-8"PRIu64" "
+		       "max_time:%u\n",
+		       buf->rpc_class_name[i], buf->rpc_class_weight[i],
+		       buf->rpc_class_queue_len[i], cnt,
+		       cnt ? buf->rpc_class_wait[i] / cnt : 0,
+		       cnt ? buf->rpc_class_time[i] / cnt : 0,
+		       buf->rpc_class_time_max[i]);
+	}
+
+	if (buf->lock_stat_size) {
+		printf("\nLock contention statistics by call site "
+		       "(top %d by wait time)\n", LOCK_SITE_TOP);
+		printf("\tHistogram buckets: <10us <100us <1ms <10ms <100ms "
+		       "<1s >=1s\n");
+	}
+	for (i = 0; (i < buf->lock_stat_size) && (i < LOCK_SITE_TOP); i++) {
+		uint32_t cnt = buf->lock_stat_cnt[i], j;
+		uint32_t *wait_hist, *hold_hist;
+
+		printf("\t%-40s %s\n", buf->lock_stat_site[i],
+		       buf->lock_stat_type[i]);
+		printf("\t\tcount:%-8u ave_wait:%-8"PRIu64" max_wait:%-8u "
+		       "ave_hold:%-8"PRIu64" max_hold:%u\n",
+		       cnt, cnt ? buf->lock_stat_wait_time[i] / cnt : 0,
+		       buf->lock_stat_wait_max[i],
+		       cnt ? buf->lock_stat_hold_time[i] / cnt : 0,
+		       buf->lock_stat_hold_max[i]);
+		wait_hist = &buf->lock_stat_wait_hist[i *
+						      buf->lock_stat_buckets];
+		hold_hist = &buf->lock_stat_hold_hist[i *
+						      buf->lock_stat_buckets];
+		printf("\t\twait_hist:");
+		for (j = 0; j < buf->lock_stat_buckets; j++)
+			printf(" %u", wait_hist[j]);
+		printf("\n\t\thold_hist:");
+		for (j = 0; j < buf->lock_stat_buckets; j++)
+			printf(" %u", hold_hist[j]);
+		printf("\n");
+	}
+
+	if (buf->msg_aggr_cnt || buf->kill_aggr_windows)
+		printf("\nMessage aggregation statistics\n");
+	if (buf->msg_aggr_cnt) {
+		printf("\tComposite messages received: %u\n",
+		       buf->msg_aggr_cnt);
+		printf("\tMean messages per composite: %u\n",
+		       buf->msg_aggr_msgs / buf->msg_aggr_cnt);
+		printf("\tMax messages per composite: %u\n",
+		       buf->msg_aggr_max);
+	}
+	if (buf->kill_aggr_windows) {
+		printf("\tKill RPC windows sent: %u\n",
+		       buf->kill_aggr_windows);
+		printf("\tKill RPC windows filled: %u (%u%%)\n",
+		       buf->kill_aggr_full,
+		       (buf->kill_aggr_full * 100) / buf->kill_aggr_windows);
+		printf("\tMean kill RPCs per window: %u\n",
+		       buf->kill_aggr_msgs / buf->kill_aggr_windows);
+		printf("\tMax kill RPCs per window: %u\n",
+		       buf->kill_aggr_max);
+	}
+
 	printf("\nRemote Procedure Call statistics by message type\n");
 	for (i = 0; i < buf->rpc_type_size; i++) {
 		printf("\t%-40s(%5u) count:%-6u "
@@ -69,6 +69,20 @@ typedef struct pack_limits {
 	slurmdb_qos_rec_t *qos_ptr_2;
 } pack_limits_t;
 
+/* Offsets of the limit types in an association's grp_tres_headroom */
+enum {
+	HEADROOM_GRP_TRES,
+	HEADROOM_GRP_TRES_MINS,
+	HEADROOM_GRP_TRES_RUN_MINS,
+	HEADROOM_CNT
+};
+
+/*
+ * Protects grp_tres_headroom, which is rebuilt while holding only the
+ * assoc_mgr association read lock
+ */
+static pthread_mutex_t headroom_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * Update a job's allocated node count to reflect only nodes that are not
  * already allocated to this association.  Needed to enforce GrpNode limit.
@@ -1482,6 +1496,109 @@ static acct_policy_tres_usage_t _validate_tres_usage_limits_for_assoc(
 					   false);
 }
 
+/*
+ * Return the room left under a group limit, plus one. A request fits iff it
+ * is less than the returned value, so 0 means no request fits (usage is
+ * already over the limit).
+ */
+static uint64_t _grp_headroom(uint64_t limit, uint64_t used)
+{
+	if (limit == INFINITE64)
+		return INFINITE64;
+	if (used > limit)
+		return 0;
+	return (limit - used) + 1;
+}
+
+/*
+ * Get the association's grp_tres_headroom, the smallest room left under the
+ * GrpTRES, GrpTRESMins and GrpTRESRunMins limits of the association and all
+ * of its parents, indexed by (HEADROOM_* * g_tres_count) + tres_pos and in
+ * the form returned by _grp_headroom(). The array is only rebuilt after the
+ * association write lock has been taken since it was last built, which is
+ * required to change usage (e.g. acct_policy_job_begin/fini) or limits.
+ * NOTE: Call with assoc_mgr association and TRES read locks and
+ *	 headroom_mutex held
+ */
+static uint64_t *_get_grp_tres_headroom(slurmdb_assoc_rec_t *assoc_ptr)
+{
+	slurmdb_assoc_usage_t *usage = assoc_ptr->usage;
+	uint64_t *headroom, *parent_headroom = NULL;
+	uint64_t run_mins, usage_mins, used;
+	int i;
+
+	if (usage->grp_tres_headroom &&
+	    (usage->grp_tres_headroom_gen == assoc_mgr_assoc_gen))
+		return usage->grp_tres_headroom;
+
+	if (usage->parent_assoc_ptr)
+		parent_headroom =
+			_get_grp_tres_headroom(usage->parent_assoc_ptr);
+
+	xrealloc(usage->grp_tres_headroom,
+		 sizeof(uint64_t) * g_tres_count * HEADROOM_CNT);
+	usage->grp_tres_headroom_gen = assoc_mgr_assoc_gen;
+	headroom = usage->grp_tres_headroom;
+	for (i = 0; i < g_tres_count; i++) {
+		run_mins = usage->grp_used_tres_run_secs[i] / 60;
+		usage_mins = (uint64_t)(usage->usage_tres_raw[i] / 60);
+
+		headroom[i] = _grp_headroom(assoc_ptr->grp_tres_ctld[i],
+					    usage->grp_used_tres[i]);
+		/* GrpTRESMins is also exceeded once usage reaches it */
+		if ((assoc_ptr->grp_tres_mins_ctld[i] != INFINITE64) &&
+		    (usage_mins >= assoc_ptr->grp_tres_mins_ctld[i]))
+			used = INFINITE64;
+		else
+			used = usage_mins + run_mins;
+		headroom[g_tres_count + i] =
+			_grp_headroom(assoc_ptr->grp_tres_mins_ctld[i], used);
+		headroom[(2 * g_tres_count) + i] =
+			_grp_headroom(assoc_ptr->grp_tres_run_mins_ctld[i],
+				      run_mins);
+	}
+	if (parent_headroom) {
+		for (i = 0; i < (g_tres_count * HEADROOM_CNT); i++)
+			headroom[i] = MIN(headroom[i], parent_headroom[i]);
+	}
+
+	return headroom;
+}
+
+/*
+ * Test if a job fits within every group TRES limit of its association and
+ * the association's parents. If so, none of the association group limits
+ * tested in acct_policy_job_runnable_post_select() can hold the job. If not,
+ * the job must be tested level by level as some limits may be overridden by
+ * the job's QOS or by an administrator.
+ * IN tres_req_cnt - TRES requested by the job
+ * IN job_tres_time_limit - TRES minutes requested by the job
+ * NOTE: Call with assoc_mgr association and TRES read locks held
+ */
+static bool _grp_tres_headroom_fits(slurmdb_assoc_rec_t *assoc_ptr,
+				    uint64_t *tres_req_cnt,
+				    uint64_t *job_tres_time_limit)
+{
+	uint64_t *headroom;
+	bool fits = true;
+	int i;
+
+	slurm_mutex_lock(&headroom_mutex);
+	headroom = _get_grp_tres_headroom(assoc_ptr);
+	for (i = 0; i < g_tres_count; i++) {
+		if ((tres_req_cnt[i] >= headroom[i]) ||
+		    (job_tres_time_limit[i] >= headroom[g_tres_count + i]) ||
+		    (job_tres_time_limit[i] >=
+		     headroom[(2 * g_tres_count) + i])) {
+			fits = false;
+			break;
+		}
+	}
+	slurm_mutex_unlock(&headroom_mutex);
+
+	return fits;
+}
+
 static int _qos_policy_validate(job_desc_msg_t *job_desc,
 				slurmdb_assoc_rec_t *assoc_ptr,
 				struct part_record *part_ptr,
@@ -2505,6 +2622,7 @@ static int _qos_job_time_out(struct job_record *job_ptr,
 	switch (tres_usage) {
 	case TRES_USAGE_CUR_EXCEEDS_LIMIT:
 		last_job_update = now;
+		job_mark_dirty(job_ptr);
 		info("%pJ timed out, the job is at or exceeds QOS %s's group max tres(%s) minutes of %"PRIu64" with %"PRIu64"",
 		     job_ptr, qos_ptr->name,
 		     assoc_mgr_tres_name_array[tres_pos],
@@ -2530,6 +2648,7 @@ static int _qos_job_time_out(struct job_record *job_ptr,
 
 		if (wall_mins >= qos_ptr->grp_wall) {
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			info("%pJ timed out, the job is at or exceeds QOS %s's group wall limit of %u with %u",
 			     job_ptr, qos_ptr->name,
 			     qos_ptr->grp_wall, wall_mins);
@@ -2549,6 +2668,7 @@ static int _qos_job_time_out(struct job_record *job_ptr,
 		break;
 	case TRES_USAGE_REQ_EXCEEDS_LIMIT:
 		last_job_update = now;
+		job_mark_dirty(job_ptr);
 		info("%pJ timed out, the job is at or exceeds QOS %s's max tres(%s) minutes of %"PRIu64" with %"PRIu64,
 		     job_ptr, qos_ptr->name,
 		     assoc_mgr_tres_name_array[tres_pos],
@@ -3604,6 +3724,78 @@ end_it:
 	return rc;
 }
 
+/*
+ * Test the job against the per job and per node TRES limits of its own
+ * association. Parent associations' limits of these types have already been
+ * propagated to the association.
+ * RET true if the job can run, otherwise false with the job's state_reason set
+ */
+static bool _assoc_job_runnable_post_select(struct job_record *job_ptr,
+					    slurmdb_assoc_rec_t *assoc_ptr,
+					    slurmdb_qos_rec_t *qos_rec,
+					    uint64_t *tres_req_cnt,
+					    uint64_t *job_tres_time_limit)
+{
+	int tres_pos = 0;
+
+	if (!_validate_tres_limits_for_assoc(
+		    &tres_pos, job_tres_time_limit, 0,
+		    assoc_ptr->max_tres_mins_ctld,
+		    qos_rec->max_tres_mins_pj_ctld,
+		    job_ptr->limit_set.tres,
+		    1, 0, 1)) {
+		xfree(job_ptr->state_desc);
+		job_ptr->state_reason = _get_tres_state_reason(
+			tres_pos, WAIT_ASSOC_MAX_UNK_MINS_PER_JOB);
+		debug2("%pJ being held, the job is requesting more than allowed with assoc %u(%s/%s/%s) max tres(%s) minutes of %"PRIu64" with %"PRIu64,
+		       job_ptr, assoc_ptr->id, assoc_ptr->acct,
+		       assoc_ptr->user, assoc_ptr->partition,
+		       assoc_mgr_tres_name_array[tres_pos],
+		       assoc_ptr->max_tres_mins_ctld[tres_pos],
+		       job_tres_time_limit[tres_pos]);
+		return false;
+	}
+
+	if (!_validate_tres_limits_for_assoc(
+		    &tres_pos, tres_req_cnt, 0,
+		    assoc_ptr->max_tres_ctld,
+		    qos_rec->max_tres_pj_ctld,
+		    job_ptr->limit_set.tres,
+		    1, 0, 1)) {
+		xfree(job_ptr->state_desc);
+		job_ptr->state_reason = _get_tres_state_reason(
+			tres_pos, WAIT_ASSOC_MAX_UNK_PER_JOB);
+		debug2("%pJ is being held, the job is requesting more than allowed with assoc %u(%s/%s/%s) max tres(%s) limit of %"PRIu64" with %"PRIu64,
+		       job_ptr, assoc_ptr->id, assoc_ptr->acct,
+		       assoc_ptr->user, assoc_ptr->partition,
+		       assoc_mgr_tres_name_array[tres_pos],
+		       assoc_ptr->max_tres_ctld[tres_pos],
+		       tres_req_cnt[tres_pos]);
+		return false;
+	}
+
+	if (!_validate_tres_limits_for_assoc(
+		    &tres_pos, tres_req_cnt,
+		    tres_req_cnt[TRES_ARRAY_NODE],
+		    assoc_ptr->max_tres_pn_ctld,
+		    qos_rec->max_tres_pn_ctld,
+		    job_ptr->limit_set.tres,
+		    1, 0, 1)) {
+		xfree(job_ptr->state_desc);
+		job_ptr->state_reason = _get_tres_state_reason(
+			tres_pos, WAIT_ASSOC_MAX_UNK_PER_NODE);
+		debug2("%pJ is being held, the job is requesting more than allowed with assoc %u(%s/%s/%s) max tres(%s) per node limit of %"PRIu64" with %"PRIu64,
+		       job_ptr, assoc_ptr->id, assoc_ptr->acct,
+		       assoc_ptr->user, assoc_ptr->partition,
+		       assoc_mgr_tres_name_array[tres_pos],
+		       assoc_ptr->max_tres_pn_ctld[tres_pos],
+		       tres_req_cnt[tres_pos]);
+		return false;
+	}
+
+	return true;
+}
+
 /*
  * acct_policy_job_runnable_post_select - After nodes have been
  *	selected for the job verify the counts don't exceed aggregated limits.
@@ -3707,6 +3899,20 @@ extern bool acct_policy_job_runnable_post_select(
 		goto end_it;
 
 	assoc_ptr = job_ptr->assoc_ptr;
+
+	/*
+	 * If the job fits under the group limits of every association up the
+	 * tree, only the association's own limits need to be tested
+	 */
+	if (assoc_ptr &&
+	    _grp_tres_headroom_fits(assoc_ptr, tres_req_cnt,
+				    job_tres_time_limit)) {
+		rc = _assoc_job_runnable_post_select(job_ptr, assoc_ptr,
+						     &qos_rec, tres_req_cnt,
+						     job_tres_time_limit);
+		goto end_it;
+	}
+
 	while (assoc_ptr) {
 		for (i = 0; i < slurmctld_tres_cnt; i++) {
 			tres_usage_mins[i] =
@@ -3899,63 +4105,10 @@ extern bool acct_policy_job_runnable_post_select(
 			continue;
 		}
 
-		if (!_validate_tres_limits_for_assoc(
-			    &tres_pos, job_tres_time_limit, 0,
-			    assoc_ptr->max_tres_mins_ctld,
-			    qos_rec.max_tres_mins_pj_ctld,
-			    job_ptr->limit_set.tres,
-			    1, 0, 1)) {
-			xfree(job_ptr->state_desc);
-			job_ptr->state_reason = _get_tres_state_reason(
-				tres_pos, WAIT_ASSOC_MAX_UNK_MINS_PER_JOB);
-			debug2("%pJ being held, the job is requesting more than allowed with assoc %u(%s/%s/%s) max tres(%s) minutes of %"PRIu64" with %"PRIu64,
-			       job_ptr, assoc_ptr->id, assoc_ptr->acct,
-			       assoc_ptr->user, assoc_ptr->partition,
-			       assoc_mgr_tres_name_array[tres_pos],
-			       assoc_ptr->max_tres_mins_ctld[tres_pos],
-			       job_tres_time_limit[tres_pos]);
-			rc = false;
+		if (!(rc = _assoc_job_runnable_post_select(
+			      job_ptr, assoc_ptr, &qos_rec, tres_req_cnt,
+			      job_tres_time_limit)))
 			goto end_it;
-		}
-
-		if (!_validate_tres_limits_for_assoc(
-			    &tres_pos, tres_req_cnt, 0,
-			    assoc_ptr->max_tres_ctld,
-			    qos_rec.max_tres_pj_ctld,
-			    job_ptr->limit_set.tres,
-			    1, 0, 1)) {
-			xfree(job_ptr->state_desc);
-			job_ptr->state_reason = _get_tres_state_reason(
-				tres_pos, WAIT_ASSOC_MAX_UNK_PER_JOB);
-			debug2("%pJ is being held, the job is requesting more than allowed with assoc %u(%s/%s/%s) max tres(%s) limit of %"PRIu64" with %"PRIu64,
-			       job_ptr, assoc_ptr->id, assoc_ptr->acct,
-			       assoc_ptr->user, assoc_ptr->partition,
-			       assoc_mgr_tres_name_array[tres_pos],
-			       assoc_ptr->max_tres_ctld[tres_pos],
-			       tres_req_cnt[tres_pos]);
-			rc = false;
-			break;
-		}
-
-		if (!_validate_tres_limits_for_assoc(
-			    &tres_pos, tres_req_cnt,
-			    tres_req_cnt[TRES_ARRAY_NODE],
-			    assoc_ptr->max_tres_pn_ctld,
-			    qos_rec.max_tres_pn_ctld,
-			    job_ptr->limit_set.tres,
-			    1, 0, 1)) {
-			xfree(job_ptr->state_desc);
-			job_ptr->state_reason = _get_tres_state_reason(
-				tres_pos, WAIT_ASSOC_MAX_UNK_PER_NODE);
-			debug2("%pJ is being held, the job is requesting more than allowed with assoc %u(%s/%s/%s) max tres(%s) per node limit of %"PRIu64" with %"PRIu64,
-			       job_ptr, assoc_ptr->id, assoc_ptr->acct,
-			       assoc_ptr->user, assoc_ptr->partition,
-			       assoc_mgr_tres_name_array[tres_pos],
-			       assoc_ptr->max_tres_pn_ctld[tres_pos],
-			       tres_req_cnt[tres_pos]);
-			rc = false;
-			break;
-		}
 
 		/* we do not need to check max_jobs here */
 
@@ -4160,6 +4313,7 @@ extern int acct_policy_update_pending_job(struct job_record *job_ptr)
 
 	if (update_accounting) {
 		last_job_update = time(NULL);
+		job_mark_dirty(job_ptr);
 		debug("limits changed for %pJ: updating accounting", job_ptr);
 		/* Update job record in accounting to reflect changes */
 		jobacct_storage_job_start_direct(acct_db_conn, job_ptr);
@@ -4254,6 +4408,7 @@ extern bool acct_policy_job_time_out(struct job_record *job_ptr)
 		switch (tres_usage) {
 		case TRES_USAGE_CUR_EXCEEDS_LIMIT:
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			info("%pJ timed out, the job is at or exceeds assoc %u(%s/%s/%s) group max tres(%s) minutes of %"PRIu64" with %"PRIu64,
 			     job_ptr, assoc->id, assoc->acct,
 			     assoc->user, assoc->partition,
@@ -4295,6 +4450,7 @@ extern bool acct_policy_job_time_out(struct job_record *job_ptr)
 			break;
 		case TRES_USAGE_REQ_EXCEEDS_LIMIT:
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			info("%pJ timed out, the job is at or exceeds assoc %u(%s/%s/%s) max tres(%s) minutes of %"PRIu64" with %"PRIu64,
 			     job_ptr, assoc->id, assoc->acct,
 			     assoc->user, assoc->partition,
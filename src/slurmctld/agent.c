@@ -55,6 +55,13 @@
  *  communicated with up to AGENT_THREAD_COUNT. A special watchdog thread
  *  sends SIGLARM to any threads that have been active (in DSH_ACTIVE state)
  *  for more than MessageTimeout seconds.
+ *  RPCs sent directly to each node without waiting for a reply (e.g.
+ *  REQUEST_RECONFIGURE) use no additional threads. The main agent thread
+ *  writes them out on up to AGENT_POLL_CONN_COUNT non-blocking connections
+ *  at a time, polling all of them at once.
+ *  With MsgAggregationParams WindowMsgs > 1, job kill RPCs are held for a
+ *  collection window and each node is sent those of its jobs ending in the
+ *  window as one REQUEST_TERMINATE_JOB_AGGR.
  *  The agent responds to slurmctld via a function call or an RPC as required.
  *  For example, informing slurmctld that some node is not responding.
  *
@@ -69,23 +76,33 @@
 #endif
 
 #include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
 #include <pthread.h>
 #include <pwd.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include "src/common/bitstring.h"
+#include "src/common/fd.h"
 #include "src/common/forward.h"
 #include "src/common/list.h"
 #include "src/common/log.h"
 #include "src/common/macros.h"
 #include "src/common/node_select.h"
 #include "src/common/parse_time.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_auth.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_interface.h"
+#include "src/common/slurm_protocol_pack.h"
+#include "src/common/timers.h"
 #include "src/common/uid.h"
 #include "src/common/xsignal.h"
 #include "src/common/xassert.h"
@@ -105,6 +122,11 @@
 #define RPC_PACK_MAX_AGE	30	/* Rebuild data over 30 seconds old */
 #define DUMP_RPC_COUNT 		25
 #define HOSTLIST_MAX_SIZE 	80
+#define AGENT_POLL_CONN_COUNT	256	/* maximum connections in progress
+					 * per polling agent */
+#define POLL_CLOSE_WAIT		1000	/* msec to wait for the peer to close
+					 * a polled connection, as
+					 * slurm_send_only_node_msg() does */
 
 typedef enum {
 	DSH_NEW,        /* Request not yet started */
@@ -162,6 +184,16 @@ typedef struct task_info {
 	uint16_t protocol_version;	/* if set, use this version */
 } task_info_t;
 
+typedef struct poll_conn {
+	int fd;				/* non-blocking connection */
+	Buf buffer;			/* packed message */
+	uint32_t sent_bytes;		/* bytes of buffer written */
+	bool connected;			/* connect() completed */
+	bool sent;			/* all of buffer written */
+	int64_t deadline;		/* msec time limit of current step */
+	thd_t *thread_ptr;		/* node state record */
+} poll_conn_t;
+
 typedef struct queued_request {
 	agent_arg_t* agent_arg_ptr;	/* The queued request */
 	time_t       first_attempt;	/* Time of first check for batch
@@ -169,6 +201,12 @@ typedef struct queued_request {
 	time_t       last_attempt;	/* Time of last xmit attempt */
 } queued_request_t;
 
+/* Nodes which are sent the same kill RPCs of one collection window */
+typedef struct {
+	bitstr_t *kill_bitmap;	/* kill RPCs by position in the window */
+	hostlist_t hostlist;
+} kill_aggr_group_t;
+
 typedef struct mail_info {
 	char *user_name;
 	char *message;
@@ -177,17 +215,24 @@ typedef struct mail_info {
 static void _agent_defer(void);
 static void _agent_retry(int min_wait, bool wait_too);
 static int  _batch_launch_defer(queued_request_t *queued_req_ptr);
+static bool _kill_aggr_add(queued_request_t *queued_req_ptr);
+static bool _kill_aggr_flush(bool force);
+static void _kill_aggr_wait_time(struct timespec *ts);
 static void _reboot_from_ctld(agent_arg_t *agent_arg_ptr);
 static int  _signal_defer(queued_request_t *queued_req_ptr);
 static inline int _comm_err(char *node_name, slurm_msg_type_t msg_type);
 static void _list_delete_retry(void *retry_entry);
 static agent_info_t *_make_agent_info(agent_arg_t *agent_arg_ptr);
 static task_info_t *_make_task_data(agent_info_t *agent_info_ptr, int inx);
+static bool _is_direct_msg(slurm_msg_type_t msg_type);
+static bool _is_srun_msg(slurm_msg_type_t msg_type);
 static void _notify_slurmctld_jobs(agent_info_t *agent_ptr);
 static void _notify_slurmctld_nodes(agent_info_t *agent_ptr,
 		int no_resp_cnt, int retry_cnt);
+static void _poll_direct_rpcs(agent_info_t *agent_ptr);
 static void _purge_agent_args(agent_arg_t *agent_arg_ptr);
 static void _queue_agent_retry(agent_info_t * agent_info_ptr, int count);
+static void _record_node_data(ret_data_info_t *ret_data_info);
 static int  _setup_requeue(agent_arg_t *agent_arg_ptr, thd_t *thread_ptr,
 			   int *count, int *spot);
 static void _sig_handler(int dummy);
@@ -209,6 +254,15 @@ static List defer_list = NULL;		/* agent_arg_t list for requests
 static List mail_list = NULL;		/* pending e-mail requests */
 static List retry_list = NULL;		/* agent_arg_t list for retry */
 
+static pthread_mutex_t kill_aggr_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List kill_aggr_list = NULL;	/* kill RPCs of the current collection
+					 * window, queued_request_t */
+static struct timeval kill_aggr_start;	/* start of collection window */
+static struct timeval kill_aggr_sent;	/* last kill RPCs were sent */
+static int kill_aggr_msgs = DEFAULT_MSG_AGGR_WINDOW_MSGS;
+static int kill_aggr_time = DEFAULT_MSG_AGGR_WINDOW_TIME; /* msec */
+static time_t kill_aggr_config = 0;	/* slurmctld_conf.last_update read */
+
 
 static pthread_mutex_t agent_cnt_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  agent_cnt_cond  = PTHREAD_COND_INITIALIZER;
@@ -248,7 +302,7 @@ void *agent(void *args)
 	thd_t *thread_ptr;
 	task_info_t *task_specific_ptr;
 	time_t begin_time;
-	bool spawn_retry_agent = false;
+	bool spawn_retry_agent = false, poll_rpcs;
 	int rpc_thread_cnt;
 	static time_t sched_update = 0;
 	static bool reboot_from_ctld = false;
@@ -281,7 +335,12 @@ void *agent(void *args)
 		sched_update = slurmctld_conf.last_update;
 	}
 
-	rpc_thread_cnt = 2 + MIN(agent_arg_ptr->node_count, AGENT_THREAD_COUNT);
+	poll_rpcs = _is_direct_msg(agent_arg_ptr->msg_type);
+	if (poll_rpcs)
+		rpc_thread_cnt = 1;
+	else
+		rpc_thread_cnt = 2 + MIN(agent_arg_ptr->node_count,
+					 AGENT_THREAD_COUNT);
 	while (1) {
 		if (slurmctld_config.shutdown_time ||
 		    ((agent_thread_cnt+rpc_thread_cnt) <= MAX_SERVER_THREADS)) {
@@ -311,6 +370,13 @@ void *agent(void *args)
 	agent_info_ptr = _make_agent_info(agent_arg_ptr);
 	thread_ptr = agent_info_ptr->thread_struct;
 
+	if (poll_rpcs) {
+		_poll_direct_rpcs(agent_info_ptr);
+		/* Every RPC is complete, this only notifies slurmctld */
+		_wdog(agent_info_ptr);
+		goto cleanup;
+	}
+
 	/* start the watchdog thread */
 	slurm_thread_create(&thread_wdog, _wdog, agent_info_ptr);
 
@@ -446,18 +512,7 @@ static agent_info_t *_make_agent_info(agent_arg_t *agent_arg_ptr)
 	agent_info_ptr->msg_args_pptr  = &agent_arg_ptr->msg_args;
 	agent_info_ptr->protocol_version = agent_arg_ptr->protocol_version;
 
-	if ((agent_arg_ptr->msg_type != REQUEST_JOB_NOTIFY)	&&
-	    (agent_arg_ptr->msg_type != REQUEST_REBOOT_NODES)	&&
-	    (agent_arg_ptr->msg_type != REQUEST_RECONFIGURE)	&&
-	    (agent_arg_ptr->msg_type != REQUEST_SHUTDOWN)	&&
-	    (agent_arg_ptr->msg_type != SRUN_EXEC)		&&
-	    (agent_arg_ptr->msg_type != SRUN_TIMEOUT)		&&
-	    (agent_arg_ptr->msg_type != SRUN_NODE_FAIL)		&&
-	    (agent_arg_ptr->msg_type != SRUN_REQUEST_SUSPEND)	&&
-	    (agent_arg_ptr->msg_type != SRUN_USER_MSG)		&&
-	    (agent_arg_ptr->msg_type != SRUN_STEP_MISSING)	&&
-	    (agent_arg_ptr->msg_type != SRUN_STEP_SIGNAL)	&&
-	    (agent_arg_ptr->msg_type != SRUN_JOB_COMPLETE)) {
+	if (!_is_direct_msg(agent_arg_ptr->msg_type)) {
 #ifdef HAVE_FRONT_END
 		span = set_span(agent_arg_ptr->node_count,
 				agent_arg_ptr->node_count);
@@ -517,6 +572,45 @@ static agent_info_t *_make_agent_info(agent_arg_t *agent_arg_ptr)
 	return agent_info_ptr;
 }
 
+/*
+ * Return true if msg_type is sent directly to each node (or srun) without
+ * waiting for a reply, rather than forwarded through the slurmd
+ */
+static bool _is_direct_msg(slurm_msg_type_t msg_type)
+{
+	if ((msg_type == REQUEST_JOB_NOTIFY)	||
+	    (msg_type == REQUEST_REBOOT_NODES)	||
+	    (msg_type == REQUEST_RECONFIGURE)	||
+	    (msg_type == REQUEST_SHUTDOWN)	||
+	    (msg_type == SRUN_EXEC)		||
+	    (msg_type == SRUN_TIMEOUT)		||
+	    (msg_type == SRUN_NODE_FAIL)	||
+	    (msg_type == SRUN_REQUEST_SUSPEND)	||
+	    (msg_type == SRUN_USER_MSG)		||
+	    (msg_type == SRUN_STEP_MISSING)	||
+	    (msg_type == SRUN_STEP_SIGNAL)	||
+	    (msg_type == SRUN_JOB_COMPLETE))
+		return true;
+	return false;
+}
+
+/* Return true if msg_type is sent to srun, whose failures say nothing of
+ * the node's state */
+static bool _is_srun_msg(slurm_msg_type_t msg_type)
+{
+	if ((msg_type == SRUN_PING)			||
+	    (msg_type == SRUN_EXEC)			||
+	    (msg_type == SRUN_JOB_COMPLETE)		||
+	    (msg_type == SRUN_STEP_MISSING)		||
+	    (msg_type == SRUN_STEP_SIGNAL)		||
+	    (msg_type == SRUN_TIMEOUT)			||
+	    (msg_type == SRUN_USER_MSG)			||
+	    (msg_type == RESPONSE_RESOURCE_ALLOCATION)	||
+	    (msg_type == SRUN_NODE_FAIL))
+		return true;
+	return false;
+}
+
 static task_info_t *_make_task_data(agent_info_t *agent_info_ptr, int inx)
 {
 	task_info_t *task_info_ptr;
@@ -709,6 +803,26 @@ static void _notify_slurmctld_jobs(agent_info_t *agent_ptr)
 	unlock_slurmctld(job_write_lock);
 }
 
+/*
+ * Record the node data carried by a node's response. Called with the node
+ * write lock held, so a ping or accounting update of every node is applied
+ * in one batch once all of the agent's forwarding trees have replied.
+ */
+static void _record_node_data(ret_data_info_t *ret_data_info)
+{
+	ping_slurmd_resp_msg_t *ping_resp;
+
+	/* SPECIAL CASE: Record node's CPU load */
+	if (ret_data_info->type == RESPONSE_PING_SLURMD) {
+		ping_resp = (ping_slurmd_resp_msg_t *) ret_data_info->data;
+		reset_node_load(ret_data_info->node_name, ping_resp->cpu_load);
+		reset_node_free_mem(ret_data_info->node_name,
+				    ping_resp->free_mem);
+	} else if (ret_data_info->type == RESPONSE_ACCT_GATHER_UPDATE) {
+		update_node_record_acct_gather_data(ret_data_info->data);
+	}
+}
+
 static void _notify_slurmctld_nodes(agent_info_t *agent_ptr,
 				    int no_resp_cnt, int retry_cnt)
 {
@@ -765,6 +879,7 @@ static void _notify_slurmctld_nodes(agent_info_t *agent_ptr,
 			if (is_ret_list) {
 				node_names = ret_data_info->node_name;
 				resp_type = ret_data_info->type;
+				_record_node_data(ret_data_info);
 			} else
 				node_names = thread_ptr[i].nodelist;
 
@@ -893,9 +1008,6 @@ static void *_thread_per_group_rpc(void *args)
 	/* Lock: Read node */
 	slurmctld_lock_t node_read_lock = {
 		NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK, NO_LOCK };
-	/* Lock: Write node */
-	slurmctld_lock_t node_write_lock = {
-		NO_LOCK, NO_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK };
 	uint32_t job_id;
 
 	xassert(args != NULL);
@@ -904,15 +1016,7 @@ static void *_thread_per_group_rpc(void *args)
 	is_kill_msg = (	(msg_type == REQUEST_KILL_TIMELIMIT)	||
 			(msg_type == REQUEST_KILL_PREEMPTED)	||
 			(msg_type == REQUEST_TERMINATE_JOB) );
-	srun_agent = (	(msg_type == SRUN_PING)			||
-			(msg_type == SRUN_EXEC)			||
-			(msg_type == SRUN_JOB_COMPLETE)		||
-			(msg_type == SRUN_STEP_MISSING)		||
-			(msg_type == SRUN_STEP_SIGNAL)		||
-			(msg_type == SRUN_TIMEOUT)		||
-			(msg_type == SRUN_USER_MSG)		||
-			(msg_type == RESPONSE_RESOURCE_ALLOCATION) ||
-			(msg_type == SRUN_NODE_FAIL) );
+	srun_agent = _is_srun_msg(msg_type);
 
 	thread_ptr->start_time = time(NULL);
 
@@ -998,18 +1102,8 @@ static void *_thread_per_group_rpc(void *args)
 	while ((ret_data_info = list_next(itr))) {
 		rc = slurm_get_return_code(ret_data_info->type,
 					   ret_data_info->data);
-		/* SPECIAL CASE: Record node's CPU load */
-		if (ret_data_info->type == RESPONSE_PING_SLURMD) {
-			ping_slurmd_resp_msg_t *ping_resp;
-			ping_resp = (ping_slurmd_resp_msg_t *)
-				    ret_data_info->data;
-			lock_slurmctld(node_write_lock);
-			reset_node_load(ret_data_info->node_name,
-					ping_resp->cpu_load);
-			reset_node_free_mem(ret_data_info->node_name,
-					    ping_resp->free_mem);
-			unlock_slurmctld(node_write_lock);
-		}
+		/* Node load and energy data: see _record_node_data() */
+
 		/* SPECIAL CASE: Mark node as IDLE if job already complete */
 		if (is_kill_msg &&
 		    (rc == ESLURMD_KILL_JOB_ALREADY_COMPLETE)) {
@@ -1024,14 +1118,6 @@ static void *_thread_per_group_rpc(void *args)
 			unlock_slurmctld(job_write_lock);
 		}
 
-		/* SPECIAL CASE: Record node's CPU load */
-		if (ret_data_info->type == RESPONSE_ACCT_GATHER_UPDATE) {
-			lock_slurmctld(node_write_lock);
-			update_node_record_acct_gather_data(
-				ret_data_info->data);
-			unlock_slurmctld(node_write_lock);
-		}
-
 		/* SPECIAL CASE: Requeue/hold non-startable batch job,
 		 * Requeue job prolog failure or duplicate job ID */
 		if ((msg_type == REQUEST_BATCH_JOB_LAUNCH) &&
@@ -1220,6 +1306,263 @@ cleanup:
 	return (void *) NULL;
 }
 
+/* Return the current time in msec */
+static int64_t _poll_now(void)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return ((int64_t) now.tv_sec * 1000) + (now.tv_usec / 1000);
+}
+
+/* Record the outcome of a polled RPC and close its connection */
+static void _poll_conn_done(agent_info_t *agent_ptr, poll_conn_t *conn,
+			    bool comm_failed)
+{
+	thd_t *thread_ptr = conn->thread_ptr;
+	/* Lock: Read node */
+	slurmctld_lock_t node_read_lock = {
+		NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK, NO_LOCK };
+
+	/* As slurm_send_msg_maybe(), disregard communication problems */
+	if (agent_ptr->msg_type == SRUN_JOB_COMPLETE)
+		comm_failed = false;
+
+	if (comm_failed) {
+		if (!_is_srun_msg(agent_ptr->msg_type)) {
+			lock_slurmctld(node_read_lock);
+			_comm_err(thread_ptr->nodelist, agent_ptr->msg_type);
+			unlock_slurmctld(node_read_lock);
+		}
+		thread_ptr->state = DSH_NO_RESP;
+	} else
+		thread_ptr->state = DSH_DONE;
+	thread_ptr->end_time = (time_t) difftime(time(NULL),
+						 thread_ptr->start_time);
+
+	if (conn->fd >= 0)
+		(void) close(conn->fd);
+	conn->fd = -1;
+	FREE_NULL_BUFFER(conn->buffer);
+}
+
+/*
+ * Pack the agent's message for one node and start connecting to it
+ * RET true if the connection is in progress, false if the RPC is done
+ */
+static bool _poll_conn_open(agent_info_t *agent_ptr, thd_t *thread_ptr,
+			    poll_conn_t *conn)
+{
+	slurm_msg_t msg;
+	int rc;
+
+	memset(conn, 0, sizeof(poll_conn_t));
+	conn->fd = -1;
+	conn->thread_ptr = thread_ptr;
+	thread_ptr->start_time = time(NULL);
+	thread_ptr->state = DSH_ACTIVE;
+
+	slurm_msg_t_init(&msg);
+	if (agent_ptr->protocol_version)
+		msg.protocol_version = agent_ptr->protocol_version;
+	msg.msg_type = agent_ptr->msg_type;
+	msg.data     = *agent_ptr->msg_args_pptr;
+
+	if (slurmctld_conf.debug_flags & DEBUG_FLAG_AGENT) {
+		info("%s: sending %s to %s", __func__,
+		     rpc_num2string(msg.msg_type), thread_ptr->nodelist);
+	}
+
+	if (thread_ptr->addr) {
+		msg.address = *thread_ptr->addr;
+	} else if (slurm_conf_get_addr(thread_ptr->nodelist,
+				       &msg.address) == SLURM_ERROR) {
+		error("%s: can't find address for host %s, check slurm.conf",
+		      __func__, thread_ptr->nodelist);
+		thread_ptr->state = DSH_NO_RESP;
+		thread_ptr->end_time = 0;
+		return false;
+	}
+
+	conn->buffer = slurm_pack_node_msg(&msg);
+	destroy_forward(&msg.forward);
+	if (!conn->buffer) {
+		_poll_conn_done(agent_ptr, conn, true);
+		return false;
+	}
+
+	if ((conn->fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)) < 0) {
+		error("%s: socket: %m", __func__);
+		_poll_conn_done(agent_ptr, conn, true);
+		return false;
+	}
+	fd_set_close_on_exec(conn->fd);
+	fd_set_nonblocking(conn->fd);
+	rc = connect(conn->fd, (struct sockaddr *) &msg.address,
+		     sizeof(msg.address));
+	if ((rc < 0) && (errno != EINPROGRESS)) {
+		_poll_conn_done(agent_ptr, conn, true);
+		return false;
+	}
+	conn->connected = (rc == 0);
+	conn->deadline = _poll_now() + (slurm_get_tcp_timeout() * 1000);
+
+	return true;
+}
+
+/*
+ * Advance a polled RPC given the poll() revents of its connection,
+ * following the steps of slurm_send_only_node_msg(): connect, write the
+ * message, shut down writing and wait for the peer to close the connection.
+ * RET true if the RPC is done and the connection closed
+ */
+static bool _poll_conn_event(agent_info_t *agent_ptr, poll_conn_t *conn,
+			     short revents, int64_t now)
+{
+	int err = 0;
+	socklen_t err_len = sizeof(err);
+	ssize_t size;
+
+	if ((revents & (POLLERR | POLLHUP)) &&
+	    getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &err, &err_len))
+		err = errno;
+	if ((revents & POLLERR) && !err)
+		err = ECONNRESET;
+
+	if (!conn->connected) {
+		if (err) {
+			errno = err;
+			_poll_conn_done(agent_ptr, conn, true);
+			return true;
+		}
+		if (!(revents & POLLOUT))
+			goto check_time;
+		conn->connected = true;
+		conn->deadline = now + (slurm_get_msg_timeout() * 1000);
+	}
+
+	if (!conn->sent) {
+		if (err && !(revents & POLLOUT)) {
+			errno = err;
+			_poll_conn_done(agent_ptr, conn, true);
+			return true;
+		}
+		if (!(revents & POLLOUT))
+			goto check_time;
+		/* A closed peer is reported as EPIPE rather than SIGPIPE */
+		size = send(conn->fd,
+			    get_buf_data(conn->buffer) + conn->sent_bytes,
+			    get_buf_offset(conn->buffer) - conn->sent_bytes,
+			    MSG_NOSIGNAL);
+		if (size < 0) {
+			if ((errno != EAGAIN) && (errno != EINTR)) {
+				_poll_conn_done(agent_ptr, conn, true);
+				return true;
+			}
+			goto check_time;
+		}
+		conn->sent_bytes += size;
+		if (conn->sent_bytes < get_buf_offset(conn->buffer))
+			goto check_time;
+
+		conn->sent = true;
+		FREE_NULL_BUFFER(conn->buffer);
+		if (agent_ptr->msg_type == SRUN_JOB_COMPLETE) {
+			_poll_conn_done(agent_ptr, conn, false);
+			return true;
+		}
+		if (shutdown(conn->fd, SHUT_WR))
+			debug("%s: shutdown call failed: %m", __func__);
+		conn->deadline = now + POLL_CLOSE_WAIT;
+		return false;
+	}
+
+	if (err) {
+		errno = err;
+		_poll_conn_done(agent_ptr, conn, true);
+		return true;
+	}
+	if (revents & (POLLIN | POLLHUP)) {
+		_poll_conn_done(agent_ptr, conn, false);
+		return true;
+	}
+
+check_time:
+	if (now >= conn->deadline) {
+		errno = ETIMEDOUT;
+		_poll_conn_done(agent_ptr, conn, true);
+		return true;
+	}
+	return false;
+}
+
+/*
+ * Issue an RPC sent directly to each node without waiting for a reply
+ * (see _is_direct_msg()) from the agent thread itself. Up to
+ * AGENT_POLL_CONN_COUNT connections are in progress at once, all waited on
+ * with a single poll(). The state of each node is left in the agent's
+ * thread_struct as _thread_per_group_rpc() would have left it.
+ */
+static void _poll_direct_rpcs(agent_info_t *agent_ptr)
+{
+	thd_t *thread_ptr = agent_ptr->thread_struct;
+	poll_conn_t *conns;
+	struct pollfd *pfds;
+	int conn_cnt = 0, max_conn, next = 0, i, rc, timeout;
+	int64_t now, min_deadline;
+
+	max_conn = MIN(agent_ptr->thread_count, AGENT_POLL_CONN_COUNT);
+	conns = xcalloc(max_conn, sizeof(poll_conn_t));
+	pfds = xcalloc(max_conn, sizeof(struct pollfd));
+
+	while ((next < agent_ptr->thread_count) || conn_cnt) {
+		while ((conn_cnt < max_conn) &&
+		       (next < agent_ptr->thread_count)) {
+			if (_poll_conn_open(agent_ptr, &thread_ptr[next],
+					    &conns[conn_cnt]))
+				conn_cnt++;
+			next++;
+		}
+		if (!conn_cnt)
+			break;
+
+		min_deadline = conns[0].deadline;
+		for (i = 0; i < conn_cnt; i++) {
+			pfds[i].fd = conns[i].fd;
+			pfds[i].events = conns[i].sent ? POLLIN : POLLOUT;
+			pfds[i].revents = 0;
+			min_deadline = MIN(min_deadline, conns[i].deadline);
+		}
+		timeout = MAX(min_deadline - _poll_now(), 0);
+		rc = poll(pfds, conn_cnt, timeout);
+		if ((rc < 0) && (errno != EINTR)) {
+			error("%s: poll: %m", __func__);
+			for (i = 0; i < conn_cnt; i++)
+				_poll_conn_done(agent_ptr, &conns[i], true);
+			conn_cnt = 0;
+			continue;
+		} else if (rc < 0) {
+			continue;
+		}
+
+		now = _poll_now();
+		for (i = 0; i < conn_cnt; ) {
+			if (!_poll_conn_event(agent_ptr, &conns[i],
+					      pfds[i].revents, now)) {
+				i++;
+				continue;
+			}
+			/* Fill the hole with the last connection */
+			conn_cnt--;
+			conns[i] = conns[conn_cnt];
+			pfds[i] = pfds[conn_cnt];
+		}
+	}
+
+	xfree(conns);
+	xfree(pfds);
+}
+
 /*
  * Signal handler.  We are really interested in interrupting hung communictions
  * and causing them to return EINTR. Multiple interrupts might be required.
@@ -1391,8 +1734,12 @@ static void *_agent_init(void *arg)
 		while (!slurmctld_config.shutdown_time &&
 		       !pending_mail && (pending_wait_time == NO_VAL16)) {
 			ts.tv_sec  = time(NULL) + 2;
+			ts.tv_nsec = 0;
+			_kill_aggr_wait_time(&ts);
 			slurm_cond_timedwait(&pending_cond, &pending_mutex,
 					     &ts);
+			if (_kill_aggr_flush(false))
+				pending_wait_time = 999;
 		}
 		if (slurmctld_config.shutdown_time) {
 			slurm_mutex_unlock(&pending_mutex);
@@ -1693,6 +2040,366 @@ static void _agent_retry(int min_wait, bool mail_too)
 	return;
 }
 
+/* Read MsgAggregationParams, called with kill_aggr_mutex locked */
+static void _kill_aggr_config(void)
+{
+	char *params, *tmp_ptr;
+
+	if (kill_aggr_config == slurmctld_conf.last_update)
+		return;
+	kill_aggr_config = slurmctld_conf.last_update;
+
+	kill_aggr_msgs = DEFAULT_MSG_AGGR_WINDOW_MSGS;
+	kill_aggr_time = DEFAULT_MSG_AGGR_WINDOW_TIME;
+	params = slurm_get_msg_aggr_params();
+	if ((tmp_ptr = xstrcasestr(params, "WindowMsgs=")))
+		kill_aggr_msgs = MAX(atoi(tmp_ptr + 11), 1);
+	if ((tmp_ptr = xstrcasestr(params, "WindowTime=")))
+		kill_aggr_time = MAX(atoi(tmp_ptr + 11), 0);
+	xfree(params);
+}
+
+/* Return true if no kill RPCs were sent during the last window time */
+static bool _kill_aggr_idle(void)
+{
+	struct timeval now;
+	int64_t delta_usec;
+
+	if (!kill_aggr_sent.tv_sec)
+		return true;
+	gettimeofday(&now, NULL);
+	delta_usec = ((int64_t) (now.tv_sec - kill_aggr_sent.tv_sec) *
+		      1000000) + (now.tv_usec - kill_aggr_sent.tv_usec);
+	return (delta_usec >= ((int64_t) kill_aggr_time * 1000));
+}
+
+/*
+ * Hold a job kill RPC for the current collection window so that it can be
+ * sent along with the kill RPCs of other jobs ending at about the same time.
+ * The slurmd picks out the RPCs for its own jobs by each job's node list, so
+ * only RPCs going to exactly the nodes of that list are held.
+ * A kill RPC is not held if none were sent during the last window time, so
+ * that a job ending on its own is not delayed by WindowTime.
+ * RET true if the request was taken
+ */
+static bool _kill_aggr_add(queued_request_t *queued_req_ptr)
+{
+	agent_arg_t *agent_arg_ptr = queued_req_ptr->agent_arg_ptr;
+	kill_job_msg_t *kill_job = agent_arg_ptr->msg_args;
+	hostset_t hs;
+	char *host_str;
+	int window_msgs;
+	bool full = false, match;
+
+	if ((agent_arg_ptr->msg_type != REQUEST_TERMINATE_JOB)  &&
+	    (agent_arg_ptr->msg_type != REQUEST_KILL_PREEMPTED) &&
+	    (agent_arg_ptr->msg_type != REQUEST_KILL_TIMELIMIT))
+		return false;
+	/* Older slurmd can not process REQUEST_TERMINATE_JOB_AGGR */
+	if (agent_arg_ptr->addr ||
+	    (agent_arg_ptr->protocol_version < SLURM_PROTOCOL_VERSION))
+		return false;
+
+	slurm_mutex_lock(&kill_aggr_mutex);
+	_kill_aggr_config();
+	window_msgs = kill_aggr_msgs;
+	slurm_mutex_unlock(&kill_aggr_mutex);
+	if (window_msgs <= 1)
+		return false;
+
+	if (!kill_job || !kill_job->nodes ||
+	    !(hs = hostset_create(kill_job->nodes)))
+		return false;
+	host_str = hostlist_ranged_string_xmalloc(agent_arg_ptr->hostlist);
+	match = ((hostset_count(hs) ==
+		  hostlist_count(agent_arg_ptr->hostlist)) &&
+		 hostset_within(hs, host_str));
+	xfree(host_str);
+	hostset_destroy(hs);
+	if (!match)
+		return false;
+
+	slurm_mutex_lock(&kill_aggr_mutex);
+	if (!kill_aggr_list)
+		kill_aggr_list = list_create(_list_delete_retry);
+	if (!list_count(kill_aggr_list) && _kill_aggr_idle()) {
+		gettimeofday(&kill_aggr_sent, NULL);
+		slurmctld_diag_stats.kill_aggr_windows++;
+		slurmctld_diag_stats.kill_aggr_msgs++;
+		slurmctld_diag_stats.kill_aggr_max =
+			MAX(slurmctld_diag_stats.kill_aggr_max, 1);
+		slurm_mutex_unlock(&kill_aggr_mutex);
+		return false;
+	}
+	if (!list_count(kill_aggr_list))
+		gettimeofday(&kill_aggr_start, NULL);
+	list_append(kill_aggr_list, queued_req_ptr);
+	if (list_count(kill_aggr_list) >= kill_aggr_msgs)
+		full = true;
+	slurm_mutex_unlock(&kill_aggr_mutex);
+
+	if (full && _kill_aggr_flush(true)) {
+		agent_trigger(999, false);
+	} else {
+		/* Have _agent_init() wake up at the end of the window */
+		slurm_mutex_lock(&pending_mutex);
+		slurm_cond_broadcast(&pending_cond);
+		slurm_mutex_unlock(&pending_mutex);
+	}
+
+	return true;
+}
+
+/* Reduce ts to the end of the current kill RPC collection window, if any */
+static void _kill_aggr_wait_time(struct timespec *ts)
+{
+	struct timespec end;
+
+	slurm_mutex_lock(&kill_aggr_mutex);
+	if (kill_aggr_list && list_count(kill_aggr_list)) {
+		end.tv_sec = kill_aggr_start.tv_sec + (kill_aggr_time / 1000);
+		end.tv_nsec = (kill_aggr_start.tv_usec * 1000) +
+			      ((kill_aggr_time % 1000) * 1000000);
+		end.tv_sec += end.tv_nsec / 1000000000;
+		end.tv_nsec %= 1000000000;
+		if ((end.tv_sec < ts->tv_sec) ||
+		    ((end.tv_sec == ts->tv_sec) &&
+		     (end.tv_nsec < ts->tv_nsec)))
+			*ts = end;
+	}
+	slurm_mutex_unlock(&kill_aggr_mutex);
+}
+
+static void _kill_aggr_group_free(void *x)
+{
+	kill_aggr_group_t *group = x;
+
+	FREE_NULL_BITMAP(group->kill_bitmap);
+	FREE_NULL_HOSTLIST(group->hostlist);
+	xfree(group);
+}
+
+static int _kill_aggr_group_find(void *x, void *key)
+{
+	kill_aggr_group_t *group = x;
+
+	return bit_equal(group->kill_bitmap, key);
+}
+
+/* Pack a kill RPC so that it can be copied into several composite messages */
+static Buf _kill_aggr_pack(agent_arg_t *kill_arg_ptr)
+{
+	slurm_msg_t msg;
+	Buf buffer = init_buf(BUF_SIZE);
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = kill_arg_ptr->msg_type;
+	msg.protocol_version = kill_arg_ptr->protocol_version;
+	msg.data = kill_arg_ptr->msg_args;
+	pack_msg(&msg, buffer);
+
+	return buffer;
+}
+
+/*
+ * Combine the kill RPCs sent to one group of nodes into a single composite
+ * message
+ * IN kill_reqs - the kill RPCs of the collection window
+ * IN kill_bufs - kill_reqs packed by _kill_aggr_pack(), filled in as needed
+ * IN group - the nodes and which of kill_reqs they are sent
+ */
+static queued_request_t *_kill_aggr_build(queued_request_t **kill_reqs,
+					  Buf *kill_bufs,
+					  kill_aggr_group_t *group)
+{
+	queued_request_t *queued_req_ptr;
+	agent_arg_t *agent_arg_ptr, *kill_arg_ptr;
+	composite_msg_t *comp_msg;
+	slurm_msg_t *msg;
+	char *auth_info = slurm_get_auth_info(), *data;
+	uint32_t size;
+	int i;
+
+	comp_msg = xmalloc(sizeof(composite_msg_t));
+	comp_msg->msg_list = list_create(slurm_free_comp_msg_list);
+
+	agent_arg_ptr = xmalloc(sizeof(agent_arg_t));
+	agent_arg_ptr->msg_type = REQUEST_TERMINATE_JOB_AGGR;
+	agent_arg_ptr->msg_args = comp_msg;
+	agent_arg_ptr->hostlist = group->hostlist;
+	group->hostlist = NULL;
+	agent_arg_ptr->node_count = hostlist_count(agent_arg_ptr->hostlist);
+	agent_arg_ptr->protocol_version = SLURM_PROTOCOL_VERSION;
+	agent_arg_ptr->retry = 0;	/* re_kill_job() resends as needed */
+
+	for (i = 0; i < bit_size(group->kill_bitmap); i++) {
+		if (!bit_test(group->kill_bitmap, i))
+			continue;
+		kill_arg_ptr = kill_reqs[i]->agent_arg_ptr;
+		if (!kill_bufs[i])
+			kill_bufs[i] = _kill_aggr_pack(kill_arg_ptr);
+		size = get_buf_offset(kill_bufs[i]);
+
+		msg = xmalloc_nz(sizeof(slurm_msg_t));
+		slurm_msg_t_init(msg);
+		msg->msg_type = kill_arg_ptr->msg_type;
+		msg->protocol_version = kill_arg_ptr->protocol_version;
+		/*
+		 * Create the credential now, the agent threads pack this
+		 * message concurrently for each branch of the tree
+		 */
+		msg->auth_cred = g_slurm_auth_create(msg->auth_index,
+						     auth_info);
+		data = xmalloc_nz(size);
+		memcpy(data, get_buf_data(kill_bufs[i]), size);
+		msg->data = create_buf(data, size);
+		msg->data_size = size;
+		list_append(comp_msg->msg_list, msg);
+	}
+	xfree(auth_info);
+
+	queued_req_ptr = xmalloc(sizeof(queued_request_t));
+	queued_req_ptr->agent_arg_ptr = agent_arg_ptr;
+	return queued_req_ptr;
+}
+
+/*
+ * Split the nodes of a collection window's kill RPCs into groups which are
+ * sent the same kill RPCs, so that each node only receives those of its
+ * own jobs. A group with several kill RPCs is sent one composite message.
+ * IN kill_list - kill RPCs of the window, emptied
+ * IN/OUT send_list - the requests to send are appended
+ */
+static void _kill_aggr_split(List kill_list, List send_list)
+{
+	queued_request_t **kill_reqs;
+	kill_aggr_group_t *group;
+	hostlist_t all_hl;
+	hostlist_iterator_t itr;
+	ListIterator group_itr;
+	List group_list;
+	bitstr_t *kill_bitmap;
+	Buf *kill_bufs;
+	char *name;
+	int i, cnt = list_count(kill_list);
+
+	kill_reqs = xcalloc(cnt, sizeof(queued_request_t *));
+	kill_bufs = xcalloc(cnt, sizeof(Buf));
+	all_hl = hostlist_create(NULL);
+	for (i = 0; i < cnt; i++) {
+		kill_reqs[i] = list_pop(kill_list);
+		hostlist_push_list(all_hl, kill_reqs[i]->agent_arg_ptr->hostlist);
+	}
+	hostlist_uniq(all_hl);
+
+	group_list = list_create(_kill_aggr_group_free);
+	kill_bitmap = bit_alloc(cnt);
+	itr = hostlist_iterator_create(all_hl);
+	while ((name = hostlist_next(itr))) {
+		bit_clear_all(kill_bitmap);
+		for (i = 0; i < cnt; i++) {
+			if (hostlist_find(kill_reqs[i]->agent_arg_ptr->hostlist,
+					  name) >= 0)
+				bit_set(kill_bitmap, i);
+		}
+		if (!(group = list_find_first(group_list,
+					      _kill_aggr_group_find,
+					      kill_bitmap))) {
+			group = xmalloc(sizeof(kill_aggr_group_t));
+			group->kill_bitmap = bit_copy(kill_bitmap);
+			group->hostlist = hostlist_create(NULL);
+			list_append(group_list, group);
+		}
+		hostlist_push_host(group->hostlist, name);
+		free(name);
+	}
+	hostlist_iterator_destroy(itr);
+	hostlist_destroy(all_hl);
+	FREE_NULL_BITMAP(kill_bitmap);
+
+	group_itr = list_iterator_create(group_list);
+	while ((group = list_next(group_itr))) {
+		/*
+		 * A group which is sent a single kill RPC is all of the nodes
+		 * of that RPC unless some of them have other jobs ending
+		 */
+		i = bit_ffs(group->kill_bitmap);
+		if ((bit_set_count(group->kill_bitmap) == 1) &&
+		    (hostlist_count(group->hostlist) ==
+		     hostlist_count(kill_reqs[i]->agent_arg_ptr->hostlist))) {
+			list_append(send_list, kill_reqs[i]);
+			kill_reqs[i] = NULL;
+			continue;
+		}
+		list_append(send_list,
+			    _kill_aggr_build(kill_reqs, kill_bufs, group));
+	}
+	list_iterator_destroy(group_itr);
+	FREE_NULL_LIST(group_list);
+
+	for (i = 0; i < cnt; i++) {
+		if (kill_reqs[i])
+			_list_delete_retry(kill_reqs[i]);
+		FREE_NULL_BUFFER(kill_bufs[i]);
+	}
+	xfree(kill_reqs);
+	xfree(kill_bufs);
+}
+
+/*
+ * Move the kill RPCs of the current collection window to the retry_list,
+ * combining those going to the same nodes
+ * IN force - if not set, only do so once the window has expired
+ * RET true if a request was added to the retry_list
+ */
+static bool _kill_aggr_flush(bool force)
+{
+	queued_request_t *queued_req_ptr;
+	List kill_list, send_list;
+	int cnt;
+
+	slurm_mutex_lock(&kill_aggr_mutex);
+	if (!kill_aggr_list || !(cnt = list_count(kill_aggr_list)) ||
+	    (!force &&
+	     (slurm_delta_tv(&kill_aggr_start) < (kill_aggr_time * 1000)))) {
+		slurm_mutex_unlock(&kill_aggr_mutex);
+		return false;
+	}
+	kill_list = kill_aggr_list;
+	kill_aggr_list = NULL;
+	gettimeofday(&kill_aggr_sent, NULL);
+
+	slurmctld_diag_stats.kill_aggr_windows++;
+	if (cnt >= kill_aggr_msgs)
+		slurmctld_diag_stats.kill_aggr_full++;
+	slurmctld_diag_stats.kill_aggr_msgs += cnt;
+	slurmctld_diag_stats.kill_aggr_max =
+		MAX(slurmctld_diag_stats.kill_aggr_max, cnt);
+	slurm_mutex_unlock(&kill_aggr_mutex);
+
+	send_list = list_create(NULL);
+	if (cnt == 1)
+		list_append(send_list, list_pop(kill_list));
+	else
+		_kill_aggr_split(kill_list, send_list);
+	FREE_NULL_LIST(kill_list);
+
+	if (slurmctld_conf.debug_flags & DEBUG_FLAG_AGENT) {
+		info("%s: sending %d kill RPCs as %d RPCs", __func__, cnt,
+		     list_count(send_list));
+	}
+
+	slurm_mutex_lock(&retry_mutex);
+	if (retry_list == NULL)
+		retry_list = list_create(_list_delete_retry);
+	while ((queued_req_ptr = list_pop(send_list)))
+		list_append(retry_list, queued_req_ptr);
+	slurm_mutex_unlock(&retry_mutex);
+	FREE_NULL_LIST(send_list);
+
+	return true;
+}
+
 /*
  * agent_queue_request - put a new request on the queue for execution or
  * 	execute now if not too busy
@@ -1721,6 +2428,9 @@ void agent_queue_request(agent_arg_t *agent_arg_ptr)
 	queued_req_ptr->agent_arg_ptr = agent_arg_ptr;
 /*	queued_req_ptr->last_attempt  = 0; Implicit */
 
+	if (_kill_aggr_add(queued_req_ptr))
+		return;
+
 	if (((agent_arg_ptr->msg_type == REQUEST_BATCH_JOB_LAUNCH) &&
 	     (_batch_launch_defer(queued_req_ptr) != 0)) ||
 	    ((agent_arg_ptr->msg_type == REQUEST_SIGNAL_TASKS) &&
@@ -1757,6 +2467,11 @@ extern void agent_purge(void)
 		FREE_NULL_LIST(defer_list);
 		slurm_mutex_unlock(&defer_mutex);
 	}
+	if (kill_aggr_list) {
+		slurm_mutex_lock(&kill_aggr_mutex);
+		FREE_NULL_LIST(kill_aggr_list);
+		slurm_mutex_unlock(&kill_aggr_mutex);
+	}
 	if (mail_list) {
 		slurm_mutex_lock(&mail_mutex);
 		FREE_NULL_LIST(mail_list);
@@ -1830,6 +2545,8 @@ static void _purge_agent_args(agent_arg_t *agent_arg_ptr)
 			slurm_free_suspend_int_msg(agent_arg_ptr->msg_args);
 		else if (agent_arg_ptr->msg_type == REQUEST_LAUNCH_PROLOG)
 			slurm_free_prolog_launch_msg(agent_arg_ptr->msg_args);
+		else if (agent_arg_ptr->msg_type == REQUEST_TERMINATE_JOB_AGGR)
+			slurm_free_composite_msg(agent_arg_ptr->msg_args);
 		else
 			xfree(agent_arg_ptr->msg_args);
 	}
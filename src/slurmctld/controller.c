@@ -132,6 +132,21 @@
 				 * check-in before we ping them */
 #define SHUTDOWN_WAIT     2	/* Time to wait for backup server shutdown */
 #define JOB_COUNT_INTERVAL 30   /* Time to update running job count */
+#define RPC_RETRY_MSEC    50	/* poll() timeout while at the server thread
+				 * limit and not accepting connections */
+#define RPC_MAX_MSG_SIZE  (1024 * 1024 * 1024)	/* as slurm_receive_msg() */
+
+/* Accepted connection waiting for data or for an RPC worker thread */
+typedef struct {
+	connection_arg_t *conn_arg;
+	time_t accept_time;		/* used to expire idle connections */
+	uint32_t msg_len;		/* length prefix of the RPC data */
+	char *msg_buf;			/* RPC data, buffered by rpcmgr */
+	uint32_t msg_read;		/* bytes read, length prefix included */
+	struct timeval queue_time;	/* time added to rpc_class_queue */
+	slurm_msg_t *msg;		/* RPC unpacked by a worker */
+	int rpc_class;			/* rpc_class_t from the message header */
+} rpc_conn_t;
 
 /**************************************************************************\
  * To test for memory leaks, set MEMORY_LEAK_DEBUG to 1 using
@@ -210,6 +225,12 @@ static int	recover   = DEFAULT_RECOVER;
 static pthread_mutex_t sched_cnt_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pid_t	slurmctld_pid;
 static char *	slurm_conf_filename;
+static pthread_cond_t rpc_queue_cond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t rpc_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t	rpc_queue_cnt = 0;	/* rpc_conn_t in all class queues */
+static bool	rpc_workers_stop = false;
+static List	rpc_class_queue[RPC_CLASS_CNT];	/* rpc_conn_t ready for a worker */
+static uint32_t	rpc_class_credit[RPC_CLASS_CNT];
 
 /*
  * Static list of signals to block in this process
@@ -242,8 +263,16 @@ static void         _parse_commandline(int argc, char **argv);
 static void *       _purge_files_thread(void *no_data);
 static void         _remove_assoc(slurmdb_assoc_rec_t *rec);
 static void         _remove_qos(slurmdb_qos_rec_t *rec);
+static rpc_conn_t * _rpc_class_dequeue(void);
+static void         _rpc_conn_close(rpc_conn_t *conn);
+static int          _rpc_peek_class(rpc_conn_t *conn);
+static void         _rpc_queue_conn(rpc_conn_t *conn);
+static int          _rpc_read(rpc_conn_t *conn);
+static bool         _rpc_receive(rpc_conn_t *conn);
+static void *       _rpc_worker(void *no_data);
 static void         _run_primary_prog(bool primary_on);
-static void *       _service_connection(void *arg);
+static void         _service_connection(rpc_conn_t *conn);
+static bool         _server_thread_try_incr(void);
 static void         _set_work_dir(void);
 static int          _shutdown_backup_controller(void);
 static void *       _slurmctld_background(void *no_data);
@@ -258,7 +287,6 @@ static void         _update_nice(void);
 static void         _update_qos(slurmdb_qos_rec_t *rec);
 inline static void  _usage(char *prog_name);
 static bool         _verify_clustername(void);
-static bool         _wait_for_server_thread(void);
 static void *       _wait_primary_prog(void *arg);
 
 /* main - slurmctld main function, start various threads and process RPCs */
@@ -1107,7 +1135,9 @@ static void _sig_handler(int signal)
 }
 
 /*
- * _slurmctld_rpc_mgr - Read incoming RPCs and create pthread for each
+ * _slurmctld_rpc_mgr - Accept incoming connections, read their RPC data
+ *	without blocking and hand each one to a pool of worker threads once
+ *	the whole RPC has arrived. Workers never wait on a slow client.
  */
 static void *_slurmctld_rpc_mgr(void *no_data)
 {
@@ -1116,13 +1146,20 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 	slurm_addr_t cli_addr, srv_addr;
 	uint16_t port;
 	char ip[32];
-	int fd_next = 0, i, nports;
-	connection_arg_t *conn_arg = NULL;
+	int fd_next = 0, i, inx, nports, worker_cnt = RPC_WORKER_COUNT;
+	int pending_cnt = 0, msg_timeout, rc;
+	int class_weight[RPC_CLASS_CNT] = {
+		RPC_WEIGHT_NODE, RPC_WEIGHT_USER, RPC_WEIGHT_QUERY };
+	char *class_param;
+	rpc_conn_t **pending, *conn;
+	pthread_t *worker_ids;
+	bool throttled = false;
+	time_t now;
 	/* Locks: Read config */
 	slurmctld_lock_t config_read_lock = {
 		READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
 	int sigarray[] = {SIGUSR1, 0};
-	char *node_addr = NULL;
+	char *node_addr = NULL, *tmp_ptr;
 
 #if HAVE_SYS_PRCTL_H
 	if (prctl(PR_SET_NAME, "rpcmgr", NULL, NULL, NULL) < 0) {
@@ -1147,7 +1184,7 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 		fatal("slurmctld port count is zero");
 		return NULL;	/* Fix CLANG false positive */
 	}
-	fds = xcalloc(nports, sizeof(struct pollfd));
+	fds = xcalloc(nports + max_server_threads, sizeof(struct pollfd));
 	for (i = 0; i < nports; i++) {
 		fds[i].fd = slurm_init_msg_engine_addrname_port(node_addr,
 			slurmctld_conf.slurmctld_port + i);
@@ -1164,10 +1201,36 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 			debug2("slurmctld listening on %s:%d", ip, ntohs(port));
 		}
 	}
+	if ((tmp_ptr = xstrcasestr(slurmctld_conf.slurmctld_params,
+				   "rpc_workers="))) {
+		worker_cnt = atoi(tmp_ptr + 12);
+		if (worker_cnt < 1) {
+			error("Invalid SlurmctldParameters rpc_workers: %d",
+			      worker_cnt);
+			worker_cnt = RPC_WORKER_COUNT;
+		}
+	}
+	for (i = 0; i < RPC_CLASS_CNT; i++) {
+		class_param = xstrdup_printf("rpc_weight_%s=",
+					     rpc_class_str(i));
+		if ((tmp_ptr = xstrcasestr(slurmctld_conf.slurmctld_params,
+					   class_param))) {
+			int weight = atoi(tmp_ptr + strlen(class_param));
+			if (weight < 1) {
+				error("Invalid SlurmctldParameters %s%d",
+				      class_param, weight);
+			} else
+				class_weight[i] = weight;
+		}
+		xfree(class_param);
+	}
+	msg_timeout = slurmctld_conf.msg_timeout;
 	unlock_slurmctld(config_read_lock);
+	/* The rpcmgr thread itself counts against max_server_threads */
+	worker_cnt = MIN(worker_cnt, max_server_threads - 1);
 
 	/*
-	 * Prepare to catch SIGUSR1 to interrupt accept().
+	 * Prepare to catch SIGUSR1 to interrupt poll().
 	 * This signal is generated by the slurmctld signal
 	 * handler thread upon receipt of SIGABRT, SIGINT,
 	 * or SIGTERM. That thread does all processing of
@@ -1176,161 +1239,471 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 	xsignal(SIGUSR1, _sig_handler);
 	xsignal_unblock(sigarray);
 
+	slurm_mutex_lock(&rpc_queue_mutex);
+	for (i = 0; i < RPC_CLASS_CNT; i++) {
+		if (!rpc_class_queue[i])
+			rpc_class_queue[i] = list_create(NULL);
+		slurmctld_diag_stats.rpc_class_weight[i] = class_weight[i];
+		rpc_class_credit[i] = class_weight[i];
+	}
+	rpc_workers_stop = false;
+	slurmctld_diag_stats.rpc_pool_workers = worker_cnt;
+	slurm_mutex_unlock(&rpc_queue_mutex);
+	worker_ids = xcalloc(worker_cnt, sizeof(pthread_t));
+	for (i = 0; i < worker_cnt; i++)
+		slurm_thread_create(&worker_ids[i], _rpc_worker, NULL);
+	debug2("%s: started %d RPC worker threads", __func__, worker_cnt);
+
+	/*
+	 * Every accepted connection holds a server thread count until its RPC
+	 * has been serviced, so at most max_server_threads connections are
+	 * ever pending or queued. Stop accepting new connections at that
+	 * limit and let the listen backlog absorb the excess.
+	 */
+	pending = xcalloc(max_server_threads, sizeof(rpc_conn_t *));
+
 	/*
 	 * Process incoming RPCs until told to shutdown
 	 */
-	while (_wait_for_server_thread()) {
-		if (poll(fds, nports, -1) == -1) {
-			if (errno != EINTR)
-				error("slurm_accept_msg_conn select: %m");
-			server_thread_decr();
-			continue;
+	while (!slurmctld_config.shutdown_time) {
+		slurm_mutex_lock(&slurmctld_config.thread_count_lock);
+		if (slurmctld_config.server_thread_count < max_server_threads) {
+			throttled = false;
+		} else {
+			if (!throttled)
+				slurmctld_diag_stats.rpc_pool_throttled++;
+			throttled = true;
 		}
-
-		/* find one to process */
+		slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
 		for (i = 0; i < nports; i++) {
-			if (fds[(fd_next + i) % nports].revents) {
-				i = (fd_next + i) % nports;
-				break;
-			}
+			fds[i].events = throttled ? 0 : POLLIN;
+			fds[i].revents = 0;
+		}
+		for (i = 0; i < pending_cnt; i++) {
+			fds[nports + i].fd = pending[i]->conn_arg->newsockfd;
+			fds[nports + i].events = POLLIN;
+			fds[nports + i].revents = 0;
 		}
-		fd_next = (i + 1) % nports;
 
-		/*
-		 * accept needed for stream implementation is a no-op in
-		 * message implementation that just passes sockfd to newsockfd
-		 */
-		if ((newsockfd = slurm_accept_msg_conn(fds[i].fd, &cli_addr))
-		    == SLURM_ERROR) {
+		if (poll(fds, nports + pending_cnt,
+			 throttled ? RPC_RETRY_MSEC : 1000) == -1) {
 			if (errno != EINTR)
-				error("slurm_accept_msg_conn: %m");
-			server_thread_decr();
+				error("slurm_accept_msg_conn poll: %m");
 			continue;
 		}
-		fd_set_close_on_exec(newsockfd);
-		conn_arg = xmalloc(sizeof(connection_arg_t));
-		conn_arg->newsockfd = newsockfd;
-		memcpy(&conn_arg->cli_addr, &cli_addr, sizeof(slurm_addr_t));
 
-		if (slurmctld_conf.debug_flags & DEBUG_FLAG_PROTOCOL) {
-			char inetbuf[64];
-
-			slurm_print_slurm_addr(&cli_addr,
-						inetbuf,
-						sizeof(inetbuf));
-			info("%s: accept() connection from %s", __func__, inetbuf);
+		/*
+		 * Read whatever RPC data is available. Hand connections with
+		 * a complete RPC to the workers, close those which failed or
+		 * did not send a complete RPC within MessageTimeout
+		 */
+		now = time(NULL);
+		for (i = pending_cnt - 1; i >= 0; i--) {
+			char addr_buf[32];
+
+			conn = pending[i];
+			rc = 0;
+			if (fds[nports + i].revents)
+				rc = _rpc_read(conn);
+			if (rc > 0) {
+				_rpc_queue_conn(conn);
+			} else if (rc < 0) {
+				slurm_print_slurm_addr(&conn->conn_arg->cli_addr,
+						       addr_buf,
+						       sizeof(addr_buf));
+				error("%s: reading RPC from %s: %m",
+				      __func__, addr_buf);
+				_rpc_conn_close(conn);
+			} else if (difftime(now, conn->accept_time) <
+				   msg_timeout) {
+				continue;
+			} else {
+				slurm_print_slurm_addr(&conn->conn_arg->cli_addr,
+						       addr_buf,
+						       sizeof(addr_buf));
+				error("%s: no complete RPC received from %s in %d seconds, closing connection",
+				      __func__, addr_buf, msg_timeout);
+				_rpc_conn_close(conn);
+			}
+			pending[i] = pending[--pending_cnt];
 		}
 
-		if (slurmctld_config.shutdown_time) {
-			slurmctld_diag_stats.proc_req_raw++;
-			_service_connection(conn_arg);
-		} else {
-			slurm_thread_create_detached(NULL, _service_connection,
-						     conn_arg);
+		/* Accept new connections, rotating between ports */
+		for (i = 0; i < nports; i++) {
+			inx = (fd_next + i) % nports;
+			if (!fds[inx].revents)
+				continue;
+			if (!_server_thread_try_incr())
+				break;
+			/*
+			 * accept needed for stream implementation is a no-op
+			 * in message implementation that just passes sockfd
+			 * to newsockfd
+			 */
+			if ((newsockfd = slurm_accept_msg_conn(fds[inx].fd,
+							       &cli_addr)) ==
+			    SLURM_ERROR) {
+				if (errno != EINTR)
+					error("slurm_accept_msg_conn: %m");
+				server_thread_decr();
+				continue;
+			}
+			fd_set_close_on_exec(newsockfd);
+			conn = xmalloc(sizeof(rpc_conn_t));
+			conn->conn_arg = xmalloc(sizeof(connection_arg_t));
+			conn->conn_arg->newsockfd = newsockfd;
+			memcpy(&conn->conn_arg->cli_addr, &cli_addr,
+			       sizeof(slurm_addr_t));
+			conn->accept_time = now;
+
+			if (slurmctld_conf.debug_flags & DEBUG_FLAG_PROTOCOL) {
+				char inetbuf[64];
+
+				slurm_print_slurm_addr(&cli_addr,
+							inetbuf,
+							sizeof(inetbuf));
+				info("%s: accept() connection from %s",
+				     __func__, inetbuf);
+			}
+			pending[pending_cnt++] = conn;
 		}
+		fd_next = (fd_next + 1) % nports;
+		slurmctld_diag_stats.rpc_pool_pending = pending_cnt;
 	}
 
 	debug3("%s shutting down", __func__);
 	for (i = 0; i < nports; i++)
 		close(fds[i].fd);
 	xfree(fds);
+	for (i = 0; i < pending_cnt; i++)
+		_rpc_conn_close(pending[i]);
+	xfree(pending);
+	slurmctld_diag_stats.rpc_pool_pending = 0;
+
+	/* Workers exit once all queued connections are serviced */
+	slurm_mutex_lock(&rpc_queue_mutex);
+	rpc_workers_stop = true;
+	slurm_cond_broadcast(&rpc_queue_cond);
+	slurm_mutex_unlock(&rpc_queue_mutex);
+	for (i = 0; i < worker_cnt; i++)
+		pthread_join(worker_ids[i], NULL);
+	xfree(worker_ids);
+	slurmctld_diag_stats.rpc_pool_workers = 0;
+
 	server_thread_decr();
 	pthread_exit((void *) 0);
 	return NULL;
 }
 
+/* Close a connection which has not been handed to a worker and free it */
+static void _rpc_conn_close(rpc_conn_t *conn)
+{
+	close(conn->conn_arg->newsockfd);
+	xfree(conn->msg_buf);
+	xfree(conn->conn_arg);
+	xfree(conn);
+	server_thread_decr();
+}
+
 /*
- * _service_connection - service the RPC
- * IN/OUT arg - really just the connection's file descriptor, freed
- *	upon completion
- * RET - NULL
+ * _rpc_read - read whatever part of a connection's length prefixed RPC has
+ *	arrived, never blocking
+ * IN/OUT conn - connection, msg_len, msg_buf and msg_read are updated
+ * RET 1 if the whole RPC is buffered, 0 if more data is needed, -1 on error
+ *	or if the peer closed the connection (errno is set)
+ */
+static int _rpc_read(rpc_conn_t *conn)
+{
+	int fd = conn->conn_arg->newsockfd;
+	uint32_t off;
+	ssize_t len;
+
+	while (1) {
+		if (conn->msg_read < sizeof(conn->msg_len)) {
+			off = conn->msg_read;
+			len = recv(fd, ((char *) &conn->msg_len) + off,
+				   sizeof(conn->msg_len) - off, MSG_DONTWAIT);
+		} else {
+			if (!conn->msg_buf) {
+				conn->msg_len = ntohl(conn->msg_len);
+				if (conn->msg_len > RPC_MAX_MSG_SIZE) {
+					slurm_seterrno(
+					   SLURM_PROTOCOL_INSANE_MSG_LENGTH);
+					return -1;
+				}
+				conn->msg_buf = xmalloc_nz(
+					MAX(conn->msg_len, 1));
+			}
+			off = conn->msg_read - sizeof(conn->msg_len);
+			if (off >= conn->msg_len)
+				return 1;
+			len = recv(fd, conn->msg_buf + off,
+				   conn->msg_len - off, MSG_DONTWAIT);
+		}
+		if (len > 0) {
+			conn->msg_read += len;
+		} else if (len == 0) {
+			slurm_seterrno(SLURM_PROTOCOL_SOCKET_ZERO_BYTES_SENT);
+			return -1;
+		} else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+			return 0;
+		} else if (errno != EINTR) {
+			return -1;
+		}
+	}
+}
+
+/*
+ * _rpc_peek_class - Class of a buffered RPC from the message type in its
+ *	header. The header is not authenticated yet, so this only orders the
+ *	processing of RPCs. The layout matches the start of unpack_header():
+ *	16 bit version, flags, msg_index and msg_type in network byte order.
  */
-static void *_service_connection(void *arg)
+static int _rpc_peek_class(rpc_conn_t *conn)
 {
-	connection_arg_t *conn = (connection_arg_t *) arg;
-	void *return_code = NULL;
-	slurm_msg_t msg;
+	uint16_t version, msg_type;
+
+	if (conn->msg_len < (4 * sizeof(uint16_t)))
+		return RPC_CLASS_USER;
+	memcpy(&version, conn->msg_buf, sizeof(uint16_t));
+	if (ntohs(version) < SLURM_MIN_PROTOCOL_VERSION)
+		return RPC_CLASS_USER;
+	memcpy(&msg_type, conn->msg_buf + (3 * sizeof(uint16_t)),
+	       sizeof(uint16_t));
+	return rpc_msg_class(ntohs(msg_type));
+}
+
+/* Queue a connection with its whole RPC buffered for a worker by class */
+static void _rpc_queue_conn(rpc_conn_t *conn)
+{
+	int c;
+
+	c = conn->rpc_class = _rpc_peek_class(conn);
+	gettimeofday(&conn->queue_time, NULL);
+	slurm_mutex_lock(&rpc_queue_mutex);
+	list_enqueue(rpc_class_queue[c], conn);
+	rpc_queue_cnt++;
+	slurmctld_diag_stats.rpc_class_queue_len[c] =
+		list_count(rpc_class_queue[c]);
+	slurmctld_diag_stats.rpc_pool_queue_len = rpc_queue_cnt;
+	slurmctld_diag_stats.rpc_pool_queue_max =
+		MAX(slurmctld_diag_stats.rpc_pool_queue_max, rpc_queue_cnt);
+	slurmctld_diag_stats.rpc_pool_queue_cnt++;
+	slurm_cond_signal(&rpc_queue_cond);
+	slurm_mutex_unlock(&rpc_queue_mutex);
+}
+
+/*
+ * Pick the next RPC to process by weighted round robin over the class
+ * queues, called with rpc_queue_mutex locked. Classes are checked in order
+ * of precedence and each RPC consumes one credit of its class. Credits are
+ * restored to the class weights once every class with queued RPCs has used
+ * its credits, so lower classes are delayed but never starved.
+ * RET the connection to process or NULL if all class queues are empty
+ */
+static rpc_conn_t *_rpc_class_dequeue(void)
+{
+	rpc_conn_t *conn;
+	bool queued = false;
+	int c;
+
+	for (c = 0; c < RPC_CLASS_CNT; c++) {
+		if (!rpc_class_credit[c])
+			continue;
+		if ((conn = list_dequeue(rpc_class_queue[c])))
+			goto found;
+	}
+	for (c = 0; c < RPC_CLASS_CNT; c++) {
+		rpc_class_credit[c] = slurmctld_diag_stats.rpc_class_weight[c];
+		if (list_count(rpc_class_queue[c]))
+			queued = true;
+	}
+	if (!queued)
+		return NULL;
+	for (c = 0; c < RPC_CLASS_CNT; c++) {
+		if ((conn = list_dequeue(rpc_class_queue[c])))
+			goto found;
+	}
+	return NULL;
+
+found:
+	rpc_class_credit[c]--;
+	rpc_queue_cnt--;
+	slurmctld_diag_stats.rpc_class_queue_len[c] =
+		list_count(rpc_class_queue[c]);
+	slurmctld_diag_stats.rpc_pool_queue_len = rpc_queue_cnt;
+	return conn;
+}
+
+/*
+ * _rpc_worker - service queued connections until the RPC manager exits
+ */
+static void *_rpc_worker(void *no_data)
+{
+	rpc_conn_t *conn;
+	struct timeval now;
+	uint32_t latency, wait;
+	int c;
+	DEF_TIMERS;
 
 #if HAVE_SYS_PRCTL_H
 	if (prctl(PR_SET_NAME, "srvcn", NULL, NULL, NULL) < 0) {
 		error("%s: cannot set my name to %s %m", __func__, "srvcn");
 	}
 #endif
-	slurm_msg_t_init(&msg);
-	msg.flags |= SLURM_MSG_KEEP_BUFFER;
+
+	while (1) {
+		slurm_mutex_lock(&rpc_queue_mutex);
+		while (!(conn = _rpc_class_dequeue()) && !rpc_workers_stop)
+			slurm_cond_wait(&rpc_queue_cond, &rpc_queue_mutex);
+		if (!conn) {
+			slurm_mutex_unlock(&rpc_queue_mutex);
+			break;
+		}
+		gettimeofday(&now, NULL);
+		wait = ((now.tv_sec - conn->queue_time.tv_sec) * 1000000) +
+		       now.tv_usec - conn->queue_time.tv_usec;
+		slurmctld_diag_stats.rpc_pool_queue_wait += wait;
+		slurmctld_diag_stats.rpc_class_wait[conn->rpc_class] += wait;
+		slurmctld_diag_stats.rpc_pool_busy++;
+		slurm_mutex_unlock(&rpc_queue_mutex);
+
+		START_TIMER;
+		if (_rpc_receive(conn)) {
+			if (slurmctld_config.shutdown_time)
+				slurmctld_diag_stats.proc_req_raw++;
+			_service_connection(conn);
+		} else
+			conn = NULL;
+		END_TIMER;
+
+		slurm_mutex_lock(&rpc_queue_mutex);
+		slurmctld_diag_stats.rpc_pool_busy--;
+		slurmctld_diag_stats.rpc_pool_busy_time += DELTA_TIMER;
+		if (conn) {
+			/* RPC processed, record latency from data arrival */
+			c = conn->rpc_class;
+			gettimeofday(&now, NULL);
+			latency = ((now.tv_sec - conn->queue_time.tv_sec) *
+				   1000000) +
+				  now.tv_usec - conn->queue_time.tv_usec;
+			slurmctld_diag_stats.rpc_class_cnt[c]++;
+			slurmctld_diag_stats.rpc_class_time[c] += latency;
+			slurmctld_diag_stats.rpc_class_time_max[c] =
+				MAX(slurmctld_diag_stats.rpc_class_time_max[c],
+				    latency);
+			xfree(conn);
+		}
+		slurm_mutex_unlock(&rpc_queue_mutex);
+	}
+
+	return NULL;
+}
+
+/*
+ * _rpc_receive - unpack and authenticate the RPC buffered by _rpc_read()
+ * IN/OUT conn - connection, msg is set on success. On failure the
+ *	connection is closed and conn freed.
+ * RET true if the RPC is ready to be processed
+ */
+static bool _rpc_receive(rpc_conn_t *conn)
+{
+	connection_arg_t *conn_arg = conn->conn_arg;
+	slurm_msg_t *msg = xmalloc(sizeof(slurm_msg_t));
+	Buf buffer;
+	int rc;
+
+	slurm_msg_t_init(msg);
 	/*
-	 * slurm_receive_msg sets msg connection fd to accepted fd. This allows
-	 * possibility for slurmctld_req() to close accepted connection.
+	 * Set msg connection fd to accepted fd. This allows possibility for
+	 * slurmctld_req() to close accepted connection.
 	 */
-	if (slurm_receive_msg(conn->newsockfd, &msg, 0) != 0) {
+	msg->conn_fd = conn_arg->newsockfd;
+	buffer = create_buf(conn->msg_buf, conn->msg_len);
+	conn->msg_buf = NULL;
+	rc = slurm_unpack_received_msg(msg, conn_arg->newsockfd, buffer);
+	msg->buffer = buffer;	/* as SLURM_MSG_KEEP_BUFFER */
+	if (rc != 0) {
 		char addr_buf[32];
-		slurm_print_slurm_addr(&conn->cli_addr, addr_buf,
+		slurm_print_slurm_addr(&conn_arg->cli_addr, addr_buf,
 				       sizeof(addr_buf));
-		error("slurm_receive_msg [%s]: %m", addr_buf);
+		error("slurm_unpack_received_msg [%s]: %m", addr_buf);
 		/* close the new socket */
-		close(conn->newsockfd);
+		close(conn_arg->newsockfd);
 		goto cleanup;
 	}
 
 	if (errno != SLURM_SUCCESS) {
 		if (errno == SLURM_PROTOCOL_VERSION_ERROR) {
-			slurm_send_rc_msg(&msg, SLURM_PROTOCOL_VERSION_ERROR);
+			slurm_send_rc_msg(msg, SLURM_PROTOCOL_VERSION_ERROR);
 		} else
-			info("_service_connection/slurm_receive_msg %m");
-	} else {
-		/* process the request */
-		slurmctld_req(&msg, conn);
+			info("_rpc_receive/slurm_receive_msg %m");
+		if ((conn_arg->newsockfd >= 0) &&
+		    (close(conn_arg->newsockfd) < 0))
+			error ("close(%d): %m",  conn_arg->newsockfd);
+		goto cleanup;
 	}
 
-	if ((conn->newsockfd >= 0) && (close(conn->newsockfd) < 0))
-		error ("close(%d): %m",  conn->newsockfd);
+	conn->msg = msg;
+	return true;
 
 cleanup:
-	slurm_free_msg_members(&msg);
-	xfree(arg);
+	slurm_free_msg_members(msg);
+	xfree(msg);
+	xfree(conn_arg);
+	xfree(conn);
 	server_thread_decr();
+	return false;
+}
+
+/*
+ * _service_connection - service the RPC
+ * IN/OUT conn - connection with the RPC read by _rpc_receive(). The message
+ *	and connection_arg_t are freed and cleared upon completion.
+ */
+static void _service_connection(rpc_conn_t *conn)
+{
+	connection_arg_t *conn_arg = conn->conn_arg;
+
+	/* process the request */
+	slurmctld_req(conn->msg, conn_arg);
 
-	return return_code;
+	if ((conn_arg->newsockfd >= 0) && (close(conn_arg->newsockfd) < 0))
+		error ("close(%d): %m",  conn_arg->newsockfd);
+
+	slurm_free_msg_members(conn->msg);
+	xfree(conn->msg);
+	xfree(conn->conn_arg);
+	server_thread_decr();
 }
 
-/* Increment slurmctld_config.server_thread_count and don't return
- * until its value is no larger than MAX_SERVER_THREADS,
- * RET true unless shutdown in progress */
-static bool _wait_for_server_thread(void)
+/* Increment slurmctld_config.server_thread_count unless that would exceed
+ * max_server_threads, never blocks.
+ * RET true if incremented, false if at the limit or shutdown in progress */
+static bool _server_thread_try_incr(void)
 {
-	bool print_it = true;
 	bool rc = true;
 
 	slurm_mutex_lock(&slurmctld_config.thread_count_lock);
-	while (1) {
-		if (slurmctld_config.shutdown_time) {
-			rc = false;
-			break;
-		}
-		if (slurmctld_config.server_thread_count < max_server_threads) {
-			slurmctld_config.server_thread_count++;
-			break;
-		} else {
-			/* wait for state change and retry,
-			 * just a delay and not an error.
-			 * This can happen when the epilog completes
-			 * on a bunch of nodes at the same time, which
-			 * can easily happen for highly parallel jobs. */
-			if (print_it) {
-				static time_t last_print_time = 0;
-				time_t now = time(NULL);
-				if (difftime(now, last_print_time) > 2) {
-					verbose("server_thread_count over "
-						"limit (%d), waiting",
-						slurmctld_config.
-						server_thread_count);
-					last_print_time = now;
-				}
-				print_it = false;
-			}
-			slurm_cond_wait(&slurmctld_config.thread_count_cond,
-					&slurmctld_config.thread_count_lock);
-		}
+	if (slurmctld_config.shutdown_time) {
+		rc = false;
+	} else if (slurmctld_config.server_thread_count < max_server_threads) {
+		slurmctld_config.server_thread_count++;
+	} else {
+		/*
+		 * Just a delay and not an error.
+		 * This can happen when the epilog completes
+		 * on a bunch of nodes at the same time, which
+		 * can easily happen for highly parallel jobs.
+		 */
+		static time_t last_print_time = 0;
+		time_t now = time(NULL);
+		if (difftime(now, last_print_time) > 2) {
+			verbose("server_thread_count over limit (%d), waiting",
+				slurmctld_config.server_thread_count);
+			last_print_time = now;
+		}
+		rc = false;
 	}
 	slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
 	return rc;
@@ -120,6 +120,16 @@
 #define JOB_STATE_VERSION     "PROTOCOL_VERSION"
 #define JOB_CKPT_VERSION      "PROTOCOL_VERSION"
 
+/* Record types in the job_state.journal file */
+#define JOB_JOURNAL_UPDATE    0x0001
+#define JOB_JOURNAL_PURGE     0x0002
+/* Maximum seconds between full job_state snapshots when journaling */
+#define JOB_JOURNAL_COMPACT_TIME 600
+
+/* Packed job_info records cached per job, by protocol version and flags */
+#define JOB_PACK_CACHE_SLOTS  4
+#define JOB_PACK_CACHE_LOCKS 64
+
 typedef enum {
 	JOB_HASH_JOB,
 	JOB_HASH_ARRAY_JOB,
@@ -135,6 +145,7 @@ typedef struct {
 
 typedef struct {
 	Buf       buffer;
+	job_info_filter_t *filter;
 	uint32_t  filter_uid;
 	uint32_t *jobs_packed;
 	uint16_t  protocol_version;
@@ -142,6 +153,23 @@ typedef struct {
 	uid_t     uid;
 } _foreach_pack_job_info_t;
 
+/*
+ * A job_info record packed by pack_job(). It may be reused only within the
+ * second it was packed, as some fields are relative to the current time, and
+ * only while neither the job nor job_pack_epoch have been marked dirty.
+ */
+struct job_pack_cache {
+	uint16_t protocol_version;
+	uint16_t show_flags;
+	uint32_t skip_fields;
+	uint32_t dirty_gen;		/* job_ptr->dirty_gen when packed */
+	uint32_t epoch;			/* job_pack_epoch when packed */
+	time_t   pack_time;
+	uint32_t size;
+	uint32_t alloc_size;
+	char    *data;
+};
+
 /* Global variables */
 List   job_list = NULL;		/* job_record list */
 time_t last_job_update;		/* time of last update to job records */
@@ -161,9 +189,20 @@ static struct   job_record **job_array_hash_j = NULL;
 static struct   job_record **job_array_hash_t = NULL;
 static bool     kill_invalid_dep;
 static time_t   last_file_write_time = (time_t) 0;
+static bool     journal_compact = true;	/* next save must be a snapshot */
+static pthread_mutex_t journal_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t *journal_purge_ids = NULL; /* saved jobs purged since */
+static int      journal_purge_cnt = 0;	   /* last journal write */
+static int      journal_purge_size = 0;
+static uint32_t journal_epoch = 0;	/* job_pack_epoch at last save */
+static bool     journal_active = false;	/* job_state_journal configured */
+static uint32_t journal_size = 0;	/* bytes in job_state.journal */
+static uint32_t snapshot_size = 0;	/* bytes in job_state */
 static uint32_t max_array_size = NO_VAL;
 static bitstr_t *requeue_exit = NULL;
 static bitstr_t *requeue_exit_hold = NULL;
+static uint32_t job_pack_epoch = 0;	/* bumped by job_mark_dirty(NULL) */
+static pthread_mutex_t job_pack_cache_mutex[JOB_PACK_CACHE_LOCKS];
 static bool     validate_cfgd_licenses = true;
 
 /* Local functions */
@@ -212,16 +251,21 @@ static uint32_t _max_switch_wait(uint32_t input_wait);
 static void _notify_srun_missing_step(struct job_record *job_ptr, int node_inx,
 				      time_t now, time_t node_boot_time);
 static Buf  _open_job_state_file(char **state_file);
+static int  _load_job_state_journal(time_t snap_time, bool ids_only,
+				    int *job_cnt);
 static time_t _get_last_job_state_write_time(void);
 static void _pack_job_for_ckpt (struct job_record *job_ptr, Buf buffer);
+static void _pack_job_cached(struct job_record *job_ptr, uint16_t show_flags,
+			     uint32_t skip_fields, Buf buffer,
+			     uint16_t protocol_version, uid_t uid);
+static void _job_pack_cache_free(struct job_record *job_ptr);
 static void _pack_default_job_details(struct job_record *job_ptr,
-				      Buf buffer,
+				      uint32_t skip_fields, Buf buffer,
 				      uint16_t protocol_version);
 static void _pack_pending_job_details(struct job_details *detail_ptr,
-				      Buf buffer,
+				      uint32_t skip_fields, Buf buffer,
 				      uint16_t protocol_version);
 static bool _parse_array_tok(char *tok, bitstr_t *array_bitmap, uint32_t max);
-static void _purge_missing_jobs(int node_inx, time_t now);
 static int  _read_data_array_from_file(int fd, char *file_name, char ***data,
 				       uint32_t * size,
 				       struct job_record *job_ptr);
@@ -790,10 +834,249 @@ static slurmdb_qos_rec_t *_determine_and_validate_qos(
 	return qos_ptr;
 }
 
+/* Write the contents of a buffer to an open state save file */
+static int _write_job_state_buf(int fd, Buf buffer, char *file_name)
+{
+	int pos = 0, nwrite, amount;
+	char *data;
+
+	nwrite = get_buf_offset(buffer);
+	data = (char *)get_buf_data(buffer);
+	while (nwrite > 0) {
+		amount = write(fd, &data[pos], nwrite);
+		if ((amount < 0) && (errno != EINTR)) {
+			error("Error writing file %s, %m", file_name);
+			return errno;
+		}
+		if (amount < 0)
+			continue;
+		nwrite -= amount;
+		pos    += amount;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+/* Return a FNV-1a hash of the buffer contents from "offset" to its end */
+static uint64_t _job_state_hash(Buf buffer, uint32_t offset)
+{
+	uint64_t hash = 0xcbf29ce484222325;
+	uint32_t i, end = get_buf_offset(buffer);
+	unsigned char *data = (unsigned char *) get_buf_data(buffer);
+
+	for (i = offset; i < end; i++) {
+		hash ^= data[i];
+		hash *= 0x100000001b3;
+	}
+
+	/* Zero is reserved to flag a job which has never been saved */
+	return hash ? hash : 1;
+}
+
+/* Hash of a job record written to a job_state snapshot */
+typedef struct {
+	uint32_t job_id;
+	uint32_t dirty_gen;
+	uint64_t hash;
+} job_state_saved_t;
+
+/*
+ * Note that a job which may have been written to state save was purged.
+ * A job packed into a snapshot being written has no state_hash yet, so every
+ * purge is recorded while journaling.
+ */
+static void _job_state_journal_purge(uint32_t job_id)
+{
+	slurm_mutex_lock(&journal_mutex);
+	if (!journal_active) {
+		slurm_mutex_unlock(&journal_mutex);
+		return;
+	}
+	if (journal_purge_cnt >= journal_purge_size) {
+		journal_purge_size = MAX(1024, journal_purge_size * 2);
+		xrealloc(journal_purge_ids,
+			 sizeof(uint32_t) * journal_purge_size);
+	}
+	journal_purge_ids[journal_purge_cnt++] = job_id;
+	slurm_mutex_unlock(&journal_mutex);
+}
+
+/*
+ * Start a new, empty job state journal which applies on top of the job_state
+ * snapshot file written at time "snap_time".
+ * Uses a rename so a partially written journal is never found by
+ * load_all_job_state().
+ * RET 0 or error code
+ */
+static int _reset_job_state_journal(time_t snap_time)
+{
+	int error_code, log_fd;
+	char *reg_file, *new_file;
+	Buf buffer = init_buf(BUF_SIZE);
+
+	packstr(JOB_STATE_VERSION, buffer);
+	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack_time(snap_time, buffer);
+
+	reg_file = xstrdup_printf("%s/job_state.journal",
+				  slurmctld_conf.state_save_location);
+	new_file = xstrdup_printf("%s/job_state.journal.new",
+				  slurmctld_conf.state_save_location);
+	log_fd = open(new_file, O_CREAT|O_WRONLY|O_TRUNC|O_CLOEXEC, 0600);
+	if (log_fd < 0) {
+		error("Can't save state, create file %s error %m", new_file);
+		error_code = errno;
+	} else {
+		int rc;
+		error_code = _write_job_state_buf(log_fd, buffer, new_file);
+		rc = fsync_and_close(log_fd, "job journal");
+		if (rc && !error_code)
+			error_code = rc;
+	}
+	if (error_code) {
+		(void) unlink(new_file);
+		(void) unlink(reg_file);
+	} else if (rename(new_file, reg_file)) {
+		error("Can't rename %s to %s: %m", new_file, reg_file);
+		error_code = errno;
+		(void) unlink(new_file);
+		(void) unlink(reg_file);
+	}
+	xfree(new_file);
+	xfree(reg_file);
+	free_buf(buffer);
+
+	journal_size = 0;
+	return error_code;
+}
+
+/*
+ * Append one batch of changed and purged job records to the job state journal.
+ * Only jobs marked by job_mark_dirty() since they were last saved are packed,
+ * and of those only jobs whose packed state differs from what was last saved
+ * are written. Changes made without job_mark_dirty() are saved by the next
+ * job_state snapshot.
+ * Batch format: length, time, job_id_sequence, record count, then records of
+ * type JOB_JOURNAL_UPDATE (job_id plus full job state) or JOB_JOURNAL_PURGE
+ * (job_id only).
+ * RET 0 or error code
+ */
+static int _dump_job_state_journal(time_t now)
+{
+	/* Save high-water mark to avoid buffer growth with copies */
+	static int high_buffer_size = BUF_SIZE;
+	int error_code = SLURM_SUCCESS, log_fd, i;
+	uint32_t cnt_offset, rec_offset, data_offset, end_offset;
+	uint32_t rec_cnt = 0;
+	uint64_t hash;
+	bool all_jobs;
+	char *reg_file;
+	/* Locks: Read config and job */
+	slurmctld_lock_t job_read_lock =
+		{ READ_LOCK, READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
+	ListIterator job_iterator;
+	struct job_record *job_ptr;
+	Buf buffer = init_buf(high_buffer_size);
+
+	pack32(0, buffer);		/* batch length, set below */
+	pack_time(now, buffer);
+
+	lock_slurmctld(job_read_lock);
+	pack32(job_id_sequence, buffer);
+	cnt_offset = get_buf_offset(buffer);
+	pack32(0, buffer);		/* record count, set below */
+
+	slurm_mutex_lock(&journal_mutex);
+	for (i = 0; i < journal_purge_cnt; i++, rec_cnt++) {
+		pack16(JOB_JOURNAL_PURGE, buffer);
+		pack32(journal_purge_ids[i], buffer);
+	}
+	journal_purge_cnt = 0;
+	slurm_mutex_unlock(&journal_mutex);
+
+	/* job_mark_dirty(NULL) means any job may have changed */
+	all_jobs = (journal_epoch != job_pack_epoch);
+	journal_epoch = job_pack_epoch;
+
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+		if (!all_jobs && job_ptr->state_hash &&
+		    (job_ptr->state_gen == job_ptr->dirty_gen))
+			continue;
+		rec_offset = get_buf_offset(buffer);
+		pack16(JOB_JOURNAL_UPDATE, buffer);
+		pack32(job_ptr->job_id, buffer);
+		data_offset = get_buf_offset(buffer);
+		_dump_job_state(job_ptr, buffer);
+		hash = _job_state_hash(buffer, data_offset);
+		job_ptr->state_gen = job_ptr->dirty_gen;
+		if (hash == job_ptr->state_hash) {
+			/* Unchanged since last save, discard the record */
+			set_buf_offset(buffer, rec_offset);
+			continue;
+		}
+		job_ptr->state_hash = hash;
+		rec_cnt++;
+	}
+	list_iterator_destroy(job_iterator);
+	reg_file = xstrdup_printf("%s/job_state.journal",
+				  slurmctld_conf.state_save_location);
+	unlock_slurmctld(job_read_lock);
+
+	if (!rec_cnt) {
+		xfree(reg_file);
+		free_buf(buffer);
+		return SLURM_SUCCESS;
+	}
+
+	end_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	pack32(end_offset - sizeof(uint32_t), buffer);
+	set_buf_offset(buffer, cnt_offset);
+	pack32(rec_cnt, buffer);
+	set_buf_offset(buffer, end_offset);
+	high_buffer_size = MAX(end_offset, high_buffer_size);
+
+	lock_state_files();
+	log_fd = open(reg_file, O_WRONLY|O_APPEND|O_CLOEXEC);
+	if (log_fd < 0) {
+		error("Can't save state, open file %s error %m", reg_file);
+		error_code = errno;
+	} else {
+		int rc;
+		error_code = _write_job_state_buf(log_fd, buffer, reg_file);
+		rc = fsync_and_close(log_fd, "job journal");
+		if (rc && !error_code)
+			error_code = rc;
+	}
+	unlock_state_files();
+
+	if (error_code) {
+		/*
+		 * The saved hashes no longer match what is on disk, so
+		 * the next save must write a full snapshot.
+		 */
+		journal_compact = true;
+		schedule_job_save();
+	} else {
+		journal_size += end_offset;
+		debug2("%s: wrote %u job records (%u bytes)",
+		       __func__, rec_cnt, end_offset);
+	}
+	xfree(reg_file);
+	free_buf(buffer);
+	return error_code;
+}
+
 /*
  * dump_all_job_state - save the state of all jobs to file for checkpoint
  *	Changes here should be reflected in load_last_job_id() and
  *	load_all_job_state().
+ *	With SlurmctldParameters=job_state_journal, only jobs changed since the
+ *	previous save are appended to the job_state.journal file and a full
+ *	job_state snapshot is written only once the journal grows larger than
+ *	the last snapshot, JOB_JOURNAL_COMPACT_TIME has passed or slurmctld is
+ *	shutting down.
  * RET 0 or error code
  */
 int dump_all_job_state(void)
@@ -801,16 +1084,20 @@ int dump_all_job_state(void)
 	/* Save high-water mark to avoid buffer growth with copies */
 	static int high_buffer_size = (1024 * 1024);
 	int error_code = SLURM_SUCCESS, log_fd;
-	char *old_file, *new_file, *reg_file;
+	char *old_file, *new_file, *reg_file, *ctld_params;
 	struct stat stat_buf;
 	/* Locks: Read config and job */
 	slurmctld_lock_t job_read_lock =
 		{ READ_LOCK, READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
 	ListIterator job_iterator;
 	struct job_record *job_ptr;
-	Buf buffer = init_buf(high_buffer_size);
+	Buf buffer;
 	time_t now = time(NULL);
 	time_t last_state_file_time;
+	bool use_journal;
+	uint32_t rec_offset;
+	job_state_saved_t *saved = NULL;
+	int saved_cnt = 0, saved_size = 0, purge_cnt, i;
 	DEF_TIMERS;
 
 	START_TIMER;
@@ -833,6 +1120,23 @@ int dump_all_job_state(void)
 		}
 	}
 
+	ctld_params = slurm_get_slurmctld_params();
+	use_journal = xstrcasestr(ctld_params, "job_state_journal");
+	xfree(ctld_params);
+	slurm_mutex_lock(&journal_mutex);
+	journal_active = use_journal;
+	slurm_mutex_unlock(&journal_mutex);
+	if (use_journal && !journal_compact &&
+	    !slurmctld_config.shutdown_time &&
+	    (journal_size < snapshot_size) &&
+	    (difftime(now, last_file_write_time) < JOB_JOURNAL_COMPACT_TIME)) {
+		error_code = _dump_job_state_journal(now);
+		END_TIMER2("dump_all_job_state");
+		return error_code;
+	}
+
+	buffer = init_buf(high_buffer_size);
+
 	/* write header: version, time */
 	packstr(JOB_STATE_VERSION, buffer);
 	pack16(SLURM_PROTOCOL_VERSION, buffer);
@@ -850,12 +1154,29 @@ int dump_all_job_state(void)
 
 	/* write individual job records */
 	lock_slurmctld(job_read_lock);
+	if (use_journal) {
+		saved_size = list_count(job_list);
+		saved = xmalloc(sizeof(job_state_saved_t) * saved_size);
+	}
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+		rec_offset = get_buf_offset(buffer);
 		_dump_job_state(job_ptr, buffer);
+		if (saved_cnt < saved_size) {
+			saved[saved_cnt].job_id = job_ptr->job_id;
+			saved[saved_cnt].dirty_gen = job_ptr->dirty_gen;
+			saved[saved_cnt].hash = _job_state_hash(buffer,
+								rec_offset);
+			saved_cnt++;
+		}
 	}
 	list_iterator_destroy(job_iterator);
+	journal_epoch = job_pack_epoch;
 
+	/* Jobs purged so far are already absent from this snapshot */
+	slurm_mutex_lock(&journal_mutex);
+	purge_cnt = journal_purge_cnt;
+	slurm_mutex_unlock(&journal_mutex);
 
 	/* write the buffer to file */
 	old_file = xstrdup(slurmctld_conf.state_save_location);
@@ -888,30 +1209,20 @@ int dump_all_job_state(void)
 		      new_file);
 		error_code = errno;
 	} else {
-		int pos = 0, nwrite, amount, rc;
-		char *data;
-
-		nwrite = get_buf_offset(buffer);
-		data = (char *)get_buf_data(buffer);
-		high_buffer_size = MAX(nwrite, high_buffer_size);
-		while (nwrite > 0) {
-			amount = write(log_fd, &data[pos], nwrite);
-			if ((amount < 0) && (errno != EINTR)) {
-				error("Error writing file %s, %m", new_file);
-				error_code = errno;
-				break;
-			}
-			nwrite -= amount;
-			pos    += amount;
-		}
+		int rc;
 
+		high_buffer_size = MAX(get_buf_offset(buffer),
+				       high_buffer_size);
+		error_code = _write_job_state_buf(log_fd, buffer, new_file);
 		rc = fsync_and_close(log_fd, "job");
 		if (rc && !error_code)
 			error_code = rc;
 	}
-	if (error_code)
+	if (error_code) {
 		(void) unlink(new_file);
-	else {			/* file shuffle */
+		/* Saved hashes and purges no longer describe the files */
+		journal_compact = true;
+	} else {		/* file shuffle */
 		(void) unlink(old_file);
 		if (link(reg_file, old_file))
 			debug4("unable to create link for %s -> %s: %m",
@@ -922,12 +1233,46 @@ int dump_all_job_state(void)
 			       new_file, reg_file);
 		(void) unlink(new_file);
 		last_file_write_time = now;
+		snapshot_size = get_buf_offset(buffer);
+
+		/* The new snapshot supersedes any existing journal */
+		if (!use_journal) {
+			xfree(reg_file);
+			reg_file = xstrdup_printf("%s/job_state.journal",
+					slurmctld_conf.state_save_location);
+			(void) unlink(reg_file);
+			journal_compact = true;
+		} else if (_reset_job_state_journal(now))
+			journal_compact = true;
+		else
+			journal_compact = false;
 	}
 	xfree(old_file);
 	xfree(reg_file);
 	xfree(new_file);
 	unlock_state_files();
 
+	if (!error_code) {
+		/* The snapshot is in place, record what it holds */
+		slurm_mutex_lock(&journal_mutex);
+		if (purge_cnt) {
+			journal_purge_cnt -= purge_cnt;
+			memmove(journal_purge_ids, journal_purge_ids + purge_cnt,
+				sizeof(uint32_t) * journal_purge_cnt);
+		}
+		slurm_mutex_unlock(&journal_mutex);
+
+		lock_slurmctld(job_read_lock);
+		for (i = 0; i < saved_cnt; i++) {
+			if (!(job_ptr = find_job_record(saved[i].job_id)))
+				continue;
+			job_ptr->state_gen = saved[i].dirty_gen;
+			job_ptr->state_hash = saved[i].hash;
+		}
+		unlock_slurmctld(job_read_lock);
+	}
+	xfree(saved);
+
 	free_buf(buffer);
 	END_TIMER2("dump_all_job_state");
 	return error_code;
@@ -1015,6 +1360,7 @@ extern void set_job_tres_alloc_str(struct job_record *job_ptr,
 extern void backup_slurmctld_restart(void)
 {
 	last_file_write_time = (time_t) 0;
+	journal_compact = true;
 }
 
 /* Return the time stamp in the current job state save file, 0 is returned on
@@ -1115,9 +1461,13 @@ extern int load_all_job_state(void)
 			goto unpack_error;
 		job_cnt++;
 	}
+	free_buf(buffer);
+
+	error_code = _load_job_state_journal(buf_time, false, &job_cnt);
+	if (error_code == ENOENT)
+		error_code = SLURM_SUCCESS;
 	debug3("Set job_id_sequence to %u", job_id_sequence);
 
-	free_buf(buffer);
 	info("Recovered information about %d jobs", job_cnt);
 	return error_code;
 
@@ -1130,6 +1480,109 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/*
+ * Replay the job state journal on top of the job_state snapshot.
+ * Only a journal started against the snapshot written at "snap_time" is used
+ * and a partially written batch at the end of the journal is discarded.
+ * IN snap_time - time stamp from the job_state file header
+ * IN ids_only - only recover job_id_sequence, see load_last_job_id()
+ * IN/OUT job_cnt - incremented by the count of job records recovered,
+ *	may be NULL
+ * RET 0 or error code
+ */
+static int _load_job_state_journal(time_t snap_time, bool ids_only,
+				   int *job_cnt)
+{
+	char *state_file, *ver_str = NULL;
+	uint32_t ver_str_len, batch_len, batch_end, rec_cnt, rec_inx;
+	uint32_t saved_job_id, job_id;
+	uint16_t protocol_version = NO_VAL16, rec_type;
+	time_t journal_time, batch_time;
+	int batch_cnt = 0;
+	Buf buffer;
+
+	state_file = xstrdup_printf("%s/job_state.journal",
+				    slurmctld_conf.state_save_location);
+	lock_state_files();
+	buffer = create_mmap_buf(state_file);
+	unlock_state_files();
+	if (!buffer) {
+		debug("No job state journal file (%s) to recover", state_file);
+		xfree(state_file);
+		return ENOENT;
+	}
+
+	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
+	if (ver_str && !xstrcmp(ver_str, JOB_STATE_VERSION))
+		safe_unpack16(&protocol_version, buffer);
+	xfree(ver_str);
+	safe_unpack_time(&journal_time, buffer);
+	if ((protocol_version == NO_VAL16) || (journal_time != snap_time)) {
+		info("Job state journal %s predates job_state file, ignoring it",
+		     state_file);
+		xfree(state_file);
+		free_buf(buffer);
+		return ENOENT;
+	}
+
+	while (remaining_buf(buffer) >= sizeof(uint32_t)) {
+		safe_unpack32(&batch_len, buffer);
+		if (batch_len > remaining_buf(buffer)) {
+			error("Discarding incomplete record at end of job state journal %s",
+			      state_file);
+			break;
+		}
+		batch_end = get_buf_offset(buffer) + batch_len;
+		safe_unpack_time(&batch_time, buffer);
+		safe_unpack32(&saved_job_id, buffer);
+		if (saved_job_id <= slurmctld_conf.max_job_id)
+			job_id_sequence = MAX(saved_job_id, job_id_sequence);
+		batch_cnt++;
+		if (ids_only) {
+			set_buf_offset(buffer, batch_end);
+			continue;
+		}
+
+		safe_unpack32(&rec_cnt, buffer);
+		for (rec_inx = 0; rec_inx < rec_cnt; rec_inx++) {
+			safe_unpack16(&rec_type, buffer);
+			safe_unpack32(&job_id, buffer);
+			/* A newer record replaces any older one */
+			if (find_job_record(job_id)) {
+				purge_job_record(job_id);
+				if (job_cnt)
+					(*job_cnt)--;
+			}
+			if (rec_type == JOB_JOURNAL_PURGE)
+				continue;
+			if ((rec_type != JOB_JOURNAL_UPDATE) ||
+			    (_load_job_state(buffer, protocol_version) !=
+			     SLURM_SUCCESS))
+				goto unpack_error;
+			if (job_cnt)
+				(*job_cnt)++;
+		}
+		if (get_buf_offset(buffer) != batch_end)
+			goto unpack_error;
+	}
+	debug("Replayed %d batches from job state journal %s",
+	      batch_cnt, state_file);
+
+	xfree(state_file);
+	free_buf(buffer);
+	return SLURM_SUCCESS;
+
+unpack_error:
+	if (!ignore_state_errors)
+		fatal("Incomplete job state journal file %s, start with '-i' to ignore this",
+		      state_file);
+	error("Incomplete job state journal file %s", state_file);
+	xfree(ver_str);
+	xfree(state_file);
+	free_buf(buffer);
+	return SLURM_ERROR;
+}
+
 /*
  * load_last_job_id - load only the last job ID from state save file.
  *	Changes here should be reflected in load_all_job_state().
@@ -1179,6 +1632,9 @@ extern int load_last_job_id( void )
 
 	xfree(ver_str);
 	free_buf(buffer);
+
+	/* Jobs submitted since the last snapshot are only in the journal */
+	(void) _load_job_state_journal(buf_time, true, NULL);
 	return SLURM_SUCCESS;
 
 unpack_error:
@@ -3062,6 +3518,7 @@ static void _rebuild_part_name_list(struct job_record  *job_ptr)
 	if (!job_ptr->part_ptr_list) {
 		job_ptr->partition = xstrdup(job_ptr->part_ptr->name);
 		last_job_update = time(NULL);
+		job_mark_dirty(job_ptr);
 		return;
 	}
 
@@ -3086,6 +3543,7 @@ static void _rebuild_part_name_list(struct job_record  *job_ptr)
 	}
 	list_iterator_destroy(part_iterator);
 	last_job_update = time(NULL);
+	job_mark_dirty(job_ptr);
 }
 
 /*
@@ -3337,8 +3795,10 @@ extern int kill_job_by_part_name(char *part_name)
 	}
 	list_iterator_destroy(job_iterator);
 
-	if (kill_job_cnt)
+	if (kill_job_cnt) {
 		last_job_update = now;
+		job_mark_dirty(NULL);
+	}
 	return kill_job_cnt;
 }
 
@@ -3507,8 +3967,10 @@ extern int kill_job_by_front_end_name(char *node_name)
 	}
 	list_iterator_destroy(job_iterator);
 
-	if (kill_job_cnt)
+	if (kill_job_cnt) {
 		last_job_update = now;
+		job_mark_dirty(NULL);
+	}
 	return kill_job_cnt;
 #else
 	return 0;
@@ -3817,8 +4279,10 @@ extern int kill_running_job_by_node_name(char *node_name)
 
 	}
 	list_iterator_destroy(job_iterator);
-	if (kill_job_cnt)
+	if (kill_job_cnt) {
 		last_job_update = now;
+		job_mark_dirty(NULL);
+	}
 
 	return kill_job_cnt;
 }
@@ -4120,6 +4584,7 @@ int init_job_conf(void)
 	}
 
 	last_job_update = time(NULL);
+	job_mark_dirty(NULL);
 
 	if (!purge_files_list) {
 		purge_files_list = list_create(slurm_destroy_uint32_ptr);
@@ -4199,6 +4664,7 @@ extern struct job_record *job_array_split(struct job_record *job_ptr)
 	job_ptr_pend->db_flags = 0;
 	job_ptr_pend->step_list = save_step_list;
 	job_ptr_pend->db_index = save_db_index;
+	job_ptr_pend->pack_cache = NULL;
 
 	job_ptr_pend->prio_factors = save_prio_factors;
 	slurm_copy_priority_factors_object(job_ptr_pend->prio_factors,
@@ -4326,6 +4792,7 @@ extern struct job_record *job_array_split(struct job_record *job_ptr)
 	job_details = job_ptr->details;
 	details_new = job_ptr_pend->details;
 	memcpy(details_new, job_details, sizeof(struct job_details));
+	details_new->depend_time = 0;
 
 	/*
 	 * Reset the preempt_start_time or high priority array jobs will hang
@@ -4389,6 +4856,10 @@ extern struct job_record *job_array_split(struct job_record *job_ptr)
 	if (job_ptr->fed_details)
 		add_fed_job_info(job_ptr);
 
+	/* Both records change, job_ptr_pend also copied job_ptr's dirty_gen */
+	job_mark_dirty(job_ptr);
+	job_mark_dirty(job_ptr_pend);
+
 	return job_ptr_pend;
 }
 
@@ -4814,6 +5285,7 @@ extern int job_allocate(job_desc_msg_t * job_specs, int immediate,
 	error_code = _select_nodes_parts(job_ptr, no_alloc, NULL, err_msg);
 	if (!test_only) {
 		last_job_update = now;
+		job_mark_dirty(job_ptr);
 	}
 
        /*
@@ -4937,6 +5409,7 @@ static int _job_fail(struct job_record *job_ptr, uint32_t job_state)
 		} else
 			job_ptr->end_time       = now;
 		last_job_update                 = now;
+		job_mark_dirty(job_ptr);
 		job_ptr->job_state = job_state | JOB_COMPLETING;
 		job_ptr->exit_code = 1;
 		job_ptr->state_reason = FAIL_LAUNCH;
@@ -5066,6 +5539,7 @@ extern int job_signal(struct job_record *job_ptr, uint16_t signal,
 	/* let node select plugin do any state-dependent signaling actions */
 	select_g_job_signal(job_ptr, signal);
 	last_job_update = now;
+	job_mark_dirty(job_ptr);
 
 	/* save user ID of the one who requested the job be cancelled */
 	if (signal == SIGKILL)
@@ -5086,6 +5560,7 @@ extern int job_signal(struct job_record *job_ptr, uint16_t signal,
 
 	if (IS_JOB_CONFIGURING(job_ptr) && (signal == SIGKILL)) {
 		last_job_update         = now;
+		job_mark_dirty(job_ptr);
 		job_ptr->end_time       = now;
 		job_ptr->job_state      = JOB_CANCELLED | JOB_COMPLETING;
 		if (flags & KILL_FED_REQUEUE)
@@ -5131,6 +5606,7 @@ extern int job_signal(struct job_record *job_ptr, uint16_t signal,
 		job_term_state = JOB_CANCELLED;
 	if (IS_JOB_SUSPENDED(job_ptr) && (signal == SIGKILL)) {
 		last_job_update         = now;
+		job_mark_dirty(job_ptr);
 		job_ptr->end_time       = job_ptr->suspend_time;
 		job_ptr->tot_sus_time  += difftime(now, job_ptr->suspend_time);
 		job_ptr->job_state      = job_term_state | JOB_COMPLETING;
@@ -5167,6 +5643,7 @@ extern int job_signal(struct job_record *job_ptr, uint16_t signal,
 			job_ptr->time_last_active	= now;
 			job_ptr->end_time		= now;
 			last_job_update			= now;
+			job_mark_dirty(job_ptr);
 			job_ptr->job_state = job_term_state | JOB_COMPLETING;
 			if (flags & KILL_FED_REQUEUE)
 				job_ptr->job_state |= JOB_REQUEUE;
@@ -5468,6 +5945,7 @@ extern int job_str_signal(char *job_id_str, uint16_t signal, uint16_t flags,
 
 	if (IS_JOB_PENDING(job_ptr) &&
 	    job_ptr->array_recs && job_ptr->array_recs->task_id_bitmap) {
+		job_mark_dirty(job_ptr);
 		/* Ensure bitmap sizes match for AND operations */
 		len = bit_size(job_ptr->array_recs->task_id_bitmap);
 		i_last++;
@@ -5492,6 +5970,7 @@ extern int job_str_signal(char *job_id_str, uint16_t signal, uint16_t flags,
 						       task_id_bitmap);
 			if (!new_task_count) {
 				last_job_update		= now;
+				job_mark_dirty(job_ptr);
 				job_ptr->job_state	= JOB_CANCELLED;
 				job_ptr->start_time	= now;
 				job_ptr->end_time	= now;
@@ -5835,6 +6314,7 @@ static int _job_complete(struct job_record *job_ptr, uid_t uid, bool requeue,
 	}
 
 	last_job_update = now;
+	job_mark_dirty(job_ptr);
 	job_ptr->time_last_active = now;   /* Timer for resending kill RPC */
 	if (job_comp_flag) {	/* job was running */
 		build_cg_bitmap(job_ptr);
@@ -8314,6 +8794,7 @@ extern void job_config_fini(struct job_record *job_ptr)
 	time_t now = time(NULL);
 
 	last_job_update = now;
+	job_mark_dirty(job_ptr);
 	job_ptr->job_state &= ~JOB_CONFIGURING;
 	if (IS_JOB_POWER_UP_NODE(job_ptr)) {
 		info("Resetting %pJ start time for node power up", job_ptr);
@@ -8490,6 +8971,7 @@ void job_time_limit(void)
 			job_ptr->state_reason = WAIT_NO_REASON;
 			set_job_prio(job_ptr);
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 		}
 
 		if (_pack_configuring_test(job_ptr))
@@ -8513,6 +8995,7 @@ void job_time_limit(void)
 
 			if (job_ptr->end_time <= now) {
 				last_job_update = now;
+				job_mark_dirty(job_ptr);
 				info("%s: Preemption GraceTime reached %pJ",
 				     __func__, job_ptr);
 				job_ptr->job_state = JOB_PREEMPTED |
@@ -8577,6 +9060,7 @@ void job_time_limit(void)
 				over_run = now - (over_time_limit  * 60);
 			if (job_ptr->end_time <= over_run) {
 				last_job_update = now;
+				job_mark_dirty(job_ptr);
 				info("Time limit exhausted for %pJ", job_ptr);
 				_job_timed_out(job_ptr, false);
 				job_ptr->state_reason = FAIL_TIMEOUT;
@@ -8589,6 +9073,7 @@ void job_time_limit(void)
 		    !(job_ptr->resv_ptr->flags & RESERVE_FLAG_FLEX) &&
 		    (job_ptr->resv_ptr->end_time + resv_over_run) < time(NULL)){
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			info("Reservation ended for %pJ", job_ptr);
 			_job_timed_out(job_ptr, false);
 			job_ptr->state_reason = FAIL_TIMEOUT;
@@ -8608,6 +9093,7 @@ void job_time_limit(void)
 
 		if (job_ptr->state_reason == FAIL_TIMEOUT) {
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			_job_timed_out(job_ptr, false);
 			xfree(job_ptr->state_desc);
 			goto time_check;
@@ -9060,6 +9546,10 @@ static void _list_delete_job(void *job_entry)
 	xassert (job_ptr->magic == JOB_MAGIC);
 	job_ptr->magic = 0;	/* make sure we don't delete record twice */
 
+	_job_state_journal_purge(job_ptr->job_id);
+	_job_pack_cache_free(job_ptr);
+	depend_mark_dirty(job_ptr);
+
 	/* Remove record from fed_job_list */
 	fed_mgr_remove_fed_job_info(job_ptr->job_id);
 
@@ -9322,6 +9812,104 @@ static bool _hide_job(struct job_record *job_ptr, uid_t uid,
 	return false;
 }
 
+static int _job_filter_uid_match(void *x, void *key)
+{
+	uint32_t *uid_ptr = (uint32_t *) x;
+	uint32_t *job_uid = (uint32_t *) key;
+
+	return (*uid_ptr == *job_uid);
+}
+
+static bool _job_filter_str_match(List str_list, char *str)
+{
+	ListIterator iter;
+	char *list_str;
+	bool match = false;
+
+	if (!str)
+		return false;
+	iter = list_iterator_create(str_list);
+	while ((list_str = list_next(iter))) {
+		if (!xstrcasecmp(list_str, str)) {
+			match = true;
+			break;
+		}
+	}
+	list_iterator_destroy(iter);
+
+	return match;
+}
+
+static bool _job_filter_part_match(List part_list, struct job_record *job_ptr)
+{
+	char *tmp_str, *tok, *save_ptr = NULL;
+	bool match = false;
+
+	/* Match the partition(s) reported by pack_job() */
+	if (!IS_JOB_PENDING(job_ptr) && job_ptr->part_ptr)
+		return _job_filter_str_match(part_list,
+					     job_ptr->part_ptr->name);
+	if (!job_ptr->partition)
+		return false;
+
+	tmp_str = xstrdup(job_ptr->partition);
+	tok = strtok_r(tmp_str, ",", &save_ptr);
+	while (tok && !match) {
+		match = _job_filter_str_match(part_list, tok);
+		tok = strtok_r(NULL, ",", &save_ptr);
+	}
+	xfree(tmp_str);
+
+	return match;
+}
+
+static bool _job_filter_state_match(List state_list,
+				    struct job_record *job_ptr)
+{
+	ListIterator iter;
+	uint32_t *state_ptr;
+	uint32_t job_state = job_ptr->job_state & (~JOB_UPDATE_DB);
+	bool match = false;
+
+	iter = list_iterator_create(state_list);
+	while ((state_ptr = list_next(iter))) {
+		if (*state_ptr & JOB_STATE_FLAGS) {
+			if (*state_ptr & job_state)
+				match = true;
+		} else if (*state_ptr == job_state)
+			match = true;
+		if (match)
+			break;
+	}
+	list_iterator_destroy(iter);
+
+	return match;
+}
+
+/* Determine if a job matches every list set in a job_info_filter_t */
+static bool _job_filter_match(struct job_record *job_ptr,
+			      job_info_filter_t *filter)
+{
+	if (filter->user_list &&
+	    !list_find_first(filter->user_list, _job_filter_uid_match,
+			     &job_ptr->user_id))
+		return false;
+	if (filter->account_list &&
+	    !_job_filter_str_match(filter->account_list, job_ptr->account))
+		return false;
+	if (filter->name_list &&
+	    !_job_filter_str_match(filter->name_list, job_ptr->name))
+		return false;
+	if (filter->part_list &&
+	    !_job_filter_part_match(filter->part_list, job_ptr))
+		return false;
+	if (filter->state_list &&
+	    !_job_filter_state_match(filter->state_list, job_ptr))
+		return false;
+
+	return true;
+}
+
 static void _pack_job(struct job_record *job_ptr,
 		      _foreach_pack_job_info_t *pack_info)
 {
@@ -9331,6 +9919,10 @@ static void _pack_job(struct job_record *job_ptr,
 	    (pack_info->filter_uid != job_ptr->user_id))
 		return;
 
+	if (pack_info->filter &&
+	    !_job_filter_match(job_ptr, pack_info->filter))
+		return;
+
 	if (((pack_info->show_flags & SHOW_ALL) == 0) &&
 	    (pack_info->uid != 0) &&
 	    _all_parts_hidden(job_ptr, pack_info->uid))
@@ -9339,8 +9931,10 @@ static void _pack_job(struct job_record *job_ptr,
 	if (_hide_job(job_ptr, pack_info->uid, pack_info->show_flags))
 		return;
 
-	pack_job(job_ptr, pack_info->show_flags, pack_info->buffer,
-		 pack_info->protocol_version, pack_info->uid);
+	_pack_job_cached(job_ptr, pack_info->show_flags,
+			 pack_info->filter ? pack_info->filter->skip_fields : 0,
+			 pack_info->buffer, pack_info->protocol_version,
+			 pack_info->uid);
 
 	(*pack_info->jobs_packed)++;
 }
@@ -9367,6 +9961,7 @@ static int _foreach_pack_jobid(void *object, void *arg)
  * IN show_flags - job filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN filter_uid - pack only jobs belonging to this user if not NO_VAL
+ * IN filter - pack only matching jobs and fields, NULL for all
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
  * NOTE: change _unpack_job_desc_msg() in common/slurm_protocol_pack.c
@@ -9374,7 +9969,7 @@ static int _foreach_pack_jobid(void *object, void *arg)
  */
 extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid, uint32_t filter_uid,
-			  uint16_t protocol_version)
+			  job_info_filter_t *filter, uint16_t protocol_version)
 {
 	uint32_t jobs_packed = 0, tmp_offset;
 	_foreach_pack_job_info_t pack_info = {0};
@@ -9394,6 +9989,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 
 	/* write individual job records */
 	pack_info.buffer           = buffer;
+	pack_info.filter           = filter;
 	pack_info.filter_uid       = filter_uid;
 	pack_info.jobs_packed      = &jobs_packed;
 	pack_info.protocol_version = protocol_version;
@@ -9425,6 +10021,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
  * IN job_ids - list of job_ids to pack
  * IN uid - uid of user making request (for partition filtering)
  * IN filter_uid - pack only jobs belonging to this user if not NO_VAL
+ * IN filter - pack only matching jobs and fields, NULL for all
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
  * NOTE: change _unpack_job_desc_msg() in common/slurm_protocol_pack.c
@@ -9432,7 +10029,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
  */
 extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 			   uint16_t show_flags, uid_t uid, uint32_t filter_uid,
-			   uint16_t protocol_version)
+			   job_info_filter_t *filter, uint16_t protocol_version)
 {
 	uint32_t jobs_packed = 0, tmp_offset;
 	_foreach_pack_job_info_t pack_info = {0};
@@ -9452,6 +10049,7 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 
 	/* write individual job records */
 	pack_info.buffer           = buffer;
+	pack_info.filter           = filter;
 	pack_info.filter_uid       = filter_uid;
 	pack_info.jobs_packed      = &jobs_packed;
 	pack_info.protocol_version = protocol_version;
@@ -9480,8 +10078,8 @@ static int _pack_hetero_job(struct job_record *job_ptr, uint16_t show_flags,
 	iter = list_iterator_create(job_ptr->pack_job_list);
 	while ((pack_ptr = (struct job_record *) list_next(iter))) {
 		if (pack_ptr->pack_job_id == job_ptr->pack_job_id) {
-			pack_job(pack_ptr, show_flags, buffer, protocol_version,
-				 uid);
+			pack_job(pack_ptr, show_flags, 0, buffer,
+				 protocol_version, uid);
 			job_cnt++;
 		} else {
 			error("%s: Bad pack_job_list for %pJ",
@@ -9535,8 +10133,8 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 		   !job_ptr->array_recs) {
 		/* Pack regular (not array) job */
 		if (!_hide_job(job_ptr, uid, show_flags)) {
-			pack_job(job_ptr, show_flags, buffer, protocol_version,
-				 uid);
+			pack_job(job_ptr, show_flags, 0, buffer,
+				 protocol_version, uid);
 			jobs_packed++;
 		}
 	} else {
@@ -9546,7 +10144,7 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 		if (job_ptr) {
 			packed_head = true;
 			if (!_hide_job(job_ptr, uid, show_flags)) {
-				pack_job(job_ptr, show_flags, buffer,
+				pack_job(job_ptr, show_flags, 0, buffer,
 					 protocol_version, uid);
 				jobs_packed++;
 			}
@@ -9559,7 +10157,7 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 			} else if (job_ptr->array_job_id == job_id) {
 				if (_hide_job(job_ptr, uid, show_flags))
 					break;
-				pack_job(job_ptr, show_flags, buffer,
+				pack_job(job_ptr, show_flags, 0, buffer,
 					 protocol_version, uid);
 				jobs_packed++;
 			}
@@ -9584,6 +10182,147 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 	return SLURM_SUCCESS;
 }
 
+/*
+ * job_mark_dirty - note a change to a job record, invalidating any cached
+ *	copy of its packed job_info and the cached dependency test results of
+ *	jobs which depend upon it
+ * IN job_ptr - job modified, NULL if any or all jobs may have changed
+ * NOTE: job_mark_dirty(NULL) leaves cached dependency test results alone.
+ *	Those only change when a job starts, ends or is purged, which mark the
+ *	job itself, see depend_mark_dirty().
+ */
+extern void job_mark_dirty(struct job_record *job_ptr)
+{
+	if (job_ptr) {
+		job_ptr->dirty_gen++;
+		depend_mark_dirty(job_ptr);
+	} else
+		job_pack_epoch++;
+}
+
+static void _job_pack_cache_init(void)
+{
+	int i;
+
+	for (i = 0; i < JOB_PACK_CACHE_LOCKS; i++)
+		slurm_mutex_init(&job_pack_cache_mutex[i]);
+}
+
+static bool _job_pack_cache_enabled(void)
+{
+	static time_t conf_update = 0;
+	static bool pack_cache = false;
+
+	if (conf_update != slurmctld_conf.last_update) {
+		static pthread_once_t mutex_once = PTHREAD_ONCE_INIT;
+		char *ctld_params = slurm_get_slurmctld_params();
+
+		pthread_once(&mutex_once, _job_pack_cache_init);
+		pack_cache = (xstrcasestr(ctld_params, "job_pack_cache") !=
+			      NULL);
+		xfree(ctld_params);
+		conf_update = slurmctld_conf.last_update;
+	}
+
+	return pack_cache;
+}
+
+static void _job_pack_cache_free(struct job_record *job_ptr)
+{
+	int i;
+
+	if (!job_ptr->pack_cache)
+		return;
+	for (i = 0; i < JOB_PACK_CACHE_SLOTS; i++)
+		xfree(job_ptr->pack_cache[i].data);
+	xfree(job_ptr->pack_cache);
+}
+
+/*
+ * Pack a job's job_info record as pack_job() does, reusing the bytes packed
+ * earlier in the same second for the same protocol version, show_flags and
+ * skip_fields if the job has not been marked dirty since. Enabled by
+ * SlurmctldParameters=job_pack_cache.
+ * NOTE: Called with a job read lock, so concurrent callers serialize access
+ *	to each job's cache with job_pack_cache_mutex.
+ */
+static void _pack_job_cached(struct job_record *job_ptr, uint16_t show_flags,
+			     uint32_t skip_fields, Buf buffer,
+			     uint16_t protocol_version, uid_t uid)
+{
+	struct job_pack_cache *slot;
+	pthread_mutex_t *cache_mutex;
+	uint32_t offset, size;
+	time_t now;
+	int i;
+
+	if (!_job_pack_cache_enabled()) {
+		pack_job(job_ptr, show_flags, skip_fields, buffer,
+			 protocol_version, uid);
+		return;
+	}
+
+	now = time(NULL);
+	cache_mutex = &job_pack_cache_mutex[job_ptr->job_id %
+					    JOB_PACK_CACHE_LOCKS];
+	slurm_mutex_lock(cache_mutex);
+	for (i = 0; job_ptr->pack_cache && (i < JOB_PACK_CACHE_SLOTS); i++) {
+		slot = &job_ptr->pack_cache[i];
+		if (!slot->data || (slot->pack_time != now) ||
+		    (slot->protocol_version != protocol_version) ||
+		    (slot->show_flags != show_flags) ||
+		    (slot->skip_fields != skip_fields) ||
+		    (slot->dirty_gen != job_ptr->dirty_gen) ||
+		    (slot->epoch != job_pack_epoch))
+			continue;
+		if (remaining_buf(buffer) < slot->size)
+			grow_buf(buffer, slot->size + BUF_SIZE);
+		memcpy(get_buf_data(buffer) + get_buf_offset(buffer),
+		       slot->data, slot->size);
+		set_buf_offset(buffer, get_buf_offset(buffer) + slot->size);
+		slurm_mutex_unlock(cache_mutex);
+		return;
+	}
+	slurm_mutex_unlock(cache_mutex);
+
+	offset = get_buf_offset(buffer);
+	pack_job(job_ptr, show_flags, skip_fields, buffer, protocol_version,
+		 uid);
+	size = get_buf_offset(buffer) - offset;
+
+	slurm_mutex_lock(cache_mutex);
+	if (!job_ptr->pack_cache) {
+		job_ptr->pack_cache = xcalloc(JOB_PACK_CACHE_SLOTS,
+					      sizeof(struct job_pack_cache));
+	}
+	/* Replace the entry for these flags if any, else the oldest entry */
+	slot = &job_ptr->pack_cache[0];
+	for (i = 0; i < JOB_PACK_CACHE_SLOTS; i++) {
+		if ((job_ptr->pack_cache[i].protocol_version ==
+		     protocol_version) &&
+		    (job_ptr->pack_cache[i].show_flags == show_flags) &&
+		    (job_ptr->pack_cache[i].skip_fields == skip_fields)) {
+			slot = &job_ptr->pack_cache[i];
+			break;
+		}
+		if (job_ptr->pack_cache[i].pack_time < slot->pack_time)
+			slot = &job_ptr->pack_cache[i];
+	}
+	if (slot->alloc_size < size) {
+		xrealloc_nz(slot->data, size);
+		slot->alloc_size = size;
+	}
+	memcpy(slot->data, get_buf_data(buffer) + offset, size);
+	slot->size = size;
+	slot->protocol_version = protocol_version;
+	slot->show_flags = show_flags;
+	slot->skip_fields = skip_fields;
+	slot->dirty_gen = job_ptr->dirty_gen;
+	slot->epoch = job_pack_epoch;
+	slot->pack_time = now;
+	slurm_mutex_unlock(cache_mutex);
+}
+
 static void _pack_job_gres(struct job_record *dump_job_ptr, Buf buffer,
 			   uint16_t protocol_version)
 {
@@ -9602,14 +10341,16 @@ static void _pack_job_gres(struct job_record *dump_job_ptr, Buf buffer,
  *	machine independent form (for network transmission)
  * IN dump_job_ptr - pointer to job for which information is requested
  * IN show_flags - job filtering options
+ * IN skip_fields - JOB_FIELD_* groups to pack as NULL or zero
  * IN/OUT buffer - buffer in which data is placed, pointers automatically
  *	updated
  * IN uid - user requesting the data
  * NOTE: change _unpack_job_info_members() in common/slurm_protocol_pack.c
  *	  whenever the data format changes
  */
-void pack_job(struct job_record *dump_job_ptr, uint16_t show_flags, Buf buffer,
-	      uint16_t protocol_version, uid_t uid)
+void pack_job(struct job_record *dump_job_ptr, uint16_t show_flags,
+	      uint32_t skip_fields, Buf buffer, uint16_t protocol_version,
+	      uid_t uid)
 {
 	struct job_details *detail_ptr;
 	time_t accrue_time = 0, begin_time = 0, start_time = 0, end_time = 0;
@@ -9739,15 +10480,24 @@ void pack_job(struct job_record *dump_job_ptr, uint16_t show_flags, Buf buffer,
 		else
 			packstr(dump_job_ptr->partition, buffer);
 		packstr(dump_job_ptr->account, buffer);
-		packstr(dump_job_ptr->admin_comment, buffer);
+		if (skip_fields & JOB_FIELD_COMMENT)
+			packnull(buffer);
+		else
+			packstr(dump_job_ptr->admin_comment, buffer);
 		pack32(dump_job_ptr->site_factor, buffer);
 		packstr(dump_job_ptr->network, buffer);
-		packstr(dump_job_ptr->comment, buffer);
+		if (skip_fields & JOB_FIELD_COMMENT)
+			packnull(buffer);
+		else
+			packstr(dump_job_ptr->comment, buffer);
 		packstr(dump_job_ptr->batch_features, buffer);
 		packstr(dump_job_ptr->batch_host, buffer);
 		packstr(dump_job_ptr->burst_buffer, buffer);
 		packstr(dump_job_ptr->burst_buffer_state, buffer);
-		packstr(dump_job_ptr->system_comment, buffer);
+		if (skip_fields & JOB_FIELD_COMMENT)
+			packnull(buffer);
+		else
+			packstr(dump_job_ptr->system_comment, buffer);
 
 		assoc_mgr_lock(&locks);
 		if (dump_job_ptr->qos_ptr)
@@ -9796,7 +10546,9 @@ void pack_job(struct job_record *dump_job_ptr, uint16_t show_flags, Buf buffer,
 		pack32(dump_job_ptr->wait4switch, buffer);
 
 		packstr(dump_job_ptr->alloc_node, buffer);
-		if (!IS_JOB_COMPLETING(dump_job_ptr))
+		if (skip_fields & JOB_FIELD_NODE_INX)
+			pack32(NO_VAL, buffer);
+		else if (!IS_JOB_COMPLETING(dump_job_ptr))
 			pack_bit_str_hex(dump_job_ptr->node_bitmap, buffer);
 		else
 			pack_bit_str_hex(dump_job_ptr->node_bitmap_cg, buffer);
@@ -9805,20 +10557,25 @@ void pack_job(struct job_record *dump_job_ptr, uint16_t show_flags, Buf buffer,
 					     buffer, protocol_version);
 
 		/* A few details are always dumped here */
-		_pack_default_job_details(dump_job_ptr, buffer,
+		_pack_default_job_details(dump_job_ptr, skip_fields, buffer,
 					  protocol_version);
 
 		/* other job details are only dumped until the job starts
 		 * running (at which time they become meaningless) */
 		if (detail_ptr)
-			_pack_pending_job_details(detail_ptr, buffer,
-						  protocol_version);
+			_pack_pending_job_details(detail_ptr, skip_fields,
+						  buffer, protocol_version);
 		else
-			_pack_pending_job_details(NULL, buffer,
-						  protocol_version);
+			_pack_pending_job_details(NULL, skip_fields,
+						  buffer, protocol_version);
 		pack32(dump_job_ptr->bit_flags, buffer);
-		packstr(dump_job_ptr->tres_fmt_alloc_str, buffer);
-		packstr(dump_job_ptr->tres_fmt_req_str, buffer);
+		if (skip_fields & JOB_FIELD_TRES_FMT) {
+			packnull(buffer);
+			packnull(buffer);
+		} else {
+			packstr(dump_job_ptr->tres_fmt_alloc_str, buffer);
+			packstr(dump_job_ptr->tres_fmt_req_str, buffer);
+		}
 		pack16(dump_job_ptr->start_protocol_ver, buffer);
 
 		if (dump_job_ptr->fed_details) {
@@ -10014,17 +10771,17 @@ void pack_job(struct job_record *dump_job_ptr, uint16_t show_flags, Buf buffer,
 					     buffer, protocol_version);
 
 		/* A few details are always dumped here */
-		_pack_default_job_details(dump_job_ptr, buffer,
+		_pack_default_job_details(dump_job_ptr, skip_fields, buffer,
 					  protocol_version);
 
 		/* other job details are only dumped until the job starts
 		 * running (at which time they become meaningless) */
 		if (detail_ptr)
-			_pack_pending_job_details(detail_ptr, buffer,
-						  protocol_version);
+			_pack_pending_job_details(detail_ptr, skip_fields,
+						  buffer, protocol_version);
 		else
-			_pack_pending_job_details(NULL, buffer,
-						  protocol_version);
+			_pack_pending_job_details(NULL, skip_fields,
+						  buffer, protocol_version);
 		pack32(dump_job_ptr->bit_flags, buffer);
 		packstr(dump_job_ptr->tres_fmt_alloc_str, buffer);
 		packstr(dump_job_ptr->tres_fmt_req_str, buffer);
@@ -10091,7 +10848,8 @@ static void _find_node_config(int *cpu_cnt_ptr, int *core_cnt_ptr)
 
 /* pack default job details for "get_job_info" RPC */
 static void _pack_default_job_details(struct job_record *job_ptr,
-				      Buf buffer, uint16_t protocol_version)
+				      uint32_t skip_fields, Buf buffer,
+				      uint16_t protocol_version)
 {
 	int max_cpu_cnt = -1, max_core_cnt = -1;
 	int i;
@@ -10133,10 +10891,14 @@ static void _pack_default_job_details(struct job_record *job_ptr,
 		if (detail_ptr) {
 			packstr(detail_ptr->features,   buffer);
 			packstr(detail_ptr->cluster_features, buffer);
-			packstr(detail_ptr->work_dir,   buffer);
+			if (skip_fields & JOB_FIELD_COMMAND)
+				packnull(buffer);
+			else
+				packstr(detail_ptr->work_dir, buffer);
 			packstr(detail_ptr->dependency, buffer);
 
-			if (detail_ptr->argv) {
+			if (detail_ptr->argv &&
+			    !(skip_fields & JOB_FIELD_COMMAND)) {
 				char *cmd_line = NULL;
 				for (i = 0; detail_ptr->argv[i]; i++) {
 					if (i != 0)
@@ -10274,7 +11036,8 @@ static void _pack_default_job_details(struct job_record *job_ptr,
 
 /* pack pending job details for "get_job_info" RPC */
 static void _pack_pending_job_details(struct job_details *detail_ptr,
-				      Buf buffer, uint16_t protocol_version)
+				      uint32_t skip_fields, Buf buffer,
+				      uint16_t protocol_version)
 {
 	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		if (detail_ptr) {
@@ -10287,13 +11050,27 @@ static void _pack_pending_job_details(struct job_details *detail_ptr,
 			pack32(detail_ptr->pn_min_tmp_disk, buffer);
 
 			packstr(detail_ptr->req_nodes, buffer);
-			pack_bit_str_hex(detail_ptr->req_node_bitmap, buffer);
+			if (skip_fields & JOB_FIELD_NODE_INX)
+				pack32(NO_VAL, buffer);
+			else
+				pack_bit_str_hex(detail_ptr->req_node_bitmap,
+						 buffer);
 			packstr(detail_ptr->exc_nodes, buffer);
-			pack_bit_str_hex(detail_ptr->exc_node_bitmap, buffer);
+			if (skip_fields & JOB_FIELD_NODE_INX)
+				pack32(NO_VAL, buffer);
+			else
+				pack_bit_str_hex(detail_ptr->exc_node_bitmap,
+						 buffer);
 
-			packstr(detail_ptr->std_err, buffer);
-			packstr(detail_ptr->std_in, buffer);
-			packstr(detail_ptr->std_out, buffer);
+			if (skip_fields & JOB_FIELD_STD_IO) {
+				packnull(buffer);
+				packnull(buffer);
+				packnull(buffer);
+			} else {
+				packstr(detail_ptr->std_err, buffer);
+				packstr(detail_ptr->std_in, buffer);
+				packstr(detail_ptr->std_out, buffer);
+			}
 
 			pack_multi_core_data(detail_ptr->mc_ptr, buffer,
 					     protocol_version);
@@ -10643,6 +11420,8 @@ void reset_job_bitmaps(void)
 	list_iterator_destroy(job_iterator);
 
 	last_job_update = now;
+	job_mark_dirty(NULL);
+	depend_mark_dirty(NULL);
 }
 
 static int _reset_detail_bitmaps(struct job_record *job_ptr)
@@ -11209,6 +11988,7 @@ static int _update_job(struct job_record *job_ptr, job_desc_msg_t * job_specs,
 		    (job_specs->burst_buffer[0] == '\0')) {
 			xfree(job_ptr->burst_buffer);
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 		} else {
 			error_code = ESLURM_NOT_SUPPORTED;
 		}
@@ -11309,6 +12089,7 @@ static int _update_job(struct job_record *job_ptr, job_desc_msg_t * job_specs,
 	if (detail_ptr)
 		mc_ptr = detail_ptr->mc_ptr;
 	last_job_update = now;
+	job_mark_dirty(job_ptr);
 
 	/*
 	 * Check to see if the new requested job_specs exceeds any
@@ -12723,6 +13504,8 @@ static int _update_job(struct job_record *job_ptr, job_desc_msg_t * job_specs,
 			sched_debug("%s: new name identical to old name %pJ",
 				    __func__, job_ptr);
 		} else {
+			/* Release singleton dependents of the old name */
+			job_mark_dirty(job_ptr);
 			xfree(job_ptr->name);
 			job_ptr->name = xstrdup(job_specs->name);
 
@@ -13763,9 +14546,12 @@ static char *_build_step_id(char *buf, int buf_len, uint32_t step_id)
  *	are actually running, if not clean up the job records and/or node
  *	records.
  * IN reg_msg - node registration message
+ * IN/OUT purge_node_bitmap - if set, record the node here for a later
+ *	purge_missing_jobs() call rather than purging its missing jobs now
  */
 extern void
-validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg)
+validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg,
+		      bitstr_t *purge_node_bitmap)
 {
 	int i, node_inx, jobs_on_node;
 	struct node_record *node_ptr;
@@ -13906,8 +14692,14 @@ validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg)
 	}
 
 	jobs_on_node = node_ptr->run_job_cnt + node_ptr->comp_job_cnt;
-	if (jobs_on_node)
-		_purge_missing_jobs(node_inx, now);
+	if (jobs_on_node && purge_node_bitmap) {
+		bit_set(purge_node_bitmap, node_inx);
+	} else if (jobs_on_node) {
+		bitstr_t *node_bitmap = bit_alloc(node_record_count);
+		bit_set(node_bitmap, node_inx);
+		purge_missing_jobs(node_bitmap);
+		bit_free(node_bitmap);
+	}
 
 	if (jobs_on_node != reg_msg->job_count) {
 		/* slurmd will not know of a job unless the job has
@@ -13922,29 +14714,30 @@ validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg)
 	return;
 }
 
-/* Purge any batch job that should have its script running on node
- * node_inx, but is not. Allow BatchStartTimeout + ResumeTimeout seconds
- * for startup.
+/*
+ * purge_missing_jobs - for each node in node_bitmap, purge any batch job
+ *	that should have its script running on the node, but is not. Allow
+ *	BatchStartTimeout + ResumeTimeout seconds for startup.
  *
- * Purge all job steps that were started before the node was last booted.
+ *	Purge all job steps that were started before the node was last booted.
  *
- * Also notify srun if any job steps should be active on this node
- * but are not found. */
-static void _purge_missing_jobs(int node_inx, time_t now)
+ *	Also notify srun if any job steps should be active on the node but are
+ *	not found. The job list is scanned once for all of the nodes.
+ * IN node_bitmap - nodes that just registered
+ */
+extern void purge_missing_jobs(bitstr_t *node_bitmap)
 {
 	ListIterator job_iterator;
 	struct job_record *job_ptr;
-	struct node_record *node_ptr = node_record_table_ptr + node_inx;
+	struct node_record *node_ptr;
 	uint16_t batch_start_timeout	= slurm_get_batch_start_timeout();
 	uint16_t msg_timeout		= slurm_get_msg_timeout();
 	uint16_t resume_timeout		= slurm_get_resume_timeout();
 	uint32_t suspend_time		= slurm_get_suspend_time();
-	time_t batch_startup_time, node_boot_time = (time_t) 0, startup_time;
+	time_t now = time(NULL);
+	time_t batch_startup_time, node_boot_time, startup_time;
+	int i, i_first, i_last;
 
-	if (node_ptr->boot_time > (msg_timeout + 5)) {
-		/* allow for message timeout and other delays */
-		node_boot_time = node_ptr->boot_time - (msg_timeout + 5);
-	}
 	batch_startup_time  = now - batch_start_timeout;
 	batch_startup_time -= MIN(DEFAULT_MSG_TIMEOUT, msg_timeout);
 
@@ -13952,35 +14745,53 @@ static void _purge_missing_jobs(int node_inx, time_t now)
 	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
 		if ((IS_JOB_CONFIGURING(job_ptr) ||
 		    (!IS_JOB_RUNNING(job_ptr) && !IS_JOB_SUSPENDED(job_ptr))) ||
-		    (!bit_test(job_ptr->node_bitmap, node_inx)))
+		    !bit_overlap_any(job_ptr->node_bitmap, node_bitmap))
 			continue;
-		if ((job_ptr->batch_flag != 0)			&&
-		    (suspend_time != 0) /* power mgmt on */	&&
-		    (job_ptr->start_time < node_boot_time)) {
-			startup_time = batch_startup_time - resume_timeout;
-		} else
-			startup_time = batch_startup_time;
-
-		if ((job_ptr->batch_flag != 0)			&&
-		    (job_ptr->pack_job_offset == 0)		&&
-		    (job_ptr->time_last_active < startup_time)	&&
-		    (job_ptr->start_time       < startup_time)	&&
-		    (node_ptr == find_node_record(job_ptr->batch_host))) {
-			bool requeue = false;
-			char *requeue_msg = "";
-			if (job_ptr->details && job_ptr->details->requeue) {
-				requeue = true;
-				requeue_msg = ", Requeuing job";
+		i_first = bit_ffs(job_ptr->node_bitmap);
+		i_last  = bit_fls(job_ptr->node_bitmap);
+		for (i = i_first; i <= i_last; i++) {
+			if (!bit_test(node_bitmap, i) ||
+			    !bit_test(job_ptr->node_bitmap, i))
+				continue;
+			node_ptr = node_record_table_ptr + i;
+			node_boot_time = (time_t) 0;
+			if (node_ptr->boot_time > (msg_timeout + 5)) {
+				/* allow for message timeout and other delays */
+				node_boot_time = node_ptr->boot_time -
+						 (msg_timeout + 5);
+			}
+			if ((job_ptr->batch_flag != 0)			&&
+			    (suspend_time != 0) /* power mgmt on */	&&
+			    (job_ptr->start_time < node_boot_time)) {
+				startup_time = batch_startup_time -
+					       resume_timeout;
+			} else
+				startup_time = batch_startup_time;
+
+			if ((job_ptr->batch_flag != 0)			&&
+			    (job_ptr->pack_job_offset == 0)		&&
+			    (job_ptr->time_last_active < startup_time)	&&
+			    (job_ptr->start_time       < startup_time)	&&
+			    (node_ptr == find_node_record(job_ptr->batch_host))) {
+				bool requeue = false;
+				char *requeue_msg = "";
+				if (job_ptr->details &&
+				    job_ptr->details->requeue) {
+					requeue = true;
+					requeue_msg = ", Requeuing job";
+				}
+				info("Batch %pJ missing from batch node %s (not found BatchStartTime after startup)%s",
+				     job_ptr, job_ptr->batch_host,
+				     requeue_msg);
+				job_ptr->exit_code = 1;
+				job_complete(job_ptr->job_id,
+					     slurmctld_conf.slurm_user_id,
+					     requeue, true, NO_VAL);
+				break;
+			} else {
+				_notify_srun_missing_step(job_ptr, i, now,
+							  node_boot_time);
 			}
-			info("Batch %pJ missing from batch node %s (not found BatchStartTime after startup)%s",
-			     job_ptr, job_ptr->batch_host, requeue_msg);
-			job_ptr->exit_code = 1;
-			job_complete(job_ptr->job_id,
-				     slurmctld_conf.slurm_user_id,
-				     requeue, true, NO_VAL);
-		} else {
-			_notify_srun_missing_step(job_ptr, node_inx,
-						  now, node_boot_time);
 		}
 	}
 	list_iterator_destroy(job_iterator);
@@ -14272,6 +15083,7 @@ extern int job_alloc_info_ptr(uint32_t uid, struct job_record *job_ptr)
 	    (prolog == 0) && job_ptr->node_bitmap &&
 	    (bit_overlap(power_node_bitmap, job_ptr->node_bitmap) == 0)) {
 		last_job_update = time(NULL);
+		job_mark_dirty(job_ptr);
 		set_job_alias_list(job_ptr);
 	}
 
@@ -14865,6 +15677,7 @@ extern void job_completion_logger(struct job_record *job_ptr, bool requeue)
 	}
 
 	_job_array_comp(job_ptr, was_running, requeue);
+	job_mark_dirty(job_ptr);
 
 	if (!IS_JOB_RESIZING(job_ptr) &&
 	    !IS_JOB_PENDING(job_ptr)  &&
@@ -15084,6 +15897,7 @@ extern int job_node_ready(uint32_t job_id, int *ready)
 	    job_ptr->node_bitmap &&
 	    (bit_overlap(power_node_bitmap, job_ptr->node_bitmap) == 0)) {
 		last_job_update = time(NULL);
+		job_mark_dirty(job_ptr);
 		set_job_alias_list(job_ptr);
 	}
 
@@ -15337,6 +16151,7 @@ static int _suspend_job_nodes(struct job_record *job_ptr, bool indf_susp)
 		}
 	}
 	last_job_update = last_node_update = now;
+	job_mark_dirty(job_ptr);
 	return rc;
 }
 
@@ -15391,6 +16206,7 @@ static int _resume_job_nodes(struct job_record *job_ptr, bool indf_susp)
 		node_ptr->node_state = NODE_STATE_ALLOCATED | node_flags;
 	}
 	last_job_update = last_node_update = time(NULL);
+	job_mark_dirty(job_ptr);
 	return rc;
 }
 
@@ -15876,6 +16692,7 @@ static int _job_requeue_op(uid_t uid, struct job_record *job_ptr, bool preempt,
 	}
 
 	last_job_update = now;
+	job_mark_dirty(job_ptr);
 
 	/*
 	 * In the job is in the process of completing
@@ -16427,6 +17244,7 @@ static int _set_top(List top_job_list, uid_t uid)
 	FREE_NULL_LIST(other_job_list);
 
 	last_job_update = time(NULL);
+	job_mark_dirty(NULL);
 
 	return rc;
 }
@@ -16705,6 +17523,7 @@ extern int update_job_wckey(char *module, struct job_record *job_ptr,
 	}
 
 	last_job_update = time(NULL);
+	job_mark_dirty(job_ptr);
 
 	return SLURM_SUCCESS;
 }
@@ -16827,6 +17646,7 @@ extern int job_checkpoint(checkpoint_msg_t *ckpt_ptr, uid_t uid,
 		info("checkpoint_op %u of JobId=%u.%u complete, rc=%d",
 		     ckpt_ptr->op, ckpt_ptr->job_id, ckpt_ptr->step_id, rc);
 		last_job_update = time(NULL);
+		job_mark_dirty(job_ptr);
 	} else {		/* operate on all of a job's steps */
 		int update_rc = -2;
 		ListIterator step_iterator;
@@ -16859,8 +17679,10 @@ extern int job_checkpoint(checkpoint_msg_t *ckpt_ptr, uid_t uid,
 			rc = MAX(rc, update_rc);
 			xfree(image_dir);
 		}
-		if (update_rc != -2)	/* some work done */
+		if (update_rc != -2) {	/* some work done */
 			last_job_update = time(NULL);
+			job_mark_dirty(job_ptr);
+		}
 		list_iterator_destroy (step_iterator);
 	}
 
@@ -17272,6 +18094,7 @@ extern int job_restart(checkpoint_msg_t *ckpt_ptr, uid_t uid, int conn_fd,
 		image_dir = NULL;	/* Nothing left to xfree */
 
 		last_job_update = time(NULL);
+		job_mark_dirty(job_ptr);
 	}
 
  unpack_error:
@@ -17669,6 +18492,7 @@ _kill_dependent(struct job_record *job_ptr)
 	job_ptr->end_time = now;
 	job_completion_logger(job_ptr, false);
 	last_job_update = now;
+	job_mark_dirty(job_ptr);
 	srun_allocate_abort(job_ptr);
 }
 
@@ -72,6 +72,7 @@
 #include "src/common/track_script.h"
 #include "src/common/uid.h"
 #include "src/common/xassert.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 
 #include "src/slurmctld/acct_policy.h"
@@ -101,6 +102,18 @@
 #define BUILD_TIMEOUT 2000000	/* Max build_job_queue() run time in usec */
 #define MAX_FAILED_RESV 10
 
+/*
+ * Reverse dependency index entry: the IDs of pending jobs whose cached
+ * dependency test result is invalidated by a change to the job (or job
+ * array) with ID job_id or, for singleton dependencies, to any job of the
+ * user and name in name_key.
+ */
+typedef struct depend_index {
+	List dependents;	/* uint32_t job IDs */
+	uint32_t job_id;
+	char *name_key;		/* "<user_id>:<name>" */
+} depend_index_t;
+
 typedef struct epilog_arg {
 	char *epilog_slurmctld;
 	uint32_t job_id;
@@ -150,6 +163,12 @@ static uint16_t bf_hetjob_prio = 0;
 static int sched_min_interval = 2;
 
 static int bb_array_stage_cnt = 10;
+
+static pthread_mutex_t depend_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t depend_epoch = 0;	/* bumped by depend_mark_dirty(NULL) */
+static uint32_t depend_index_epoch = 0;	/* depend_epoch of index contents */
+static xhash_t *depend_job_index = NULL;  /* keyed by dependee job ID */
+static xhash_t *depend_name_index = NULL; /* keyed by singleton user/name */
 extern diag_stats_t slurmctld_diag_stats;
 
 /*
@@ -313,6 +332,7 @@ static bool _job_runnable_test1(struct job_record *job_ptr, bool sched_plugin)
 		job_ptr->state_reason = WAIT_NO_REASON;
 		xfree(job_ptr->state_desc);
 		last_job_update = now;
+		job_mark_dirty(job_ptr);
 	}
 #endif
 
@@ -329,6 +349,7 @@ static bool _job_runnable_test1(struct job_record *job_ptr, bool sched_plugin)
 			job_ptr->state_reason = WAIT_HELD;
 			xfree(job_ptr->state_desc);
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 		}
 		sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u.",
 			     job_ptr,
@@ -538,6 +559,7 @@ extern List build_job_queue(bool clear_start, bool backfill)
 				job_ptr->state_reason_prev_db =
 					job_ptr->state_reason;
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 		} else if ((job_ptr->state_reason_prev == WAIT_TIME) &&
 			   job_ptr->details &&
 			   (job_ptr->details->begin_time <= now)) {
@@ -547,6 +569,7 @@ extern List build_job_queue(bool clear_start, bool backfill)
 				job_ptr->state_reason_prev_db =
 					job_ptr->state_reason;
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 		}
 		if (!_job_runnable_test1(job_ptr, clear_start))
 			continue;
@@ -564,6 +587,7 @@ extern List build_job_queue(bool clear_start, bool backfill)
 					job_ptr->state_reason = reason;
 					xfree(job_ptr->state_desc);
 					last_job_update = now;
+					job_mark_dirty(job_ptr);
 				}
 				/* priority_array index matches part_ptr_list
 				 * position: increment inx */
@@ -898,6 +922,7 @@ extern bool deadline_ok(struct job_record *job_ptr, char *func)
 	}
 	if (fail_job) {
 		last_job_update = now;
+		job_mark_dirty(job_ptr);
 		job_ptr->job_state = JOB_DEADLINE;
 		job_ptr->exit_code = 1;
 		job_ptr->state_reason = FAIL_DEADLINE;
@@ -1227,8 +1252,8 @@ static int _schedule(uint32_t job_limit)
 
 			part_iterator = list_iterator_create(part_list);
 			while ((part_ptr = list_next(part_iterator))) {
-				if (bit_overlap(eff_cg_bitmap,
-						part_ptr->node_bitmap)) {
+				if (bit_overlap_any(eff_cg_bitmap,
+						    part_ptr->node_bitmap)) {
 					failed_parts[failed_part_cnt++] =
 						part_ptr;
 					bit_and_not(avail_node_bitmap,
@@ -1302,6 +1327,7 @@ static int _schedule(uint32_t job_limit)
 				job_ptr->state_reason = WAIT_FRONT_END;
 				xfree(job_ptr->state_desc);
 				last_job_update = now;
+				job_mark_dirty(job_ptr);
 				continue;
 			}
 			if (!_job_runnable_test1(job_ptr, false))
@@ -1342,6 +1368,7 @@ next_part:			part_ptr = (struct part_record *)
 				job_ptr->state_reason = WAIT_FRONT_END;
 				xfree(job_ptr->state_desc);
 				last_job_update = now;
+				job_mark_dirty(job_ptr);
 				continue;
 			}
 			if ((job_ptr->array_task_id != array_task_id) &&
@@ -1468,6 +1495,7 @@ next_task:
 			job_ptr->state_reason = WAIT_PRIORITY;
 			xfree(job_ptr->state_desc);
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			sched_debug("%pJ. State=PENDING. Reason=Priority, Priority=%u. Partition=%s.",
 				    job_ptr, job_ptr->priority,
 				    job_ptr->partition);
@@ -1491,6 +1519,7 @@ next_task:
 				xfree(job_ptr->state_desc);
 				job_ptr->assoc_id = assoc_rec.id;
 				last_job_update = now;
+				job_mark_dirty(job_ptr);
 			} else {
 				sched_debug("%pJ has invalid association",
 					    job_ptr);
@@ -1517,12 +1546,14 @@ next_task:
 				xfree(job_ptr->state_desc);
 				job_ptr->state_reason = FAIL_QOS;
 				last_job_update = now;
+				job_mark_dirty(job_ptr);
 				assoc_mgr_unlock(&locks);
 				continue;
 			} else if (job_ptr->state_reason == FAIL_QOS) {
 				xfree(job_ptr->state_desc);
 				job_ptr->state_reason = WAIT_NO_REASON;
 				last_job_update = now;
+				job_mark_dirty(job_ptr);
 			}
 			assoc_mgr_unlock(&locks);
 		}
@@ -1580,6 +1611,7 @@ next_task:
 			xfree(job_ptr->state_desc);
 			job_ptr->state_desc = xstrdup("Nodes required for job are DOWN, DRAINED or reserved for jobs in higher priority partitions");
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u. Partition=%s.",
 				     job_ptr,
 				     job_state_string(job_ptr->job_state),
@@ -1592,6 +1624,7 @@ next_task:
 			job_ptr->state_reason = WAIT_LICENSES;
 			xfree(job_ptr->state_desc);
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u.",
 				     job_ptr,
 				     job_state_string(job_ptr->job_state),
@@ -1609,6 +1642,7 @@ next_task:
 			 * very rare. */
 			sched_info("%pJ has invalid account", job_ptr);
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			job_ptr->state_reason = FAIL_ACCOUNT;
 			xfree(job_ptr->state_desc);
 			continue;
@@ -1694,6 +1728,7 @@ skip_start:
 			job_ptr->state_reason = WAIT_FED_JOB_LOCK;
 			xfree(job_ptr->state_desc);
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			sched_debug3("%pJ. State=%s. Reason=%s. Priority=%u. Partition=%s.",
 				     job_ptr,
 				     job_state_string(job_ptr->job_state),
@@ -1704,6 +1739,7 @@ skip_start:
 			/* job initiated */
 			sched_debug3("%pJ initiated", job_ptr);
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			reject_array_job_id = 0;
 			reject_array_part   = NULL;
 
@@ -1752,6 +1788,7 @@ skip_start:
 			sched_info("schedule: %pJ non-runnable: %s",
 				   job_ptr, slurm_strerror(error_code));
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			job_ptr->job_state = JOB_PENDING;
 			job_ptr->state_reason = FAIL_BAD_CONSTRAINTS;
 			xfree(job_ptr->state_desc);
@@ -1869,13 +1906,101 @@ out:
 	return job_cnt;
 }
 
+/* Return the index following the ordered run of records starting at first */
+static int _job_queue_run_end(job_queue_rec_t **recs, int first, int cnt)
+{
+	int i;
+
+	for (i = first + 1; i < cnt; i++) {
+		if (sort_job_queue2(&recs[i - 1], &recs[i]) > 0)
+			break;
+	}
+	return i;
+}
+
+/*
+ * Merge adjacent ordered runs of records until a single run remains.
+ * Input already in the desired order costs one comparison per record.
+ */
+static void _job_queue_merge_runs(job_queue_rec_t **recs, int cnt)
+{
+	job_queue_rec_t **src = recs, **dest, **tmp;
+	int first, mid, last, i, j, k, runs;
+
+	dest = xcalloc(cnt, sizeof(job_queue_rec_t *));
+	tmp = dest;
+	do {
+		runs = 0;
+		for (first = 0; first < cnt; first = last) {
+			mid = _job_queue_run_end(src, first, cnt);
+			last = (mid < cnt) ? _job_queue_run_end(src, mid, cnt) :
+					     cnt;
+			i = first;
+			j = mid;
+			k = first;
+			while ((i < mid) && (j < last)) {
+				if (sort_job_queue2(&src[j], &src[i]) < 0)
+					dest[k++] = src[j++];
+				else
+					dest[k++] = src[i++];
+			}
+			while (i < mid)
+				dest[k++] = src[i++];
+			while (j < last)
+				dest[k++] = src[j++];
+			runs++;
+		}
+		dest = src;
+		src = (src == recs) ? tmp : recs;
+	} while (runs > 1);
+
+	if (src != recs)
+		memcpy(recs, src, cnt * sizeof(job_queue_rec_t *));
+	xfree(tmp);
+}
+
 /*
  * sort_job_queue - sort job_queue in descending priority order
  * IN/OUT job_queue - sorted job queue
+ *
+ * Jobs keep their rank from the previous sort in job_ptr->queue_rank. The
+ * records are first placed in that order (a counting sort on the rank) and
+ * then merged, so passes in which few job priorities changed cost little
+ * more than one comparison per record rather than a full sort.
  */
 extern void sort_job_queue(List job_queue)
 {
-	list_sort(job_queue, sort_job_queue2);
+	job_queue_rec_t **recs, **ranked, *job_queue_rec;
+	uint32_t *offset, rank;
+	int cnt, i;
+
+	if ((cnt = list_count(job_queue)) <= 1)
+		return;
+
+	recs = xcalloc(cnt, sizeof(job_queue_rec_t *));
+	ranked = xcalloc(cnt, sizeof(job_queue_rec_t *));
+	offset = xcalloc(cnt + 1, sizeof(uint32_t));
+	for (i = 0; (job_queue_rec = list_pop(job_queue)); i++) {
+		recs[i] = job_queue_rec;
+		rank = MIN(job_queue_rec->job_ptr->queue_rank, cnt - 1);
+		offset[rank + 1]++;
+	}
+	for (i = 1; i < cnt; i++)
+		offset[i] += offset[i - 1];
+	for (i = 0; i < cnt; i++) {
+		rank = MIN(recs[i]->job_ptr->queue_rank, cnt - 1);
+		ranked[offset[rank]++] = recs[i];
+	}
+	xfree(offset);
+	xfree(recs);
+
+	_job_queue_merge_runs(ranked, cnt);
+
+	for (i = 0; i < cnt; i++) {
+		ranked[i]->job_ptr->queue_rank = i;
+		list_append(job_queue, ranked[i]);
+	}
+	xfree(ranked);
 }
 
 /* Note this differs from the ListCmpF typedef since we want jobs sorted
@@ -2523,6 +2648,175 @@ static void _depend_list_del(void *dep_ptr)
 	xfree(dep_ptr);
 }
 
+static void _depend_index_job_key(void *item, const char **key,
+				  uint32_t *key_len)
+{
+	depend_index_t *index_ptr = (depend_index_t *) item;
+
+	*key = (char *) &index_ptr->job_id;
+	*key_len = sizeof(uint32_t);
+}
+
+static void _depend_index_name_key(void *item, const char **key,
+				   uint32_t *key_len)
+{
+	depend_index_t *index_ptr = (depend_index_t *) item;
+
+	*key = index_ptr->name_key;
+	*key_len = strlen(index_ptr->name_key);
+}
+
+static void _depend_index_free(void *item)
+{
+	depend_index_t *index_ptr = (depend_index_t *) item;
+
+	if (!index_ptr)
+		return;
+	FREE_NULL_LIST(index_ptr->dependents);
+	xfree(index_ptr->name_key);
+	xfree(index_ptr);
+}
+
+static int _find_dependent_id(void *x, void *key)
+{
+	uint32_t *job_id = (uint32_t *) x;
+	uint32_t *key_id = (uint32_t *) key;
+
+	if (*job_id == *key_id)
+		return 1;
+	return 0;
+}
+
+/* Record that job_id's dependency test must be repeated when the job or
+ * singleton name identified by key changes. Call with depend_mutex locked */
+static void _depend_index_add(xhash_t *index, depend_index_t *index_ptr,
+			      const char *key, uint32_t key_len,
+			      uint32_t job_id)
+{
+	depend_index_t *found_ptr;
+	uint32_t *dependent;
+
+	if ((found_ptr = xhash_get(index, key, key_len))) {
+		_depend_index_free(index_ptr);
+		index_ptr = found_ptr;
+	} else {
+		index_ptr->dependents = list_create(slurm_destroy_uint32_ptr);
+		xhash_add(index, index_ptr);
+	}
+
+	if (list_find_first(index_ptr->dependents, _find_dependent_id,
+			    &job_id))
+		return;
+	dependent = xmalloc(sizeof(uint32_t));
+	*dependent = job_id;
+	list_append(index_ptr->dependents, dependent);
+}
+
+/* Register a job's remaining dependencies in the reverse dependency index.
+ * Call with depend_mutex locked */
+static void _depend_index_job(struct job_record *job_ptr)
+{
+	struct depend_spec *dep_ptr;
+	depend_index_t *index_ptr;
+	ListIterator depend_iter;
+
+	if (!depend_job_index) {
+		depend_job_index = xhash_init(_depend_index_job_key,
+					      _depend_index_free);
+		depend_name_index = xhash_init(_depend_index_name_key,
+					       _depend_index_free);
+	}
+	if (depend_index_epoch != depend_epoch) {
+		/* Cached results from an older epoch are all invalid */
+		xhash_clear(depend_job_index);
+		xhash_clear(depend_name_index);
+		depend_index_epoch = depend_epoch;
+	}
+
+	depend_iter = list_iterator_create(job_ptr->details->depend_list);
+	while ((dep_ptr = list_next(depend_iter))) {
+		index_ptr = xmalloc(sizeof(depend_index_t));
+		if (dep_ptr->depend_type == SLURM_DEPEND_SINGLETON) {
+			index_ptr->name_key = xstrdup_printf("%u:%s",
+							     job_ptr->user_id,
+							     job_ptr->name);
+			_depend_index_add(depend_name_index, index_ptr,
+					  index_ptr->name_key,
+					  strlen(index_ptr->name_key),
+					  job_ptr->job_id);
+		} else {
+			index_ptr->job_id = dep_ptr->job_id;
+			_depend_index_add(depend_job_index, index_ptr,
+					  (char *) &dep_ptr->job_id,
+					  sizeof(uint32_t), job_ptr->job_id);
+		}
+	}
+	list_iterator_destroy(depend_iter);
+}
+
+/* Invalidate the cached dependency test of every job registered under the
+ * given key. Call with depend_mutex locked */
+static void _depend_index_notify(xhash_t *index, const char *key,
+				 uint32_t key_len)
+{
+	depend_index_t *index_ptr;
+	struct job_record *job_ptr;
+	ListIterator iter;
+	uint32_t *job_id;
+
+	if (!index || !(index_ptr = xhash_pop(index, key, key_len)))
+		return;
+
+	iter = list_iterator_create(index_ptr->dependents);
+	while ((job_id = list_next(iter))) {
+		job_ptr = find_job_record(*job_id);
+		if (job_ptr && job_ptr->details)
+			job_ptr->details->depend_time = 0;
+	}
+	list_iterator_destroy(iter);
+	_depend_index_free(index_ptr);
+}
+
+/*
+ * depend_mark_dirty - note a change to a job record, invalidating the cached
+ *	dependency test results of jobs which depend upon it
+ * IN job_ptr - job modified, NULL if any or all jobs may have changed
+ */
+extern void depend_mark_dirty(struct job_record *job_ptr)
+{
+	char *name_key;
+
+	slurm_mutex_lock(&depend_mutex);
+	if (!job_ptr) {
+		depend_epoch++;
+		slurm_mutex_unlock(&depend_mutex);
+		return;
+	}
+
+	if (job_ptr->details)
+		job_ptr->details->depend_time = 0;
+	if (depend_index_epoch == depend_epoch) {
+		_depend_index_notify(depend_job_index,
+				     (char *) &job_ptr->job_id,
+				     sizeof(uint32_t));
+		if (job_ptr->array_job_id &&
+		    (job_ptr->array_job_id != job_ptr->job_id)) {
+			_depend_index_notify(depend_job_index,
+					     (char *) &job_ptr->array_job_id,
+					     sizeof(uint32_t));
+		}
+		if (job_ptr->name && depend_name_index &&
+		    xhash_count(depend_name_index)) {
+			name_key = xstrdup_printf("%u:%s", job_ptr->user_id,
+						  job_ptr->name);
+			_depend_index_notify(depend_name_index, name_key,
+					     strlen(name_key));
+			xfree(name_key);
+		}
+	}
+	slurm_mutex_unlock(&depend_mutex);
+}
+
 /*
  * Copy a job's dependency list
  * IN depend_list_src - a job's depend_lst
@@ -2676,9 +2970,10 @@ extern int test_job_dependency(struct job_record *job_ptr)
 	bool failure = false, depends = false, rebuild_str = false;
 	bool or_satisfied = false;
 	List job_queue = NULL;
-	bool run_now;
+	bool run_now, cacheable = true;
 	int results = 0;
 	struct job_record *qjob_ptr, *djob_ptr, *dcjob_ptr;
+	time_t now = time(NULL);
 
 	if ((job_ptr->details == NULL) ||
 	    (job_ptr->details->depend_list == NULL) ||
@@ -2687,6 +2982,22 @@ extern int test_job_dependency(struct job_record *job_ptr)
 		return 0;
 	}
 
+	/*
+	 * Dependencies remain unsatisfied until a job they reference starts,
+	 * ends or is purged, at which point depend_mark_dirty() clears
+	 * depend_time.
+	 */
+	slurm_mutex_lock(&depend_mutex);
+	if (job_ptr->details->depend_time &&
+	    (job_ptr->details->depend_epoch == depend_epoch))
+		results = 1;
+	slurm_mutex_unlock(&depend_mutex);
+	if (results) {
+		job_ptr->bit_flags |= JOB_DEPENDENT;
+		acct_policy_remove_accrue_time(job_ptr, false);
+		return results;
+	}
+
 	depend_iter = list_iterator_create(job_ptr->details->depend_list);
 	while ((dep_ptr = list_next(depend_iter))) {
 		bool clear_dep = false;
@@ -2828,7 +3139,7 @@ extern int test_job_dependency(struct job_record *job_ptr)
 			else
 				failure = true;
 		} else if (dep_ptr->depend_type == SLURM_DEPEND_EXPAND) {
-			time_t now = time(NULL);
+			cacheable = false;
 			if (IS_JOB_PENDING(djob_ptr)) {
 				depends = true;
 			} else if (IS_JOB_COMPLETED(djob_ptr))
@@ -2845,6 +3156,7 @@ extern int test_job_dependency(struct job_record *job_ptr)
 					djob_ptr->details->whole_node;
 			}
 		} else if (dep_ptr->depend_type == SLURM_DEPEND_BURST_BUFFER) {
+			cacheable = false;	/* stage-out state not tracked */
 			if (IS_JOB_COMPLETED(djob_ptr) &&
 			    (bb_g_job_test_stage_out(djob_ptr) == 1)) {
 				clear_dep = true;
@@ -2894,6 +3206,14 @@ extern int test_job_dependency(struct job_record *job_ptr)
 		job_ptr->bit_flags &= ~JOB_DEPENDENT;
 	}
 
+	if ((results == 1) && cacheable) {
+		slurm_mutex_lock(&depend_mutex);
+		_depend_index_job(job_ptr);
+		job_ptr->details->depend_epoch = depend_epoch;
+		job_ptr->details->depend_time = now;
+		slurm_mutex_unlock(&depend_mutex);
+	}
+
 	return results;
 }
 
@@ -3005,6 +3325,7 @@ extern int update_job_dependency(struct job_record *job_ptr, char *new_depend)
 
 	if (job_ptr->details == NULL)
 		return EINVAL;
+	job_ptr->details->depend_time = 0;
 
 	if (select_hetero == -1) {
 		/*
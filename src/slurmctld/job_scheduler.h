@@ -82,6 +82,13 @@ extern batch_job_launch_msg_t *build_launch_job_msg(
  */
 extern bool deadline_ok(struct job_record *job_ptr, char *func);
 
+/*
+ * depend_mark_dirty - note a change to a job record, invalidating the cached
+ *	dependency test results of jobs which depend upon it
+ * IN job_ptr - job modified, NULL if any or all jobs may have changed
+ */
+extern void depend_mark_dirty(struct job_record *job_ptr);
+
 /*
  * epilog_slurmctld - execute the prolog_slurmctld for a job that has just
  *	terminated.
@@ -40,6 +40,7 @@
 #include <errno.h>
 #include <pthread.h>
 #include <string.h>
+#include <sys/time.h>
 #include <sys/types.h>
 
 #include "src/slurmctld/locks.h"
@@ -49,6 +50,25 @@ static pthread_mutex_t state_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static pthread_rwlock_t slurmctld_locks[ENTITY_COUNT];
 
+#define LOCK_HOLD_MAX 4	/* nested lock sets timed per thread */
+
+/* Lock set held by a thread, used to record hold time on release */
+typedef struct {
+	lock_stat_t *stat;
+	struct timeval start;
+} lock_hold_t;
+
+/* All lock sets held by a thread, innermost last */
+typedef struct {
+	int depth;		/* lock sets held, may exceed LOCK_HOLD_MAX */
+	lock_hold_t hold[LOCK_HOLD_MAX];
+} lock_hold_stack_t;
+
+static pthread_key_t lock_hold_key;
+static pthread_once_t lock_hold_once = PTHREAD_ONCE_INIT;
+static lock_stat_t *lock_stat_head = NULL;
+static pthread_mutex_t lock_stat_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 #ifndef NDEBUG
 /*
  * Used to protect against double-locking within a single thread. Calling
@@ -102,12 +122,97 @@ extern bool verify_lock(lock_datatype_t datatype, lock_level_t level)
 }
 #endif
 
-/* lock_slurmctld - Issue the required lock requests in a well defined order */
-extern void lock_slurmctld(slurmctld_lock_t lock_levels)
+static void _lock_hold_free(void *arg)
+{
+	xfree(arg);
+}
+
+static void _lock_hold_key_init(void)
+{
+	if (pthread_key_create(&lock_hold_key, _lock_hold_free))
+		fatal("%s: pthread_key_create: %m", __func__);
+}
+
+/*
+ * Find or create the statistics record for a call site and lock levels.
+ * *stat_ptr is read by other threads without lock_stat_mutex, so a new record
+ * is published with a release store only once it is fully initialized.
+ */
+static lock_stat_t *_lock_stat_find(slurmctld_lock_t lock_levels,
+				    lock_stat_t **stat_ptr,
+				    const char *func, int line)
+{
+	lock_stat_t *stat;
+
+	slurm_mutex_lock(&lock_stat_mutex);
+	for (stat = __atomic_load_n(stat_ptr, __ATOMIC_RELAXED); stat;
+	     stat = stat->site_next) {
+		if (!memcmp(&stat->lock_levels, &lock_levels,
+			    sizeof(slurmctld_lock_t)))
+			break;
+	}
+	if (!stat) {
+		stat = xmalloc(sizeof(lock_stat_t));
+		stat->func = func;
+		stat->line = line;
+		memcpy(&stat->lock_levels, &lock_levels,
+		       sizeof(slurmctld_lock_t));
+		slurm_mutex_init(&stat->mutex);
+		stat->site_next = __atomic_load_n(stat_ptr, __ATOMIC_RELAXED);
+		stat->next = lock_stat_head;
+		lock_stat_head = stat;
+		__atomic_store_n(stat_ptr, stat, __ATOMIC_RELEASE);
+	}
+	slurm_mutex_unlock(&lock_stat_mutex);
+
+	return stat;
+}
+
+static int _lock_stat_bucket(uint32_t usec)
+{
+	uint32_t limit = 10;
+	int i;
+
+	for (i = 0; i < (LOCK_STAT_BUCKETS - 1); i++, limit *= 10) {
+		if (usec < limit)
+			break;
+	}
+	return i;
+}
+
+static uint32_t _lock_stat_delta(struct timeval *start, struct timeval *end)
+{
+	return ((end->tv_sec - start->tv_sec) * 1000000) +
+	       end->tv_usec - start->tv_usec;
+}
+
+/*
+ * lock_slurmctld_site - Issue the required lock requests in a well defined
+ *	order, use the lock_slurmctld() macro rather than calling this directly
+ */
+extern void lock_slurmctld_site(slurmctld_lock_t lock_levels,
+				lock_stat_t **stat_ptr,
+				const char *func, int line)
 {
 	static bool init_run = false;
+	lock_stat_t *stat = __atomic_load_n(stat_ptr, __ATOMIC_ACQUIRE);
+	lock_hold_stack_t *holds;
+	lock_hold_t *hold;
+	struct timeval start, now;
+	uint32_t wait;
 	xassert(_store_locks(lock_levels));
 
+	if (!stat || memcmp(&stat->lock_levels, &lock_levels,
+			    sizeof(slurmctld_lock_t)))
+		stat = _lock_stat_find(lock_levels, stat_ptr, func, line);
+
+	pthread_once(&lock_hold_once, _lock_hold_key_init);
+	if (!(holds = pthread_getspecific(lock_hold_key))) {
+		holds = xmalloc(sizeof(lock_hold_stack_t));
+		pthread_setspecific(lock_hold_key, holds);
+	}
+	gettimeofday(&start, NULL);
+
 	if (!init_run) {
 		init_run = true;
 		for (int i = 0; i < ENTITY_COUNT; i++)
@@ -138,14 +243,63 @@ extern void lock_slurmctld(slurmctld_lock_t lock_levels)
 		slurm_rwlock_rdlock(&slurmctld_locks[FED_LOCK]);
 	else if (lock_levels.fed == WRITE_LOCK)
 		slurm_rwlock_wrlock(&slurmctld_locks[FED_LOCK]);
+
+	gettimeofday(&now, NULL);
+	wait = _lock_stat_delta(&start, &now);
+	if (holds->depth < LOCK_HOLD_MAX) {
+		hold = &holds->hold[holds->depth];
+		hold->stat = stat;
+		hold->start = now;
+	}
+	holds->depth++;
+	slurm_mutex_lock(&stat->mutex);
+	stat->cnt++;
+	stat->wait_time += wait;
+	stat->wait_max = MAX(stat->wait_max, wait);
+	stat->wait_hist[_lock_stat_bucket(wait)]++;
+	slurm_mutex_unlock(&stat->mutex);
 }
 
 /* unlock_slurmctld - Issue the required unlock requests in a well
  *	defined order */
 extern void unlock_slurmctld(slurmctld_lock_t lock_levels)
 {
+	lock_hold_stack_t *holds;
+	lock_stat_t *stat = NULL;
+	struct timeval now;
+	uint32_t held = 0;
+	int i;
 	xassert(_clear_locks(lock_levels));
 
+	pthread_once(&lock_hold_once, _lock_hold_key_init);
+	holds = pthread_getspecific(lock_hold_key);
+	if (holds && (holds->depth > LOCK_HOLD_MAX)) {
+		/* Innermost lock sets beyond LOCK_HOLD_MAX are not timed */
+		holds->depth--;
+	} else if (holds && holds->depth) {
+		/* Usually the innermost, but they need not be released so */
+		for (i = holds->depth - 1; i >= 0; i--) {
+			if (!memcmp(&holds->hold[i].stat->lock_levels,
+				    &lock_levels, sizeof(slurmctld_lock_t)))
+				break;
+		}
+		if (i >= 0) {
+			gettimeofday(&now, NULL);
+			stat = holds->hold[i].stat;
+			held = _lock_stat_delta(&holds->hold[i].start, &now);
+			memmove(&holds->hold[i], &holds->hold[i + 1],
+				sizeof(lock_hold_t) * (holds->depth - i - 1));
+		}
+		holds->depth--;
+	}
+	if (stat) {
+		slurm_mutex_lock(&stat->mutex);
+		stat->hold_time += held;
+		stat->hold_max = MAX(stat->hold_max, held);
+		stat->hold_hist[_lock_stat_bucket(held)]++;
+		slurm_mutex_unlock(&stat->mutex);
+	}
+
 	if (lock_levels.fed)
 		slurm_rwlock_unlock(&slurmctld_locks[FED_LOCK]);
 
@@ -206,6 +360,39 @@ int report_locks_set(void)
 }
 
 
+/*
+ * lock_stats_list - Return the list of lock statistics records for all call
+ *	sites
+ */
+extern lock_stat_t *lock_stats_list(void)
+{
+	lock_stat_t *stat;
+
+	slurm_mutex_lock(&lock_stat_mutex);
+	stat = lock_stat_head;
+	slurm_mutex_unlock(&lock_stat_mutex);
+
+	return stat;
+}
+
+/* lock_stats_reset - Clear the counters of every lock statistics record */
+extern void lock_stats_reset(void)
+{
+	lock_stat_t *stat;
+
+	for (stat = lock_stats_list(); stat; stat = stat->next) {
+		slurm_mutex_lock(&stat->mutex);
+		stat->cnt = 0;
+		stat->wait_time = 0;
+		stat->wait_max = 0;
+		memset(stat->wait_hist, 0, sizeof(stat->wait_hist));
+		stat->hold_time = 0;
+		stat->hold_max = 0;
+		memset(stat->hold_hist, 0, sizeof(stat->hold_hist));
+		slurm_mutex_unlock(&stat->mutex);
+	}
+}
+
 /* un/lock semaphore used for saving state of slurmctld */
 extern void lock_state_files(void)
 {
@@ -91,7 +91,9 @@
 #ifndef _SLURMCTLD_LOCKS_H
 #define _SLURMCTLD_LOCKS_H
 
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* levels of locking required for each data structure */
 typedef enum {
@@ -118,6 +120,27 @@ typedef enum {
 	ENTITY_COUNT
 }	lock_datatype_t;
 
+/* Lock wait and hold time histogram buckets: <10 usec, <100 usec, ... <1 sec
+ * and >= 1 sec */
+#define LOCK_STAT_BUCKETS 7
+
+/* Lock statistics for one lock_slurmctld() call site and set of lock levels */
+typedef struct lock_stat {
+	struct lock_stat *next;		/* next record in list of all sites */
+	struct lock_stat *site_next;	/* same call site, other lock levels */
+	const char *func;		/* function calling lock_slurmctld() */
+	int line;			/* line of the lock_slurmctld() call */
+	slurmctld_lock_t lock_levels;
+	pthread_mutex_t mutex;		/* protects the counters below */
+	uint32_t cnt;			/* count of lock acquisitions */
+	uint64_t wait_time;		/* usec waiting to acquire the locks */
+	uint32_t wait_max;
+	uint32_t wait_hist[LOCK_STAT_BUCKETS];
+	uint64_t hold_time;		/* usec the locks were held */
+	uint32_t hold_max;
+	uint32_t hold_hist[LOCK_STAT_BUCKETS];
+}	lock_stat_t;
+
 #ifndef NDEBUG
 extern bool verify_lock(lock_datatype_t datatype, lock_level_t level);
 #endif
@@ -126,8 +149,28 @@ extern bool verify_lock(lock_datatype_t datatype, lock_level_t level);
  *	control */
 extern void init_locks ( void );
 
-/* lock_slurmctld - Issue the required lock requests in a well defined order */
-extern void lock_slurmctld (slurmctld_lock_t lock_levels);
+/*
+ * lock_slurmctld - Issue the required lock requests in a well defined order.
+ *	Wait and hold times are recorded against the calling function and line.
+ */
+#define lock_slurmctld(lock_levels)					\
+	do {								\
+		static lock_stat_t *_lock_stat = NULL;			\
+		lock_slurmctld_site(lock_levels, &_lock_stat,		\
+				    __func__, __LINE__);		\
+	} while (0)
+
+/*
+ * lock_slurmctld_site - Issue the required lock requests in a well defined
+ *	order, use the lock_slurmctld() macro rather than calling this directly
+ * IN lock_levels - locks to acquire
+ * IN/OUT stat_ptr - statistics record for the call site, set on first use
+ *	and accessed with atomic loads and stores as it is shared by threads
+ * IN func, line - call site
+ */
+extern void lock_slurmctld_site(slurmctld_lock_t lock_levels,
+				lock_stat_t **stat_ptr,
+				const char *func, int line);
 
 /* unlock_slurmctld - Issue the required unlock requests in a well
  *	defined order */
@@ -135,6 +178,17 @@ extern void unlock_slurmctld (slurmctld_lock_t lock_levels);
 
 extern int report_locks_set(void);
 
+/*
+ * lock_stats_list - Return the list of lock statistics records for all call
+ *	sites. Records are never freed and new ones are only added at the head,
+ *	so the list may be walked without locks. Use each record's mutex to read
+ *	its counters.
+ */
+extern lock_stat_t *lock_stats_list(void);
+
+/* lock_stats_reset - Clear the counters of every lock statistics record */
+extern void lock_stats_reset(void);
+
 /* un/lock semaphore used for saving state of slurmctld */
 extern void lock_state_files ( void );
 extern void unlock_state_files ( void );
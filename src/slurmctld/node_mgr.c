@@ -1677,7 +1677,7 @@ static int _update_node_weight(char *node_names, uint32_t weight)
 	ListIterator config_iterator;
 	struct config_record *config_ptr, *new_config_ptr;
 	struct config_record *first_new = NULL;
-	int rc, config_cnt, tmp_cnt;
+	int i, i_first, i_last, rc, config_cnt, tmp_cnt;
 
 	rc = node_name2bitmap(node_names, false, &node_bitmap);
 	if (rc) {
@@ -1723,6 +1723,17 @@ static int _update_node_weight(char *node_names, uint32_t weight)
 		FREE_NULL_BITMAP(tmp_bitmap);
 	}
 	list_iterator_destroy(config_iterator);
+
+	/* Let the select plugin reorder these nodes by weight */
+	i_first = bit_ffs(node_bitmap);
+	if (i_first >= 0)
+		i_last = bit_fls(node_bitmap);
+	else
+		i_last = -2;
+	for (i = i_first; i <= i_last; i++) {
+		if (bit_test(node_bitmap, i))
+			select_g_update_node_config(i);
+	}
 	FREE_NULL_BITMAP(node_bitmap);
 
 	info("_update_node_weight: nodes %s weight set to: %u",
@@ -3772,6 +3783,7 @@ void make_node_idle(struct node_record *node_ptr,
 	if (node_bitmap && (bit_test(node_bitmap, inx))) {
 		/* Not a replay */
 		last_job_update = now;
+		job_mark_dirty(job_ptr);
 		bit_clear(node_bitmap, inx);
 
 		if (!IS_JOB_FINISHED(job_ptr))
@@ -646,6 +646,8 @@ extern void deallocate_nodes(struct job_record *job_ptr, bool timeout,
  * For every element in the feature_list, identify the nodes with that feature
  * either active or available and set the feature_list's node_bitmap_active and
  * node_bitmap_avail fields accordingly.
+ * The bitmaps are kept until active_feature_list or avail_feature_list change
+ * (see node_features_gen), so repeated calls for the same job are cheap.
  */
 extern void find_feature_nodes(List feature_list, bool can_reboot)
 {
@@ -657,6 +659,14 @@ extern void find_feature_nodes(List feature_list, bool can_reboot)
 		return;
 	feat_iter = list_iterator_create(feature_list);
 	while ((job_feat_ptr = (job_feature_t *) list_next(feat_iter))) {
+		if (job_feat_ptr->node_bitmap_active &&
+		    job_feat_ptr->node_bitmap_avail &&
+		    (job_feat_ptr->node_features_gen == node_features_gen) &&
+		    ((job_feat_ptr->bitmap_can_reboot == can_reboot) ||
+		     !job_feat_ptr->changeable))
+			continue;
+		job_feat_ptr->node_features_gen = node_features_gen;
+		job_feat_ptr->bitmap_can_reboot = can_reboot;
 		FREE_NULL_BITMAP(job_feat_ptr->node_bitmap_active);
 		FREE_NULL_BITMAP(job_feat_ptr->node_bitmap_avail);
 		node_feat_ptr = list_find_first(active_feature_list,
@@ -1358,8 +1368,8 @@ _get_req_features(struct node_set *node_set_ptr, int node_set_size,
 			 * purge it
 			 */
 			for (i = 0; i < node_set_size; i++) {
-				if (!bit_overlap(node_set_ptr[i].my_bitmap,
-						 work_bitmap))
+				if (!bit_overlap_any(node_set_ptr[i].my_bitmap,
+						     work_bitmap))
 					continue;
 				tmp_node_set_ptr[tmp_node_set_size].
 					cpus_per_node =
@@ -1397,15 +1407,16 @@ _get_req_features(struct node_set *node_set_ptr, int node_set_size,
 				    (prev_node_set_ptr->flags &
 				     NODE_SET_REBOOT))
 					continue;
+				if (bit_and_not_ffs(node_set_ptr[i].my_bitmap,
+						    feat_ptr->node_bitmap_active)
+				    == -1) {
+					/* No inactive nodes (require reboot) */
+					continue;
+				}
 				inactive_bitmap =
 					bit_copy(node_set_ptr[i].my_bitmap);
 				bit_and_not(inactive_bitmap,
 					    feat_ptr->node_bitmap_active);
-				if (bit_ffs(inactive_bitmap) == -1) {
-					/* No inactive nodes (require reboot) */
-					FREE_NULL_BITMAP(inactive_bitmap);
-					continue;
-				}
 				sort_again = true;
 				if (bit_equal(prev_node_set_ptr->my_bitmap,
 					      inactive_bitmap)) {
@@ -2737,6 +2748,7 @@ extern int select_nodes(struct job_record *job_ptr, bool test_only,
 			return ESLURM_BURST_BUFFER_WAIT; /* Fatal BB event */
 		xfree(job_ptr->state_desc);
 		last_job_update = now;
+		job_mark_dirty(job_ptr);
 		if (bb == 0)
 			job_ptr->state_reason = WAIT_BURST_BUFFER_STAGING;
 		else
@@ -2889,6 +2901,7 @@ extern int select_nodes(struct job_record *job_ptr, bool test_only,
 			job_ptr->state_reason = WAIT_PART_NODE_LIMIT;
 			xfree(job_ptr->state_desc);
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 
 		/* Non-fatal errors for job below */
 		} else if (error_code == ESLURM_NODE_NOT_AVAIL) {
@@ -2926,6 +2939,7 @@ extern int select_nodes(struct job_record *job_ptr, bool test_only,
 			}
 			xfree(unavail_node);
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 		} else if (error_code == ESLURM_RESERVATION_MAINT) {
 			error_code = ESLURM_RESERVATION_BUSY;	/* All reserved */
 			job_ptr->state_reason = WAIT_NODE_NOT_AVAIL;
@@ -3007,6 +3021,7 @@ extern int select_nodes(struct job_record *job_ptr, bool test_only,
 		job_ptr->priority = 0;
 		job_ptr->state_reason = WAIT_HELD;
 		last_job_update = now;
+		job_mark_dirty(job_ptr);
 		goto cleanup;
 	}
 	if (select_g_job_begin(job_ptr) != SLURM_SUCCESS) {
@@ -3022,6 +3037,7 @@ extern int select_nodes(struct job_record *job_ptr, bool test_only,
 		job_ptr->end_time = 0;
 		job_ptr->state_reason = WAIT_RESOURCES;
 		last_job_update = now;
+		job_mark_dirty(job_ptr);
 		goto cleanup;
 	}
 
@@ -3045,6 +3061,7 @@ extern int select_nodes(struct job_record *job_ptr, bool test_only,
 		job_ptr->end_time = 0;
 		job_ptr->state_reason = WAIT_RESOURCES;
 		last_job_update = now;
+		job_mark_dirty(job_ptr);
 		goto cleanup;
 	}
 
@@ -3056,6 +3073,7 @@ extern int select_nodes(struct job_record *job_ptr, bool test_only,
 
 	job_ptr->job_state = JOB_RUNNING;
 	job_ptr->bit_flags |= JOB_WAS_RUNNING;
+	job_mark_dirty(job_ptr);
 
 	if (select_g_select_nodeinfo_set(job_ptr) != SLURM_SUCCESS) {
 		error("select_g_select_nodeinfo_set(%pJ): %m", job_ptr);
@@ -3073,6 +3091,7 @@ extern int select_nodes(struct job_record *job_ptr, bool test_only,
 			job_ptr->state_reason = WAIT_RESOURCES;
 			job_ptr->job_state = JOB_PENDING;
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			goto cleanup;
 		}
 	}
@@ -2212,6 +2212,7 @@ extern int part_policy_valid_acct(struct part_record *part_ptr, char *acct,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_ACCOUNT;
 				last_job_update = time(NULL);
+				job_mark_dirty(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -2236,6 +2237,7 @@ extern int part_policy_valid_acct(struct part_record *part_ptr, char *acct,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_ACCOUNT;
 				last_job_update = time(NULL);
+				job_mark_dirty(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -2267,6 +2269,7 @@ extern int part_policy_valid_acct(struct part_record *part_ptr, char *acct,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_ACCOUNT;
 				last_job_update = time(NULL);
+				job_mark_dirty(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -2303,6 +2306,7 @@ extern int part_policy_valid_qos(struct part_record *part_ptr,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_QOS;
 				last_job_update = time(NULL);
+				job_mark_dirty(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -2322,6 +2326,7 @@ extern int part_policy_valid_qos(struct part_record *part_ptr,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_QOS;
 				last_job_update = time(NULL);
+				job_mark_dirty(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -2348,6 +2353,7 @@ extern int part_policy_valid_qos(struct part_record *part_ptr,
 				job_ptr->state_desc = tmp_err;
 				job_ptr->state_reason = WAIT_QOS;
 				last_job_update = time(NULL);
+				job_mark_dirty(job_ptr);
 			} else {
 				xfree(tmp_err);
 			}
@@ -118,12 +118,27 @@ static uint64_t *rpc_user_time = NULL;
 static pthread_mutex_t throttle_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t throttle_cond = PTHREAD_COND_INITIALIZER;
 
+/* Node registration RPC waiting to be applied by _node_reg_batch() */
+typedef struct {
+	slurm_msg_t *msg;
+	int error_code;
+	bool newly_up;
+	bool done;
+} node_reg_t;
+
+static pthread_mutex_t node_reg_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t node_reg_cond = PTHREAD_COND_INITIALIZER;
+static List node_reg_list = NULL;	/* node_reg_t entries to apply */
+static bool node_reg_active = false;	/* a batch is being applied */
+
 static void         _fill_ctld_conf(slurm_ctl_conf_t * build_ptr);
 static void         _kill_job_on_msg_fail(uint32_t job_id);
 static int          _is_prolog_finished(uint32_t job_id);
 static int          _make_step_cred(struct step_record *step_rec,
 				    slurm_cred_t **slurm_cred,
 				    uint16_t protocol_version);
+static void         _node_reg_apply(List batch);
+static int          _node_reg_batch(slurm_msg_t *msg, bool *newly_up);
 inline static void  _proc_multi_msg(uint32_t rpc_uid, slurm_msg_t *msg);
 static int          _route_msg_to_origin(slurm_msg_t *msg, char *job_id_str,
 					 uint32_t job_id, uid_t uid);
@@ -666,6 +681,78 @@ extern void response_init(slurm_msg_t *resp, slurm_msg_t *msg)
 	resp->protocol_version = msg->protocol_version;
 }
 
+/*
+ * rpc_msg_class - Map an RPC message type to the rpc_class_t used to order
+ *	its processing by the RPC worker threads
+ */
+extern int rpc_msg_class(uint16_t msg_type)
+{
+	switch (msg_type) {
+	/* Compute node, slurmdbd and federation traffic */
+	case MESSAGE_EPILOG_COMPLETE:
+	case MESSAGE_NODE_REGISTRATION_STATUS:
+	case MESSAGE_COMPOSITE:
+	case REQUEST_COMPLETE_PROLOG:
+	case REQUEST_COMPLETE_BATCH_JOB:
+	case REQUEST_COMPLETE_BATCH_SCRIPT:
+	case REQUEST_STEP_COMPLETE:
+	case REQUEST_CTLD_MULT_MSG:
+	case REQUEST_SIB_JOB_LOCK:
+	case REQUEST_SIB_JOB_UNLOCK:
+	case ACCOUNTING_UPDATE_MSG:
+	case ACCOUNTING_FIRST_REG:
+	case ACCOUNTING_REGISTER_CTLD:
+		return RPC_CLASS_NODE;
+	/* Read-only requests */
+	case REQUEST_BUILD_INFO:
+	case REQUEST_JOB_INFO:
+	case REQUEST_JOB_USER_INFO:
+	case REQUEST_JOB_INFO_SINGLE:
+	case REQUEST_BATCH_SCRIPT:
+	case REQUEST_SHARE_INFO:
+	case REQUEST_PRIORITY_FACTORS:
+	case REQUEST_JOB_END_TIME:
+	case REQUEST_FED_INFO:
+	case REQUEST_FRONT_END_INFO:
+	case REQUEST_NODE_INFO:
+	case REQUEST_NODE_INFO_SINGLE:
+	case REQUEST_PARTITION_INFO:
+	case REQUEST_JOB_STEP_INFO:
+	case REQUEST_JOB_ALLOCATION_INFO:
+	case REQUEST_JOB_PACK_ALLOC_INFO:
+	case REQUEST_PING:
+	case REQUEST_RESERVATION_INFO:
+	case REQUEST_LAYOUT_INFO:
+	case REQUEST_JOB_READY:
+	case REQUEST_BURST_BUFFER_INFO:
+	case REQUEST_TRIGGER_GET:
+	case REQUEST_TOPO_INFO:
+	case REQUEST_POWERCAP_INFO:
+	case REQUEST_STATS_INFO:
+	case REQUEST_LICENSE_INFO:
+	case REQUEST_ASSOC_MGR_INFO:
+	case REQUEST_CONTROL_STATUS:
+	case REQUEST_BURST_BUFFER_STATUS:
+		return RPC_CLASS_QUERY;
+	default:
+		return RPC_CLASS_USER;
+	}
+}
+
+/* Return the name of an rpc_class_t value */
+extern char *rpc_class_str(int rpc_class)
+{
+	switch (rpc_class) {
+	case RPC_CLASS_NODE:
+		return "node";
+	case RPC_CLASS_USER:
+		return "user";
+	case RPC_CLASS_QUERY:
+		return "query";
+	}
+	return "unknown";
+}
+
 /*
  * _fill_ctld_conf - make a copy of current slurm configuration
  *	this is done with locks set so the data can change at other times
@@ -1832,11 +1919,13 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 			pack_spec_jobs(&dump, &dump_size,
 				       job_info_request_msg->job_ids,
 				       job_info_request_msg->show_flags, uid,
-				       NO_VAL, msg->protocol_version);
+				       NO_VAL, job_info_request_msg->filter,
+				       msg->protocol_version);
 		} else {
 			pack_all_jobs(&dump, &dump_size,
 				      job_info_request_msg->show_flags, uid,
-				      NO_VAL, msg->protocol_version);
+				      NO_VAL, job_info_request_msg->filter,
+				      msg->protocol_version);
 		}
 		unlock_slurmctld(job_read_lock);
 		END_TIMER2("_slurm_rpc_dump_jobs");
@@ -1873,7 +1962,8 @@ static void _slurm_rpc_dump_jobs_user(slurm_msg_t * msg)
 	debug3("Processing RPC: REQUEST_JOB_USER_INFO from uid=%d", uid);
 	lock_slurmctld(job_read_lock);
 	pack_all_jobs(&dump, &dump_size, job_info_request_msg->show_flags, uid,
-		      job_info_request_msg->user_id, msg->protocol_version);
+		      job_info_request_msg->user_id, NULL,
+		      msg->protocol_version);
 	unlock_slurmctld(job_read_lock);
 	END_TIMER2("_slurm_rpc_dump_job_user");
 #if 0
@@ -3028,6 +3118,101 @@ static void _slurm_rpc_event_log(slurm_msg_t * msg)
 	slurm_send_rc_msg(msg, error_code);
 }
 
+/*
+ * Apply the registrations of a batch of nodes. Reconcile the jobs of all
+ * of the nodes with one scan of the job list.
+ * Call with the config read, job write and node write locks set.
+ */
+static void _node_reg_apply(List batch)
+{
+	ListIterator iter;
+	node_reg_t *node_reg;
+	slurm_node_registration_status_msg_t *reg_msg;
+#ifndef HAVE_FRONT_END
+	bitstr_t *purge_node_bitmap = bit_alloc(node_record_count);
+#endif
+
+	iter = list_iterator_create(batch);
+#ifndef HAVE_FRONT_END
+	while ((node_reg = list_next(iter)))
+		validate_jobs_on_node(node_reg->msg->data, purge_node_bitmap);
+	list_iterator_reset(iter);
+	if (bit_ffs(purge_node_bitmap) != -1)
+		purge_missing_jobs(purge_node_bitmap);
+	FREE_NULL_BITMAP(purge_node_bitmap);
+#endif
+
+	while ((node_reg = list_next(iter))) {
+		reg_msg = node_reg->msg->data;
+#ifdef HAVE_FRONT_END		/* Operates only on front-end */
+		node_reg->error_code = validate_nodes_via_front_end(
+			reg_msg, node_reg->msg->protocol_version,
+			&node_reg->newly_up);
+#else
+		node_reg->error_code = validate_node_specs(
+			reg_msg, node_reg->msg->protocol_version,
+			&node_reg->newly_up);
+#endif
+	}
+	list_iterator_destroy(iter);
+}
+
+/*
+ * Queue a node registration and wait for it to be applied. Registrations
+ * that arrive while another thread waits for or holds the slurmctld locks
+ * are applied together by that thread under a single lock acquisition,
+ * which keeps a boot storm of thousands of nodes from taking the job and
+ * node write locks once per node.
+ * OUT newly_up - set if the node was returned to service
+ * RET error code from validate_node_specs()
+ */
+static int _node_reg_batch(slurm_msg_t *msg, bool *newly_up)
+{
+	node_reg_t node_reg = { .msg = msg }, *next_reg;
+	List batch;
+	int batch_cnt;
+	/* Locks: Read config, write job, write node, read federation */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, READ_LOCK };
+
+	slurm_mutex_lock(&node_reg_mutex);
+	if (!node_reg_list)
+		node_reg_list = list_create(NULL);
+	list_append(node_reg_list, &node_reg);
+	while (!node_reg.done) {
+		if (node_reg_active) {
+			slurm_cond_wait(&node_reg_cond, &node_reg_mutex);
+			continue;
+		}
+		node_reg_active = true;
+		slurm_mutex_unlock(&node_reg_mutex);
+
+		lock_slurmctld(job_write_lock);
+		/* Take all registrations queued while waiting for locks */
+		slurm_mutex_lock(&node_reg_mutex);
+		batch = node_reg_list;
+		node_reg_list = list_create(NULL);
+		slurm_mutex_unlock(&node_reg_mutex);
+		batch_cnt = list_count(batch);
+		_node_reg_apply(batch);
+		unlock_slurmctld(job_write_lock);
+		if (batch_cnt > 1)
+			debug2("%s: applied %d node registrations",
+			       __func__, batch_cnt);
+
+		slurm_mutex_lock(&node_reg_mutex);
+		while ((next_reg = list_pop(batch)))
+			next_reg->done = true;
+		FREE_NULL_LIST(batch);
+		node_reg_active = false;
+		slurm_cond_broadcast(&node_reg_cond);
+	}
+	slurm_mutex_unlock(&node_reg_mutex);
+
+	*newly_up = node_reg.newly_up;
+	return node_reg.error_code;
+}
+
 /* _slurm_rpc_node_registration - process RPC to determine if a node's
  *	actual configuration satisfies the configured specification */
 static void _slurm_rpc_node_registration(slurm_msg_t * msg,
@@ -3039,9 +3224,6 @@ static void _slurm_rpc_node_registration(slurm_msg_t * msg,
 	bool newly_up = false;
 	slurm_node_registration_status_msg_t *node_reg_stat_msg =
 		(slurm_node_registration_status_msg_t *) msg->data;
-	/* Locks: Read config, write job, write node */
-	slurmctld_lock_t job_write_lock = {
-		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, READ_LOCK };
 	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred);
 
 	START_TIMER;
@@ -3070,20 +3252,20 @@ static void _slurm_rpc_node_registration(slurm_msg_t * msg,
 			      "set DebugFlags=NO_CONF_HASH in your slurm.conf.",
 			      node_reg_stat_msg->node_name);
 		}
-		if (!running_composite)
-			lock_slurmctld(job_write_lock);
+		if (!running_composite) {
+			error_code = _node_reg_batch(msg, &newly_up);
+		} else {
 #ifdef HAVE_FRONT_END		/* Operates only on front-end */
-		error_code = validate_nodes_via_front_end(node_reg_stat_msg,
-							  msg->protocol_version,
-							  &newly_up);
+			error_code = validate_nodes_via_front_end(
+				node_reg_stat_msg, msg->protocol_version,
+				&newly_up);
 #else
-		validate_jobs_on_node(node_reg_stat_msg);
-		error_code = validate_node_specs(node_reg_stat_msg,
-						 msg->protocol_version,
-						 &newly_up);
+			validate_jobs_on_node(node_reg_stat_msg, NULL);
+			error_code = validate_node_specs(node_reg_stat_msg,
+							 msg->protocol_version,
+							 &newly_up);
 #endif
-		if (!running_composite)
-			unlock_slurmctld(job_write_lock);
+		}
 		END_TIMER2("_slurm_rpc_node_registration");
 		if (newly_up) {
 			queue_job_scheduler();
@@ -6441,6 +6623,14 @@ static void  _slurm_rpc_composite_msg(slurm_msg_t *msg)
 
 	_throttle_start(&active_rpc_cnt);
 	lock_slurmctld(job_write_lock);
+	if (comp_msg->msg_list) {
+		uint32_t msg_cnt = list_count(comp_msg->msg_list);
+
+		slurmctld_diag_stats.msg_aggr_cnt++;
+		slurmctld_diag_stats.msg_aggr_msgs += msg_cnt;
+		slurmctld_diag_stats.msg_aggr_max =
+			MAX(slurmctld_diag_stats.msg_aggr_max, msg_cnt);
+	}
 	gettimeofday(&start_tv, NULL);
 	_slurm_rpc_comp_msg_list(comp_msg, &run_scheduler,
 				 comp_resp_msg.msg_list, &start_tv,
@@ -67,6 +67,15 @@ void slurmctld_req(slurm_msg_t * msg, connection_arg_t *);
  */
 extern void response_init(slurm_msg_t *resp, slurm_msg_t *msg);
 
+/*
+ * rpc_msg_class - Map an RPC message type to the rpc_class_t used to order
+ *	its processing by the RPC worker threads
+ */
+extern int rpc_msg_class(uint16_t msg_type);
+
+/* Return the name of an rpc_class_t value */
+extern char *rpc_class_str(int rpc_class);
+
 /*
  * slurm_drain_nodes - process a request to drain a list of nodes,
  *	no-op for nodes already drained or draining
@@ -98,6 +98,7 @@
 List active_feature_list;	/* list of currently active features_records */
 List avail_feature_list;	/* list of available features_records */
 bool node_features_updated = false;
+uint32_t node_features_gen = 0;
 bool slurmctld_init_db = true;
 
 static void _acct_restore_active_jobs(void);
@@ -1578,6 +1579,7 @@ extern void build_feature_list_eq(void)
 	FREE_NULL_LIST(avail_feature_list);
 	active_feature_list = list_create(_list_delete_feature);
 	avail_feature_list = list_create(_list_delete_feature);
+	node_features_gen++;
 
 	config_iterator = list_iterator_create(config_list);
 	while ((config_ptr = (struct config_record *)
@@ -1648,6 +1650,7 @@ extern void build_feature_list_ne(void)
 	FREE_NULL_LIST(avail_feature_list);
 	active_feature_list = list_create(_list_delete_feature);
 	avail_feature_list = list_create(_list_delete_feature);
+	node_features_gen++;
 
 	for (i = 0, node_ptr = node_record_table_ptr; i < node_record_count;
 	     i++, node_ptr++) {
@@ -1712,6 +1715,7 @@ extern void update_feature_list(List feature_list, char *new_features,
 		xfree(tmp_str);
 	}
 	node_features_updated = true;
+	node_features_gen++;
 }
 
 static void _gres_reconfig(bool reconfig)
@@ -79,6 +79,27 @@
 #define MAX_SERVER_THREADS 256
 #endif
 
+/* Default count of threads servicing incoming RPCs, which may be changed
+ * with SlurmctldParameters=rpc_workers=#. Connections which arrive while all
+ * workers are busy are queued until one is free. The count of queued plus
+ * active connections is still limited by MAX_SERVER_THREADS. */
+#ifndef RPC_WORKER_COUNT
+#define RPC_WORKER_COUNT 64
+#endif
+
+/* Default relative weights used by RPC workers to choose between the queues
+ * of each RPC class, which may be changed with SlurmctldParameters
+ * rpc_weight_node=#, rpc_weight_user=# and rpc_weight_query=#. */
+#ifndef RPC_WEIGHT_NODE
+#define RPC_WEIGHT_NODE  16
+#endif
+#ifndef RPC_WEIGHT_USER
+#define RPC_WEIGHT_USER  4
+#endif
+#ifndef RPC_WEIGHT_QUERY
+#define RPC_WEIGHT_QUERY 1
+#endif
+
 /* Perform full slurmctld's state every PERIODIC_CHECKPOINT seconds */
 #ifndef PERIODIC_CHECKPOINT
 #define	PERIODIC_CHECKPOINT	300
@@ -155,6 +176,14 @@ typedef struct slurmctld_config {
 	pthread_t thread_id_rpc;
 } slurmctld_config_t;
 
+/* RPC classes, in order of precedence for the RPC worker threads */
+typedef enum {
+	RPC_CLASS_NODE = 0,	/* slurmd, slurmdbd and federation traffic */
+	RPC_CLASS_USER,		/* user requests which modify state */
+	RPC_CLASS_QUERY,	/* read-only user requests */
+	RPC_CLASS_CNT
+} rpc_class_t;
+
 /* Job scheduling statistics */
 typedef struct diag_stats {
 	int proc_req_threads;
@@ -194,6 +223,33 @@ typedef struct diag_stats {
 	uint32_t bf_active;
 
 	uint32_t latency;
+
+	uint32_t rpc_pool_workers;	/* RPC worker threads */
+	uint32_t rpc_pool_busy;		/* workers now servicing an RPC */
+	uint64_t rpc_pool_busy_time;	/* usec workers spent servicing RPCs */
+	uint32_t rpc_pool_pending;	/* connections waiting for data */
+	uint32_t rpc_pool_queue_len;	/* connections waiting for a worker */
+	uint32_t rpc_pool_queue_max;	/* high-water mark of rpc_pool_queue_len */
+	uint32_t rpc_pool_queue_cnt;	/* connections passed to workers */
+	uint64_t rpc_pool_queue_wait;	/* usec connections waited for a worker */
+	uint32_t rpc_pool_throttled;	/* times accept paused at thread limit */
+
+	/* RPC worker statistics by rpc_class_t */
+	uint32_t rpc_class_weight[RPC_CLASS_CNT];
+	uint32_t rpc_class_queue_len[RPC_CLASS_CNT];
+	uint32_t rpc_class_cnt[RPC_CLASS_CNT];
+	uint64_t rpc_class_wait[RPC_CLASS_CNT];	/* usec waiting in queue */
+	uint64_t rpc_class_time[RPC_CLASS_CNT];	/* usec from data to reply */
+	uint32_t rpc_class_time_max[RPC_CLASS_CNT];
+
+	/* Message aggregation, see MsgAggregationParams */
+	uint32_t msg_aggr_cnt;		/* MESSAGE_COMPOSITE received */
+	uint32_t msg_aggr_msgs;		/* messages they carried */
+	uint32_t msg_aggr_max;		/* most messages in one */
+	uint32_t kill_aggr_windows;	/* kill RPC collection windows sent */
+	uint32_t kill_aggr_full;	/* windows ended by WindowMsgs */
+	uint32_t kill_aggr_msgs;	/* kill RPCs collected */
+	uint32_t kill_aggr_max;		/* most kill RPCs in one window */
 } diag_stats_t;
 
 /* This is used to point out constants that exist in the
@@ -224,6 +280,8 @@ extern int   batch_sched_delay;
 extern time_t control_time;		/* Time when became primary controller */
 extern uint32_t   cluster_cpus;
 extern bool node_features_updated;
+extern uint32_t node_features_gen;	/* incremented on any change to
+					 * active/avail_feature_list */
 extern pthread_cond_t purge_thread_cond;
 extern pthread_mutex_t purge_thread_lock;
 extern pthread_mutex_t check_bf_running_lock;
@@ -482,6 +540,10 @@ typedef struct job_feature {
 	uint8_t op_code;		/* separator, see FEATURE_OP_ above */
 	bitstr_t *node_bitmap_active;	/* nodes with this feature active */
 	bitstr_t *node_bitmap_avail;	/* nodes with this feature available */
+	uint32_t node_features_gen;	/* node_features_gen when node_bitmap_*
+					 * were last set */
+	bool bitmap_can_reboot;		/* can_reboot when node_bitmap_* were
+					 * last set */
 	uint16_t paren;			/* count of enclosing parenthesis */
 } job_feature_t;
 
@@ -525,6 +587,9 @@ struct job_details {
 					 * each task */
 	uint16_t orig_cpus_per_task;	/* requested value of cpus_per_task */
 	List depend_list;		/* list of job_ptr:state pairs */
+	uint32_t depend_epoch;		/* epoch of cached dependency test */
+	time_t depend_time;		/* time dependencies last found
+					 * unsatisfied, 0 if must retest */
 	char *dependency;		/* wait for other jobs */
 	char *orig_dependency;		/* original value (for archiving) */
 	uint16_t env_cnt;		/* size of env_sup (see below) */
@@ -699,6 +764,7 @@ struct job_record {
 	uint16_t direct_set_prio;	/* Priority set directly if
 					 * set the system will not
 					 * change the priority any further. */
+	uint32_t dirty_gen;		/* bumped by job_mark_dirty() */
 	time_t end_time;		/* time execution ended, actual or
 					 * expected. if terminated from suspend
 					 * state, this is time suspend began */
@@ -766,6 +832,8 @@ struct job_record {
 	char *origin_cluster;		/* cluster name that the job was
 					 * submitted from */
 	uint16_t other_port;		/* port for client communications */
+	struct job_pack_cache *pack_cache; /* job_info records packed for
+					 * REQUEST_JOB_INFO, see pack_job() */
 	pack_details_t *pack_details;	/* hetjob details */
 	uint32_t pack_job_id;		/* lead job ID of pack job leader */
 	char *pack_job_id_set;		/* job IDs for all components */
@@ -796,6 +864,8 @@ struct job_record {
 					 * this job, confirm the
 					 * value before use */
 	void *qos_blocking_ptr;		/* internal use only, DON'T PACK */
+	uint32_t queue_rank;		/* position in last sorted job queue,
+					 * (Internal use only, don't save) */
 	uint8_t reboot;			/* node reboot requested before start */
 	uint16_t restart_cnt;		/* count of restarts */
 	time_t resize_time;		/* time of latest size change */
@@ -819,6 +889,10 @@ struct job_record {
 	time_t start_time;		/* time execution begins,
 					 * actual or expected */
 	char *state_desc;		/* optional details for state_reason */
+	uint32_t state_gen;		/* dirty_gen when state_hash was set */
+	uint64_t state_hash;		/* hash of state last written to the
+					 * job state journal or snapshot, 0 if
+					 * not yet saved */
 	uint32_t state_reason;		/* reason job still pending or failed
 					 * see slurm.h:enum job_state_reason */
 	uint32_t state_reason_prev;	/* Previous state_reason, needed to
@@ -1653,6 +1727,15 @@ extern int job_complete(uint32_t job_id, uid_t uid, bool requeue,
  */
 extern bool job_independent(struct job_record *job_ptr, int will_run);
 
+/*
+ * job_mark_dirty - note a change to a job record, invalidating any cached
+ *	copy of its packed job_info and the cached dependency test results of
+ *	jobs which depend upon it. Plugins which modify a job record directly
+ *	must call this too, or the change can miss the job state journal.
+ * IN job_ptr - job modified, NULL if any or all jobs may have changed
+ */
+extern void job_mark_dirty(struct job_record *job_ptr);
+
 /*
  * job_req_node_filter - job reqeust node filter.
  *	clear from a bitmap the nodes which can not be used for a job
@@ -1969,6 +2052,7 @@ extern int num_pending_job_array_tasks(uint32_t array_job_id);
  * IN show_flags - job filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN filter_uid - pack only jobs belonging to this user if not NO_VAL
+ * IN filter - pack only matching jobs and fields, NULL for all
  * IN protocol_version - slurm protocol version of client
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
@@ -1977,7 +2061,7 @@ extern int num_pending_job_array_tasks(uint32_t array_job_id);
  */
 extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid, uint32_t filter_uid,
-			  uint16_t protocol_version);
+			  job_info_filter_t *filter, uint16_t protocol_version);
 
 /*
  * pack_spec_jobs - dump job information for specified jobs in
@@ -1988,6 +2072,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
  * IN job_ids - list of job_ids to pack
  * IN uid - uid of user making request (for partition filtering)
  * IN filter_uid - pack only jobs belonging to this user if not NO_VAL
+ * IN filter - pack only matching jobs and fields, NULL for all
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
  * NOTE: change _unpack_job_desc_msg() in common/slurm_protocol_pack.c
@@ -1995,7 +2080,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
  */
 extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 			   uint16_t show_flags, uid_t uid, uint32_t filter_uid,
-			   uint16_t protocol_version);
+			   job_info_filter_t *filter, uint16_t protocol_version);
 
 /*
  * pack_all_node - dump all configuration and node information for all nodes
@@ -2054,6 +2139,7 @@ extern void pack_all_part(char **buffer_ptr, int *buffer_size,
  *	machine independent form (for network transmission)
  * IN dump_job_ptr - pointer to job for which information is requested
  * IN show_flags - job filtering options
+ * IN skip_fields - JOB_FIELD_* groups to pack as NULL or zero
  * IN/OUT buffer - buffer in which data is placed, pointers automatically
  *	updated
  * IN uid - user requesting the data
@@ -2061,7 +2147,8 @@ extern void pack_all_part(char **buffer_ptr, int *buffer_size,
  *	  whenever the data format changes
  */
 extern void pack_job (struct job_record *dump_job_ptr, uint16_t show_flags,
-		      Buf buffer, uint16_t protocol_version, uid_t uid);
+		      uint32_t skip_fields, Buf buffer,
+		      uint16_t protocol_version, uid_t uid);
 
 /*
  * pack_part - dump all configuration information about a specific partition
@@ -2595,8 +2682,11 @@ extern int validate_job_create_req(job_desc_msg_t * job_desc, uid_t submit_uid,
  *	records, call this function after validate_node_specs() sets the node
  *	state properly
  * IN reg_msg - node registration message
+ * IN/OUT purge_node_bitmap - if set, record the node here for a later
+ *	purge_missing_jobs() call rather than purging its missing jobs now
  */
-extern void validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg);
+extern void validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg,
+				  bitstr_t *purge_node_bitmap);
 
 /*
  * validate_node_specs - validate the node's specifications as valid,
@@ -2694,6 +2784,15 @@ extern void update_job_fed_details(struct job_record *job_ptr);
  */
 extern int purge_job_record(uint32_t job_id);
 
+/*
+ * purge_missing_jobs - purge batch jobs and notify srun of job steps that
+ *	should be running on the specified nodes, but were not reported by
+ *	their slurmd when the nodes registered
+ * IN node_bitmap - nodes that just registered
+ * global: job_list - global job table
+ */
+extern void purge_missing_jobs(bitstr_t *node_bitmap);
+
 /*
  * copy_job_record_to_job_desc - construct a job_desc_msg_t for a job.
  * IN job_ptr - the job record
@@ -39,6 +39,8 @@
 #include <stdio.h>
 
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/locks.h"
+#include "src/slurmctld/proc_req.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/common/list.h"
 #include "src/common/pack.h"
@@ -47,6 +49,141 @@
 
 extern int retry_list_size(void);
 
+/* Snapshot of one call site's lock statistics */
+typedef struct {
+	lock_stat_t *stat;
+	uint32_t cnt;
+	uint64_t wait_time;
+	uint32_t wait_max;
+	uint32_t wait_hist[LOCK_STAT_BUCKETS];
+	uint64_t hold_time;
+	uint32_t hold_max;
+	uint32_t hold_hist[LOCK_STAT_BUCKETS];
+} lock_stat_snap_t;
+
+/* Sort lock statistics by decreasing total wait time */
+static int _sort_lock_stat(const void *x, const void *y)
+{
+	const lock_stat_snap_t *a = x, *b = y;
+
+	if (a->wait_time > b->wait_time)
+		return -1;
+	if (a->wait_time < b->wait_time)
+		return 1;
+	return 0;
+}
+
+/* Build a description of lock levels, e.g. "job:W,node:R" */
+static char *_lock_levels_str(slurmctld_lock_t *lock_levels)
+{
+	lock_level_t levels[] = { lock_levels->conf, lock_levels->job,
+				  lock_levels->node, lock_levels->part,
+				  lock_levels->fed };
+	char *names[] = { "conf", "job", "node", "part", "fed" };
+	char *str = NULL, *sep = "";
+	int i;
+
+	for (i = 0; i < ENTITY_COUNT; i++) {
+		if (levels[i] == NO_LOCK)
+			continue;
+		xstrfmtcat(str, "%s%s:%c", sep, names[i],
+			   (levels[i] == WRITE_LOCK) ? 'W' : 'R');
+		sep = ",";
+	}
+	return str;
+}
+
+/*
+ * Pack the lock wait and hold statistics of every lock_slurmctld() call site
+ * which has acquired locks since the last reset, busiest waits first
+ */
+static void _pack_lock_stats(Buf buffer)
+{
+	lock_stat_snap_t *snap = NULL;
+	lock_stat_t *stat;
+	char **site, **type;
+	uint32_t *cnt, *wait_max, *hold_max, *wait_hist, *hold_hist;
+	uint64_t *wait_time, *hold_time;
+	int i, snap_cnt = 0, snap_size = 0;
+
+	for (stat = lock_stats_list(); stat; stat = stat->next) {
+		if (snap_cnt >= snap_size) {
+			snap_size += 64;
+			xrealloc(snap, sizeof(lock_stat_snap_t) * snap_size);
+		}
+		slurm_mutex_lock(&stat->mutex);
+		if (stat->cnt) {
+			snap[snap_cnt].stat = stat;
+			snap[snap_cnt].cnt = stat->cnt;
+			snap[snap_cnt].wait_time = stat->wait_time;
+			snap[snap_cnt].wait_max = stat->wait_max;
+			memcpy(snap[snap_cnt].wait_hist, stat->wait_hist,
+			       sizeof(stat->wait_hist));
+			snap[snap_cnt].hold_time = stat->hold_time;
+			snap[snap_cnt].hold_max = stat->hold_max;
+			memcpy(snap[snap_cnt].hold_hist, stat->hold_hist,
+			       sizeof(stat->hold_hist));
+			snap_cnt++;
+		}
+		slurm_mutex_unlock(&stat->mutex);
+	}
+	if (snap_cnt)
+		qsort(snap, snap_cnt, sizeof(lock_stat_snap_t),
+		      _sort_lock_stat);
+
+	site = xcalloc(snap_cnt + 1, sizeof(char *));
+	type = xcalloc(snap_cnt + 1, sizeof(char *));
+	cnt = xcalloc(snap_cnt + 1, sizeof(uint32_t));
+	wait_time = xcalloc(snap_cnt + 1, sizeof(uint64_t));
+	wait_max = xcalloc(snap_cnt + 1, sizeof(uint32_t));
+	hold_time = xcalloc(snap_cnt + 1, sizeof(uint64_t));
+	hold_max = xcalloc(snap_cnt + 1, sizeof(uint32_t));
+	wait_hist = xcalloc((snap_cnt * LOCK_STAT_BUCKETS) + 1,
+			    sizeof(uint32_t));
+	hold_hist = xcalloc((snap_cnt * LOCK_STAT_BUCKETS) + 1,
+			    sizeof(uint32_t));
+	for (i = 0; i < snap_cnt; i++) {
+		site[i] = xstrdup_printf("%s:%d", snap[i].stat->func,
+					 snap[i].stat->line);
+		type[i] = _lock_levels_str(&snap[i].stat->lock_levels);
+		cnt[i] = snap[i].cnt;
+		wait_time[i] = snap[i].wait_time;
+		wait_max[i] = snap[i].wait_max;
+		hold_time[i] = snap[i].hold_time;
+		hold_max[i] = snap[i].hold_max;
+		memcpy(&wait_hist[i * LOCK_STAT_BUCKETS], snap[i].wait_hist,
+		       sizeof(snap[i].wait_hist));
+		memcpy(&hold_hist[i * LOCK_STAT_BUCKETS], snap[i].hold_hist,
+		       sizeof(snap[i].hold_hist));
+	}
+
+	packstr_array(site, snap_cnt, buffer);
+	packstr_array(type, snap_cnt, buffer);
+	pack32_array(cnt, snap_cnt, buffer);
+	pack64_array(wait_time, snap_cnt, buffer);
+	pack32_array(wait_max, snap_cnt, buffer);
+	pack64_array(hold_time, snap_cnt, buffer);
+	pack32_array(hold_max, snap_cnt, buffer);
+	pack32(LOCK_STAT_BUCKETS, buffer);
+	pack32_array(wait_hist, snap_cnt * LOCK_STAT_BUCKETS, buffer);
+	pack32_array(hold_hist, snap_cnt * LOCK_STAT_BUCKETS, buffer);
+
+	for (i = 0; i < snap_cnt; i++) {
+		xfree(site[i]);
+		xfree(type[i]);
+	}
+	xfree(site);
+	xfree(type);
+	xfree(cnt);
+	xfree(wait_time);
+	xfree(wait_max);
+	xfree(hold_time);
+	xfree(hold_max);
+	xfree(wait_hist);
+	xfree(hold_hist);
+	xfree(snap);
+}
+
 /* Pack all scheduling statistics */
 extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			  uint16_t protocol_version)
@@ -56,6 +193,8 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 	int agent_queue_size;
 	int agent_count;
 	int slurmdbd_queue_size;
+	char *class_name[RPC_CLASS_CNT];
+	int i;
 	time_t now = time(NULL);
 
 	buffer_ptr[0] = NULL;
@@ -135,6 +274,64 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			pack32(slurmctld_diag_stats.bf_active, buffer);
 			pack32(slurmctld_diag_stats.backfilled_pack_jobs,
 			       buffer);
+
+			if (protocol_version >= SLURM_20_02_PROTOCOL_VERSION) {
+				pack32(slurmctld_diag_stats.rpc_pool_workers,
+				       buffer);
+				pack32(slurmctld_diag_stats.rpc_pool_busy,
+				       buffer);
+				pack64(slurmctld_diag_stats.rpc_pool_busy_time,
+				       buffer);
+				pack32(slurmctld_diag_stats.rpc_pool_pending,
+				       buffer);
+				pack32(slurmctld_diag_stats.rpc_pool_queue_len,
+				       buffer);
+				pack32(slurmctld_diag_stats.rpc_pool_queue_max,
+				       buffer);
+				pack32(slurmctld_diag_stats.rpc_pool_queue_cnt,
+				       buffer);
+				pack64(slurmctld_diag_stats.rpc_pool_queue_wait,
+				       buffer);
+				pack32(slurmctld_diag_stats.rpc_pool_throttled,
+				       buffer);
+
+				for (i = 0; i < RPC_CLASS_CNT; i++)
+					class_name[i] = rpc_class_str(i);
+				packstr_array(class_name, RPC_CLASS_CNT,
+					      buffer);
+				pack32_array(
+					slurmctld_diag_stats.rpc_class_weight,
+					RPC_CLASS_CNT, buffer);
+				pack32_array(
+					slurmctld_diag_stats.rpc_class_queue_len,
+					RPC_CLASS_CNT, buffer);
+				pack32_array(slurmctld_diag_stats.rpc_class_cnt,
+					     RPC_CLASS_CNT, buffer);
+				pack64_array(slurmctld_diag_stats.rpc_class_wait,
+					     RPC_CLASS_CNT, buffer);
+				pack64_array(slurmctld_diag_stats.rpc_class_time,
+					     RPC_CLASS_CNT, buffer);
+				pack32_array(
+					slurmctld_diag_stats.rpc_class_time_max,
+					RPC_CLASS_CNT, buffer);
+
+				_pack_lock_stats(buffer);
+
+				pack32(slurmctld_diag_stats.msg_aggr_cnt,
+				       buffer);
+				pack32(slurmctld_diag_stats.msg_aggr_msgs,
+				       buffer);
+				pack32(slurmctld_diag_stats.msg_aggr_max,
+				       buffer);
+				pack32(slurmctld_diag_stats.kill_aggr_windows,
+				       buffer);
+				pack32(slurmctld_diag_stats.kill_aggr_full,
+				       buffer);
+				pack32(slurmctld_diag_stats.kill_aggr_msgs,
+				       buffer);
+				pack32(slurmctld_diag_stats.kill_aggr_max,
+				       buffer);
+			}
 		}
 	}
 
@@ -146,6 +343,8 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
  * level IN - clear backfilled_jobs count if set */
 extern void reset_stats(int level)
 {
+	int i;
+
 	slurmctld_diag_stats.proc_req_raw = 0;
 	slurmctld_diag_stats.proc_req_threads = 0;
 	slurmctld_diag_stats.schedule_cycle_max = 0;
@@ -176,5 +375,25 @@ extern void reset_stats(int level)
 	slurmctld_diag_stats.bf_last_depth_try = 0;
 	slurmctld_diag_stats.bf_active = 0;
 
+	slurmctld_diag_stats.rpc_pool_busy_time = 0;
+	slurmctld_diag_stats.rpc_pool_queue_max = 0;
+	slurmctld_diag_stats.rpc_pool_queue_cnt = 0;
+	slurmctld_diag_stats.rpc_pool_queue_wait = 0;
+	slurmctld_diag_stats.rpc_pool_throttled = 0;
+	for (i = 0; i < RPC_CLASS_CNT; i++) {
+		slurmctld_diag_stats.rpc_class_cnt[i] = 0;
+		slurmctld_diag_stats.rpc_class_wait[i] = 0;
+		slurmctld_diag_stats.rpc_class_time[i] = 0;
+		slurmctld_diag_stats.rpc_class_time_max[i] = 0;
+	}
+	slurmctld_diag_stats.msg_aggr_cnt = 0;
+	slurmctld_diag_stats.msg_aggr_msgs = 0;
+	slurmctld_diag_stats.msg_aggr_max = 0;
+	slurmctld_diag_stats.kill_aggr_windows = 0;
+	slurmctld_diag_stats.kill_aggr_full = 0;
+	slurmctld_diag_stats.kill_aggr_msgs = 0;
+	slurmctld_diag_stats.kill_aggr_max = 0;
+	lock_stats_reset();
+
 	last_proc_req_start = time(NULL);
 }
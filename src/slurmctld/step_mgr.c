@@ -181,6 +181,7 @@ static struct step_record * _create_step_record(struct job_record *job_ptr,
 	step_ptr = xmalloc(sizeof(struct step_record));
 
 	last_job_update = time(NULL);
+	job_mark_dirty(job_ptr);
 	step_ptr->job_ptr    = job_ptr;
 	step_ptr->exit_code  = NO_VAL;
 	step_ptr->time_limit = INFINITE;
@@ -317,6 +318,7 @@ extern void delete_step_records (struct job_record *job_ptr)
 	xassert(job_ptr);
 
 	last_job_update = time(NULL);
+	job_mark_dirty(job_ptr);
 	step_iterator = list_iterator_create(job_ptr->step_list);
 	while ((step_ptr = (struct step_record *) list_next (step_iterator))) {
 		/* Only check if not a pending step */
@@ -430,6 +432,7 @@ delete_step_record (struct job_record *job_ptr, uint32_t step_id)
 		return error_code;
 
 	last_job_update = time(NULL);
+	job_mark_dirty(job_ptr);
 	step_iterator = list_iterator_create (job_ptr->step_list);
 	while ((step_ptr = (struct step_record *) list_next (step_iterator))) {
 		if (step_ptr->step_id != step_id)
@@ -834,6 +837,7 @@ int job_step_complete(uint32_t job_id, uint32_t step_id, uid_t uid,
 	_internal_step_complete(job_ptr, step_ptr);
 
 	last_job_update = time(NULL);
+	job_mark_dirty(job_ptr);
 
 	return SLURM_SUCCESS;
 }
@@ -3400,6 +3404,7 @@ extern int job_step_checkpoint(checkpoint_msg_t *ckpt_ptr,
 				   &resp_data.error_code,
 				   &resp_data.error_msg);
 		last_job_update = time(NULL);
+		job_mark_dirty(job_ptr);
 	}
 
     reply:
@@ -3466,6 +3471,7 @@ extern int job_step_checkpoint_comp(checkpoint_comp_msg_t *ckpt_ptr,
 		rc = checkpoint_comp((void *)step_ptr, ckpt_ptr->begin_time,
 			ckpt_ptr->error_code, ckpt_ptr->error_msg);
 		last_job_update = time(NULL);
+		job_mark_dirty(job_ptr);
 	}
 
     reply:
@@ -3525,6 +3531,7 @@ extern int job_step_checkpoint_task_comp(checkpoint_task_comp_msg_t *ckpt_ptr,
 			ckpt_ptr->task_id, ckpt_ptr->begin_time,
 			ckpt_ptr->error_code, ckpt_ptr->error_msg);
 		last_job_update = time(NULL);
+		job_mark_dirty(job_ptr);
 	}
 
     reply:
@@ -4287,6 +4294,7 @@ extern void step_checkpoint(void)
 					      -1, NO_VAL16);
 			job_ptr->ckpt_time = now;
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			continue; /* ignore periodic step ckpt */
 		}
 		step_iterator = list_iterator_create (job_ptr->step_list);
@@ -4313,6 +4321,7 @@ extern void step_checkpoint(void)
 
 			step_ptr->ckpt_time = now;
 			last_job_update = now;
+			job_mark_dirty(job_ptr);
 			image_dir = xstrdup(step_ptr->ckpt_dir);
 			xstrfmtcat(image_dir, "/%u.%u", job_ptr->job_id,
 				   step_ptr->step_id);
@@ -4582,8 +4591,10 @@ extern int update_step(step_update_request_msg_t *req, uid_t uid)
 			     step_ptr, req->time_limit);
 		}
 	}
-	if (mod_cnt)
+	if (mod_cnt) {
 		last_job_update = time(NULL);
+		job_mark_dirty(job_ptr);
+	}
 	if (new_step) {
 		/*
 		 * This was a temporary step record, never linked to the job,
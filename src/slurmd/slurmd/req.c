@@ -188,6 +188,7 @@ static void _rpc_timelimit(slurm_msg_t *);
 static void _rpc_reattach_tasks(slurm_msg_t *);
 static void _rpc_suspend_job(slurm_msg_t *msg);
 static void _rpc_terminate_job(slurm_msg_t *);
+static void _rpc_terminate_job_aggr(slurm_msg_t *msg);
 static void _rpc_update_time(slurm_msg_t *);
 static void _rpc_shutdown(slurm_msg_t *msg);
 static void _rpc_reconfig(slurm_msg_t *msg);
@@ -359,6 +360,11 @@ slurmd_req(slurm_msg_t *msg)
 		last_slurmctld_msg = time(NULL);
 		_rpc_terminate_job(msg);
 		break;
+	case REQUEST_TERMINATE_JOB_AGGR:
+		debug2("Processing RPC: REQUEST_TERMINATE_JOB_AGGR");
+		last_slurmctld_msg = time(NULL);
+		_rpc_terminate_job_aggr(msg);
+		break;
 	case REQUEST_COMPLETE_BATCH_SCRIPT:
 		debug2("Processing RPC: REQUEST_COMPLETE_BATCH_SCRIPT");
 		_rpc_complete_batch(msg);
@@ -3923,9 +3929,11 @@ _rpc_timelimit(slurm_msg_t *msg)
 	/*
 	 *  Indicate to slurmctld that we've received the message
 	 */
-	slurm_send_rc_msg(msg, SLURM_SUCCESS);
-	close(msg->conn_fd);
-	msg->conn_fd = -1;
+	if (msg->conn_fd >= 0) {
+		slurm_send_rc_msg(msg, SLURM_SUCCESS);
+		close(msg->conn_fd);
+		msg->conn_fd = -1;
+	}
 
 	if (req->step_id != NO_VAL) {
 		slurm_ctl_conf_t *cf;
@@ -5306,6 +5314,65 @@ _rpc_complete_batch(slurm_msg_t *msg)
 	_handle_old_batch_job_launch(&resp_msg);
 }
 
+/* Process one kill request of a REQUEST_TERMINATE_JOB_AGGR */
+static void *_terminate_job_aggr_thread(void *arg)
+{
+	slurm_msg_t *msg = arg;
+
+	slurmd_req(msg);
+	slurm_free_comp_msg_list(msg);
+	return NULL;
+}
+
+/*
+ * The kill requests of this node's jobs that ended during one slurmctld
+ * collection window. Process them as if they had been sent directly, but
+ * without a connection to reply on. Any for jobs not on this node are
+ * skipped.
+ * The slurmctld learns of their completion from MESSAGE_EPILOG_COMPLETE.
+ */
+static void
+_rpc_terminate_job_aggr(slurm_msg_t *msg)
+{
+	composite_msg_t *comp_msg = msg->data;
+	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred);
+	slurm_msg_t *next_msg;
+	kill_job_msg_t *req;
+	ListIterator itr;
+
+	if (!_slurm_authorized_user(uid)) {
+		error("Security violation: kill_job_aggr from uid %d", uid);
+		slurm_send_rc_msg(msg, ESLURM_USER_ID_MISSING);
+		return;
+	}
+	slurm_send_rc_msg(msg, SLURM_SUCCESS);
+	if (close(msg->conn_fd) < 0)
+		error("%s: close(%d): %m", __func__, msg->conn_fd);
+	msg->conn_fd = -1;
+
+	if (!comp_msg->msg_list)
+		return;
+	itr = list_iterator_create(comp_msg->msg_list);
+	while ((next_msg = list_next(itr))) {
+		if ((next_msg->msg_type != REQUEST_TERMINATE_JOB)  &&
+		    (next_msg->msg_type != REQUEST_KILL_PREEMPTED) &&
+		    (next_msg->msg_type != REQUEST_KILL_TIMELIMIT)) {
+			error("%s: invalid msg type %s", __func__,
+			      rpc_num2string(next_msg->msg_type));
+			continue;
+		}
+		req = next_msg->data;
+		if (nodelist_find(req->nodes, conf->node_name) < 0)
+			continue;
+		debug2("%s: %s for job %u", __func__,
+		       rpc_num2string(next_msg->msg_type), req->job_id);
+		list_remove(itr);
+		slurm_thread_create_detached(NULL, _terminate_job_aggr_thread,
+					     next_msg);
+	}
+	list_iterator_destroy(itr);
+}
+
 static void
 _rpc_terminate_job(slurm_msg_t *msg)
 {
@@ -78,6 +78,42 @@ static partition_info_msg_t *part_info_msg = NULL;
  * Global Print Functions
  *****************************************************************************/
 
+uint32_t job_format_skip_fields(List format)
+{
+	uint32_t skip_fields = JOB_FIELD_COMMENT | JOB_FIELD_COMMAND |
+			       JOB_FIELD_STD_IO | JOB_FIELD_NODE_INX |
+			       JOB_FIELD_TRES_FMT;
+	ListIterator iter;
+	job_format_t *current;
+
+	iter = list_iterator_create(format);
+	while ((current = list_next(iter))) {
+		if ((current->function == _print_job_admin_comment) ||
+		    (current->function == _print_job_comment) ||
+		    (current->function == _print_job_system_comment))
+			skip_fields &= (~JOB_FIELD_COMMENT);
+		else if ((current->function == _print_job_command) ||
+			 (current->function == _print_job_work_dir))
+			skip_fields &= (~JOB_FIELD_COMMAND);
+		else if (current->function == _print_job_std_in)
+			skip_fields &= (~JOB_FIELD_STD_IO);
+		else if ((current->function == _print_job_std_err) ||
+			 (current->function == _print_job_std_out))
+			/* default path is built from work_dir */
+			skip_fields &= (~(JOB_FIELD_STD_IO |
+					  JOB_FIELD_COMMAND));
+		else if ((current->function == _print_job_node_inx) ||
+			 (current->function == _print_job_req_node_inx) ||
+			 (current->function == _print_job_exc_node_inx))
+			skip_fields &= (~JOB_FIELD_NODE_INX);
+		else if (current->function == _print_job_tres_alloc)
+			skip_fields &= (~JOB_FIELD_TRES_FMT);
+	}
+	list_iterator_destroy(iter);
+
+	return skip_fields;
+}
+
 int print_jobs_array(job_info_t * jobs, int size, List format)
 {
 	squeue_job_rec_t *job_rec_ptr;
@@ -77,6 +77,9 @@ int print_steps_list(List steps, List format);
 int print_jobs_array(job_info_t * jobs, int size, List format);
 int print_steps_array(job_step_info_t * steps, int size, List format);
 
+/* Return the JOB_FIELD_* groups not needed to print the given format */
+uint32_t job_format_skip_fields(List format);
+
 /*****************************************************************************
  * Job Line Format Options
  *****************************************************************************/
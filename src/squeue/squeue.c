@@ -168,6 +168,7 @@ static int
 _print_job ( bool clear_old )
 {
 	static job_info_msg_t *old_job_ptr;
+	static job_info_filter_t *filter = NULL;
 	job_info_msg_t *new_job_ptr = NULL;
 	int error_code;
 	uint16_t show_flags = 0;
@@ -185,6 +186,39 @@ _print_job ( bool clear_old )
 	if (params.format && strstr(params.format, "C"))
 		show_flags |= SHOW_DETAIL;
 
+	if (!params.format && !params.format_long) {
+		if (params.long_list) {
+			xstrcat(params.format,
+				"%.18i %.9P %.8j %.8u %.8T %.10M %.9l %.6D %R");
+		} else {
+			xstrcat(params.format,
+				"%.18i %.9P %.8j %.8u %.2t %.10M %.6D %R");
+		}
+	}
+
+	if (!params.format_list) {
+		if (params.format)
+			parse_format(params.format);
+		else if (params.format_long)
+			parse_long_format(params.format_long);
+	}
+
+	/*
+	 * Let slurmctld skip the jobs and fields we would not print. Jobs are
+	 * still filtered by print_jobs_array() as the controller may be older
+	 * or match more loosely (e.g. case insensitive partition names).
+	 */
+	if (!filter) {
+		filter = xmalloc(sizeof(job_info_filter_t));
+		filter->account_list = params.account_list;
+		filter->name_list = params.name_list;
+		filter->part_list = params.part_list;
+		filter->skip_fields = job_format_skip_fields(
+						params.format_list);
+		filter->state_list = params.state_list;
+		filter->user_list = params.user_list;
+	}
+
 	if (old_job_ptr) {
 		if (clear_old)
 			old_job_ptr->last_update = 0;
@@ -199,9 +233,9 @@ _print_job ( bool clear_old )
 		} else {
 			if (params.clusters)
 				show_flags |= SHOW_LOCAL;
-			error_code = slurm_load_jobs(
+			error_code = slurm_load_jobs_filter(
 				old_job_ptr->last_update,
-				&new_job_ptr, show_flags);
+				&new_job_ptr, show_flags, filter);
 		}
 		if (error_code ==  SLURM_SUCCESS)
 			slurm_free_job_info_msg( old_job_ptr );
@@ -216,8 +250,9 @@ _print_job ( bool clear_old )
 		error_code = slurm_load_job_user(&new_job_ptr, params.user_id,
 						 show_flags);
 	} else {
-		error_code = slurm_load_jobs((time_t) NULL, &new_job_ptr,
-					     show_flags);
+		error_code = slurm_load_jobs_filter((time_t) NULL,
+						    &new_job_ptr, show_flags,
+						    filter);
 	}
 
 	if (error_code) {
@@ -234,23 +269,6 @@ _print_job ( bool clear_old )
 			new_job_ptr->record_count);
 	}
 
-	if (!params.format && !params.format_long) {
-		if (params.long_list) {
-			xstrcat(params.format,
-				"%.18i %.9P %.8j %.8u %.8T %.10M %.9l %.6D %R");
-		} else {
-			xstrcat(params.format,
-				"%.18i %.9P %.8j %.8u %.2t %.10M %.6D %R");
-		}
-	}
-
-	if (!params.format_list) {
-		if (params.format)
-			parse_format(params.format);
-		else if (params.format_long)
-			parse_long_format(params.format_long);
-	}
-
 	print_jobs_array(new_job_ptr->job_array, new_job_ptr->record_count,
 			 params.format_list) ;
 	return SLURM_SUCCESS;
@@ -0,0 +1,85 @@
+/* Microbenchmark of src/common/bitstring.c bitmap kernels
+ *
+ * Reports nanoseconds per call of the bitmap operations used most by node
+ * and core selection, for each set of kernels this CPU supports.
+ * Usage: bitstring-bench [bits [iterations]]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <src/common/bitstring.h>
+
+static double _now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1e9) + ts.tv_nsec;
+}
+
+#define BENCH(_op) do {						\
+	double _start = _now();					\
+	for (i = 0; i < iters; i++) {				\
+		_op;						\
+	}							\
+	printf(" %12.1f", (_now() - _start) / iters);		\
+} while (0)
+
+int
+main(int argc, char *argv[])
+{
+	char *names[] = { "generic", "sse4.2", "avx2", "avx512", NULL };
+	int bits = 16384, iters = 100000;
+	int i, k, bit;
+	volatile int64_t sink = 0;
+	bitstr_t *b1, *b2, *b3, *sparse;
+
+	if (argc > 1)
+		bits = atoi(argv[1]);
+	if (argc > 2)
+		iters = atoi(argv[2]);
+	if ((bits <= 0) || (iters <= 0)) {
+		fprintf(stderr, "Usage: %s [bits [iterations]]\n", argv[0]);
+		exit(1);
+	}
+
+	b1 = bit_alloc(bits);
+	b2 = bit_alloc(bits);
+	b3 = bit_alloc(bits);
+	sparse = bit_alloc(bits);
+	srandom(1);
+	for (bit = 0; bit < bits; bit++) {
+		if (random() % 2)
+			bit_set(b1, bit);
+		if (random() % 2)
+			bit_set(b2, bit);
+	}
+	/* Searches that must scan the whole bitmap */
+	bit_set(sparse, bits - 1);
+
+	printf("%d bits, %d iterations, nsec per call\n", bits, iters);
+	printf("%-8s %12s %12s %12s %12s %12s %12s %12s %12s\n", "kernels",
+	       "and", "and_not", "or", "set_count", "overlap", "overlap_any",
+	       "ffs", "and_not_ffs");
+	for (k = 0; names[k]; k++) {
+		if (bit_simd_set(names[k]) != 0)
+			continue;
+		printf("%-8s", names[k]);
+		bit_copybits(b3, b1);
+		BENCH(bit_and(b3, b2));
+		BENCH(bit_and_not(b3, b2));
+		BENCH(bit_or(b3, b2));
+		BENCH(sink += bit_set_count(b1));
+		BENCH(sink += bit_overlap(b1, b2));
+		BENCH(sink += bit_overlap_any(sparse, sparse));
+		BENCH(sink += bit_ffs(sparse));
+		BENCH(sink += bit_and_not_ffs(sparse, b3));
+		printf("\n");
+	}
+
+	bit_free(b1);
+	bit_free(b2);
+	bit_free(b3);
+	bit_free(sparse);
+	return 0;
+}
@@ -207,6 +207,76 @@ main(int argc, char *argv[])
 		TEST(bit_equal(bs, bs2), "bitstring");
 	}
 
+	note("Testing bitmap kernels");
+	{
+		char *names[] = { "generic", "sse4.2", "avx2", "avx512", NULL };
+		int sizes[] = { 1, 63, 64, 65, 200, 511, 512, 1000, 0 };
+		bitstr_t *b1, *b2, *b3;
+		int i, j, n, bit, count, overlap, ffs, and_not_ffs, super_set;
+
+		TEST(bit_simd_set("bogus") == -1, "unknown kernels");
+		for (i = 0; names[i]; i++) {
+			if (bit_simd_set(names[i]) != 0) {
+				note("kernels not supported by this CPU");
+				continue;
+			}
+			for (j = 0; (n = sizes[j]); j++) {
+				b1 = bit_alloc(n);
+				b2 = bit_alloc(n);
+				for (bit = 0; bit < n; bit++) {
+					if ((random() % 4) == 0)
+						bit_set(b1, bit);
+					if ((random() % 2) == 0)
+						bit_set(b2, bit);
+				}
+				/* Sparse tail to exercise the ffs searches */
+				if (n > 100)
+					bit_nclear(b1, 0, n - 10);
+
+				count = overlap = 0;
+				ffs = and_not_ffs = -1;
+				super_set = 1;
+				for (bit = 0; bit < n; bit++) {
+					if (!bit_test(b1, bit))
+						continue;
+					count++;
+					if (ffs == -1)
+						ffs = bit;
+					if (bit_test(b2, bit))
+						overlap++;
+					else {
+						super_set = 0;
+						if (and_not_ffs == -1)
+							and_not_ffs = bit;
+					}
+				}
+				TEST(bit_set_count(b1) == count, names[i]);
+				TEST(bit_overlap(b1, b2) == overlap, names[i]);
+				TEST(bit_overlap_any(b1, b2) == (overlap > 0),
+				     names[i]);
+				TEST(bit_ffs(b1) == ffs, names[i]);
+				TEST(bit_and_not_ffs(b1, b2) == and_not_ffs,
+				     names[i]);
+				TEST(bit_super_set(b1, b2) == super_set,
+				     names[i]);
+
+				b3 = bit_copy(b1);
+				bit_and(b3, b2);
+				TEST(bit_set_count(b3) == overlap, names[i]);
+				bit_or(b3, b1);
+				TEST(bit_equal(b3, b1), names[i]);
+				bit_and_not(b3, b2);
+				TEST(bit_set_count(b3) == (count - overlap),
+				     names[i]);
+				TEST(bit_ffs(b3) == and_not_ffs, names[i]);
+
+				bit_free(b1);
+				bit_free(b2);
+				bit_free(b3);
+			}
+		}
+	}
+
 	totals();
 	return failed;
 }